@@ -61,6 +61,7 @@ static opl_driver_t *driver = NULL;
 static int init_stage_reg_writes = 1;
 
 unsigned int opl_sample_rate = 22050;
+int opl_offline_render = 0;
 
 //
 // Init/shutdown code.
@@ -197,6 +198,13 @@ void OPL_SetSampleRate(unsigned int rate)
     opl_sample_rate = rate;
 }
 
+// Set whether software OPL emulation is being rendered offline.
+
+void OPL_SetOfflineRender(int offline)
+{
+    opl_offline_render = offline;
+}
+
 void OPL_WritePort(opl_port_t port, unsigned int value)
 {
     if (driver != NULL)
@@ -87,6 +87,11 @@ void OPL_Shutdown(void);
 
 void OPL_SetSampleRate(unsigned int rate);
 
+// Render offline: software emulation blocks the mixer instead of
+// dropping samples when it falls behind.
+
+void OPL_SetOfflineRender(int offline);
+
 // Write to one of the OPL I/O ports:
 
 void OPL_WritePort(opl_port_t port, unsigned int value);
@@ -182,7 +182,6 @@ static const Bit8u ch_slot[18] = {
 // Envelope generator
 //
 
-typedef Bit16s(*envelope_sinfunc)(Bit16u phase, Bit16u envelope);
 typedef void(*envelope_genfunc)(opl3_slot *slott);
 
 static Bit16s OPL3_EnvelopeCalcExp(Bit32u level)
@@ -331,17 +330,6 @@ static Bit16s OPL3_EnvelopeCalcSin7(Bit16u phase, Bit16u envelope)
     return OPL3_EnvelopeCalcExp(out + (envelope << 3)) ^ neg;
 }
 
-static const envelope_sinfunc envelope_sin[8] = {
-    OPL3_EnvelopeCalcSin0,
-    OPL3_EnvelopeCalcSin1,
-    OPL3_EnvelopeCalcSin2,
-    OPL3_EnvelopeCalcSin3,
-    OPL3_EnvelopeCalcSin4,
-    OPL3_EnvelopeCalcSin5,
-    OPL3_EnvelopeCalcSin6,
-    OPL3_EnvelopeCalcSin7
-};
-
 enum envelope_gen_num
 {
     envelope_gen_num_attack = 0,
@@ -664,9 +652,41 @@ static void OPL3_SlotWriteE0(opl3_slot *slot, Bit8u data)
     }
 }
 
-static void OPL3_SlotGenerate(opl3_slot *slot)
+// Dispatch on the waveform with a switch rather than through a function
+// pointer table, so that each waveform is inlined into the slot loop.
+
+static inline void OPL3_SlotGenerate(opl3_slot *slot)
 {
-    slot->out = envelope_sin[slot->reg_wf](slot->pg_phase_out + *slot->mod, slot->eg_out);
+    Bit16u phase = slot->pg_phase_out + *slot->mod;
+    Bit16u envelope = slot->eg_out;
+
+    switch (slot->reg_wf)
+    {
+    case 0:
+        slot->out = OPL3_EnvelopeCalcSin0(phase, envelope);
+        break;
+    case 1:
+        slot->out = OPL3_EnvelopeCalcSin1(phase, envelope);
+        break;
+    case 2:
+        slot->out = OPL3_EnvelopeCalcSin2(phase, envelope);
+        break;
+    case 3:
+        slot->out = OPL3_EnvelopeCalcSin3(phase, envelope);
+        break;
+    case 4:
+        slot->out = OPL3_EnvelopeCalcSin4(phase, envelope);
+        break;
+    case 5:
+        slot->out = OPL3_EnvelopeCalcSin5(phase, envelope);
+        break;
+    case 6:
+        slot->out = OPL3_EnvelopeCalcSin6(phase, envelope);
+        break;
+    default:
+        slot->out = OPL3_EnvelopeCalcSin7(phase, envelope);
+        break;
+    }
 }
 
 static void OPL3_SlotCalcFB(opl3_slot *slot)
@@ -1047,69 +1067,71 @@ static Bit16s OPL3_ClipSample(Bit32s sample)
     return (Bit16s)sample;
 }
 
-void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
+// Run all stages of one slot for one sample.
+
+static inline void OPL3_SlotProcess(opl3_slot *slot)
 {
-    Bit8u ii;
-    Bit8u jj;
+    OPL3_SlotCalcFB(slot);
+    OPL3_EnvelopeCalc(slot);
+    OPL3_PhaseGenerate(slot);
+    OPL3_SlotGenerate(slot);
+}
+
+// Sum the outputs of all channels, masked by the channel's left or right
+// output enable.
+
+static inline Bit32s OPL3_MixChannels(opl3_chip *chip, int right)
+{
+    opl3_channel *channel;
+    Bit32s mix = 0;
     Bit16s accm;
+    Bit8u ii;
+
+    for (ii = 0; ii < 18; ii++)
+    {
+        channel = &chip->channel[ii];
+        accm = *channel->out[0] + *channel->out[1]
+             + *channel->out[2] + *channel->out[3];
+        mix += (Bit16s)(accm & (right ? channel->chb : channel->cha));
+    }
+
+    return mix;
+}
+
+// Generate one sample at the native OPL3 rate.  Inlined into both the
+// single sample and the block entry points.
+
+static inline void OPL3_GenerateSample(opl3_chip *chip, Bit16s *buf)
+{
+    Bit8u ii;
     Bit8u shift = 0;
 
     buf[1] = OPL3_ClipSample(chip->mixbuff[1]);
 
     for (ii = 0; ii < 15; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        OPL3_SlotProcess(&chip->slot[ii]);
     }
 
-    chip->mixbuff[0] = 0;
-    for (ii = 0; ii < 18; ii++)
-    {
-        accm = 0;
-        for (jj = 0; jj < 4; jj++)
-        {
-            accm += *chip->channel[ii].out[jj];
-        }
-        chip->mixbuff[0] += (Bit16s)(accm & chip->channel[ii].cha);
-    }
+    chip->mixbuff[0] = OPL3_MixChannels(chip, 0);
 
     for (ii = 15; ii < 18; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        OPL3_SlotProcess(&chip->slot[ii]);
     }
 
     buf[0] = OPL3_ClipSample(chip->mixbuff[0]);
 
     for (ii = 18; ii < 33; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        OPL3_SlotProcess(&chip->slot[ii]);
     }
 
-    chip->mixbuff[1] = 0;
-    for (ii = 0; ii < 18; ii++)
-    {
-        accm = 0;
-        for (jj = 0; jj < 4; jj++)
-        {
-            accm += *chip->channel[ii].out[jj];
-        }
-        chip->mixbuff[1] += (Bit16s)(accm & chip->channel[ii].chb);
-    }
+    chip->mixbuff[1] = OPL3_MixChannels(chip, 1);
 
     for (ii = 33; ii < 36; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        OPL3_SlotProcess(&chip->slot[ii]);
     }
 
     if ((chip->timer & 0x3f) == 0x3f)
@@ -1179,13 +1201,31 @@ void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
     chip->writebuf_samplecnt++;
 }
 
+void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
+{
+    OPL3_GenerateSample(chip, buf);
+}
+
+// Generate numsamples stereo samples at the native OPL3 rate.
+
+void OPL3_GenerateBlock(opl3_chip *chip, Bit16s *buf, Bit32u numsamples)
+{
+    Bit32u i;
+
+    for (i = 0; i < numsamples; i++)
+    {
+        OPL3_GenerateSample(chip, buf);
+        buf += 2;
+    }
+}
+
 void OPL3_GenerateResampled(opl3_chip *chip, Bit16s *buf)
 {
     while (chip->samplecnt >= chip->rateratio)
     {
         chip->oldsamples[0] = chip->samples[0];
         chip->oldsamples[1] = chip->samples[1];
-        OPL3_Generate(chip, chip->samples);
+        OPL3_GenerateSample(chip, chip->samples);
         chip->samplecnt -= chip->rateratio;
     }
     buf[0] = (Bit16s)((chip->oldsamples[0] * (chip->rateratio - chip->samplecnt)
@@ -1369,13 +1409,183 @@ void OPL3_WriteRegBuffered(opl3_chip *chip, Bit16u reg, Bit8u v)
     chip->writebuf_last = (chip->writebuf_last + 1) % OPL_WRITEBUF_SIZE;
 }
 
+// Resample like OPL3_GenerateResampled, but render the native rate
+// samples a block at a time with OPL3_GenerateBlock.
+
+#define OPL_STREAM_BLOCK 256
+
 void OPL3_GenerateStream(opl3_chip *chip, Bit16s *sndptr, Bit32u numsamples)
 {
-    Bit32u i;
+    Bit16s block[OPL_STREAM_BLOCK * 2];
+    Bit32s samplecnt;
+    Bit32u count, needed, next, i, j;
 
-    for(i = 0; i < numsamples; i++)
+    while (numsamples > 0)
     {
-        OPL3_GenerateResampled(chip, sndptr);
-        sndptr += 2;
+        // Count how many output samples the next block covers.
+
+        samplecnt = chip->samplecnt;
+        count = 0;
+        needed = 0;
+
+        while (count < numsamples)
+        {
+            next = 0;
+
+            while (samplecnt >= chip->rateratio)
+            {
+                samplecnt -= chip->rateratio;
+                next++;
+            }
+
+            if (needed + next > OPL_STREAM_BLOCK)
+            {
+                break;
+            }
+
+            samplecnt += 1 << RSM_FRAC;
+            needed += next;
+            count++;
+        }
+
+        OPL3_GenerateBlock(chip, block, needed);
+
+        for (i = 0, j = 0; i < count; i++)
+        {
+            while (chip->samplecnt >= chip->rateratio)
+            {
+                chip->oldsamples[0] = chip->samples[0];
+                chip->oldsamples[1] = chip->samples[1];
+                chip->samples[0] = block[j * 2];
+                chip->samples[1] = block[j * 2 + 1];
+                chip->samplecnt -= chip->rateratio;
+                j++;
+            }
+            sndptr[0] = (Bit16s)((chip->oldsamples[0] * (chip->rateratio - chip->samplecnt)
+                                + chip->samples[0] * chip->samplecnt) / chip->rateratio);
+            sndptr[1] = (Bit16s)((chip->oldsamples[1] * (chip->rateratio - chip->samplecnt)
+                                + chip->samples[1] * chip->samplecnt) / chip->rateratio);
+            chip->samplecnt += 1 << RSM_FRAC;
+            sndptr += 2;
+        }
+
+        numsamples -= count;
     }
 }
+
+#ifdef TEST
+
+#include <assert.h>
+#include <time.h>
+
+#define TEST_RATE    44100
+#define TEST_SECONDS 60
+
+// Program a chip with notes on all 18 channels, using every waveform,
+// both output sides and 4-op and rhythm modes.
+
+static void TestProgramChip(opl3_chip *chip, unsigned int seed)
+{
+    Bit16u reg;
+    Bit8u ch;
+
+    srand(seed);
+
+    OPL3_WriteReg(chip, 0x105, 0x01);
+    OPL3_WriteReg(chip, 0x104, 0x09);
+    OPL3_WriteReg(chip, 0x01, 0x20);
+    OPL3_WriteReg(chip, 0xbd, 0xe0 | (rand() & 0x1f));
+
+    for (reg = 0x20; reg < 0xa0; ++reg)
+    {
+        OPL3_WriteReg(chip, reg, rand() & 0xff);
+        OPL3_WriteReg(chip, reg | 0x100, rand() & 0xff);
+    }
+
+    for (reg = 0xe0; reg < 0xf6; ++reg)
+    {
+        OPL3_WriteReg(chip, reg, rand() & 0x07);
+        OPL3_WriteReg(chip, reg | 0x100, rand() & 0x07);
+    }
+
+    for (ch = 0; ch < 9; ++ch)
+    {
+        OPL3_WriteReg(chip, 0xc0 + ch, 0x30 | (rand() & 0x0f));
+        OPL3_WriteReg(chip, 0x1c0 + ch, 0x30 | (rand() & 0x0f));
+        OPL3_WriteReg(chip, 0xa0 + ch, rand() & 0xff);
+        OPL3_WriteReg(chip, 0x1a0 + ch, rand() & 0xff);
+        OPL3_WriteReg(chip, 0xb0 + ch, 0x20 | (rand() & 0x1f));
+        OPL3_WriteReg(chip, 0x1b0 + ch, 0x20 | (rand() & 0x1f));
+    }
+}
+
+int main(void)
+{
+    static opl3_chip chip1, chip2;
+    Bit16s *block;
+    Bit16s sample[2];
+    unsigned int numsamples;
+    unsigned int i;
+    clock_t start;
+    double seconds;
+
+    // Block generation must match sample by sample generation.
+
+    OPL3_Reset(&chip1, 49716);
+    OPL3_Reset(&chip2, 49716);
+    TestProgramChip(&chip1, 1);
+    TestProgramChip(&chip2, 1);
+
+    numsamples = 49716 * 5;
+    block = malloc(numsamples * 4);
+    OPL3_GenerateBlock(&chip1, block, numsamples);
+
+    for (i = 0; i < numsamples; ++i)
+    {
+        OPL3_Generate(&chip2, sample);
+        assert(sample[0] == block[i * 2] && sample[1] == block[i * 2 + 1]);
+    }
+
+    free(block);
+
+    // The block based stream must match the per-sample resampler.
+
+    numsamples = TEST_RATE * 5;
+    block = malloc(numsamples * 4);
+
+    OPL3_Reset(&chip1, TEST_RATE);
+    OPL3_Reset(&chip2, TEST_RATE);
+    TestProgramChip(&chip1, 3);
+    TestProgramChip(&chip2, 3);
+    OPL3_GenerateStream(&chip1, block, numsamples);
+
+    for (i = 0; i < numsamples; ++i)
+    {
+        OPL3_GenerateResampled(&chip2, sample);
+        assert(sample[0] == block[i * 2] && sample[1] == block[i * 2 + 1]);
+    }
+
+    free(block);
+
+    // Throughput of the resampled stream used by the SDL driver.
+
+    numsamples = TEST_RATE * TEST_SECONDS;
+    block = malloc(numsamples * 4);
+
+    OPL3_Reset(&chip1, TEST_RATE);
+    TestProgramChip(&chip1, 2);
+
+    start = clock();
+    OPL3_GenerateStream(&chip1, block, numsamples);
+    seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    printf("OPL3: %u samples in %.3f s (%.0f samples/sec, %.1fx realtime)\n",
+           numsamples, seconds, numsamples / seconds,
+           TEST_SECONDS / seconds);
+
+    free(block);
+
+    return 0;
+}
+
+#endif
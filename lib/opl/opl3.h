@@ -145,6 +145,7 @@ struct _opl3_chip {
 };
 
 void OPL3_Generate(opl3_chip *chip, Bit16s *buf);
+void OPL3_GenerateBlock(opl3_chip *chip, Bit16s *buf, Bit32u numsamples);
 void OPL3_GenerateResampled(opl3_chip *chip, Bit16s *buf);
 void OPL3_Reset(opl3_chip *chip, Bit32u samplerate);
 void OPL3_WriteReg(opl3_chip *chip, Bit16u reg, Bit8u v);
@@ -55,3 +55,7 @@ typedef struct
 // Sample rate to use when doing software emulation.
 
 extern unsigned int opl_sample_rate;
+
+// If non-zero, the mixer waits for software emulation to catch up.
+
+extern int opl_offline_render;
@@ -16,6 +16,7 @@
 // DESCRIPTION:
 //     Queue of waiting callbacks, stored in a binary min heap, so that we
 //     can always get the first callback.
+//     Lock-free single producer, single consumer queue of register writes.
 //
 
 
@@ -24,10 +25,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "SDL.h"
+
 #include "opl_queue.h"
 
 #define MAX_OPL_QUEUE 64
 
+// Must be a power of two.
+#define MAX_OPL_REG_QUEUE 1024
+
 typedef struct
 {
     opl_callback_t callback;
@@ -218,6 +224,118 @@ void OPL_Queue_AdjustCallbacks(opl_callback_queue_t *queue,
     }
 }
 
+//
+// Register write queue.
+//
+
+typedef struct
+{
+    uint16_t reg;
+    uint8_t value;
+    unsigned int time;
+} opl_reg_entry_t;
+
+struct opl_register_queue_s
+{
+    opl_reg_entry_t entries[MAX_OPL_REG_QUEUE];
+
+    // Total number of entries ever pushed and popped.  Only the producer
+    // updates head and only the consumer updates tail.
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+};
+
+opl_register_queue_t *OPL_RegQueue_Create(void)
+{
+    opl_register_queue_t *queue;
+
+    queue = malloc(sizeof(opl_register_queue_t));
+    SDL_AtomicSet(&queue->head, 0);
+    SDL_AtomicSet(&queue->tail, 0);
+
+    return queue;
+}
+
+void OPL_RegQueue_Destroy(opl_register_queue_t *queue)
+{
+    free(queue);
+}
+
+// Returns zero if the queue is full.
+
+int OPL_RegQueue_Push(opl_register_queue_t *queue,
+                      unsigned int reg, unsigned int value,
+                      unsigned int time)
+{
+    unsigned int head, tail;
+    opl_reg_entry_t *entry;
+
+    head = (unsigned int) SDL_AtomicGet(&queue->head);
+    tail = (unsigned int) SDL_AtomicGet(&queue->tail);
+
+    if (head - tail >= MAX_OPL_REG_QUEUE)
+    {
+        return 0;
+    }
+
+    entry = &queue->entries[head & (MAX_OPL_REG_QUEUE - 1)];
+    entry->reg = reg;
+    entry->value = value;
+    entry->time = time;
+
+    // SDL_AtomicSet is a full memory barrier, so the entry is visible
+    // to the consumer before the new head is.
+
+    SDL_AtomicSet(&queue->head, (int) (head + 1));
+
+    return 1;
+}
+
+// Returns zero if the queue is empty.
+
+int OPL_RegQueue_Pop(opl_register_queue_t *queue,
+                     unsigned int *reg, unsigned int *value)
+{
+    unsigned int head, tail;
+    opl_reg_entry_t *entry;
+
+    tail = (unsigned int) SDL_AtomicGet(&queue->tail);
+    head = (unsigned int) SDL_AtomicGet(&queue->head);
+
+    if (head == tail)
+    {
+        return 0;
+    }
+
+    entry = &queue->entries[tail & (MAX_OPL_REG_QUEUE - 1)];
+    *reg = entry->reg;
+    *value = entry->value;
+
+    SDL_AtomicSet(&queue->tail, (int) (tail + 1));
+
+    return 1;
+}
+
+// Returns zero if the queue is empty, otherwise sets time to the time
+// of the next entry to be popped.
+
+int OPL_RegQueue_Peek(opl_register_queue_t *queue, unsigned int *time)
+{
+    unsigned int head, tail;
+
+    tail = (unsigned int) SDL_AtomicGet(&queue->tail);
+    head = (unsigned int) SDL_AtomicGet(&queue->head);
+
+    if (head == tail)
+    {
+        return 0;
+    }
+
+    *time = queue->entries[tail & (MAX_OPL_REG_QUEUE - 1)].time;
+
+    return 1;
+}
+
 #ifdef TEST
 
 #include <assert.h>
@@ -247,7 +365,67 @@ static void PrintQueue(opl_callback_queue_t *queue)
     PrintQueueNode(queue, 0, 0);
 }
 
-int main()
+// Stress test for the register queue: one thread pushes a known
+// sequence of writes while the main thread pops and checks them.
+
+#define REG_STRESS_WRITES 10000000
+
+static int RegQueueProducer(void *data)
+{
+    opl_register_queue_t *queue = data;
+    unsigned int i;
+
+    for (i=0; i<REG_STRESS_WRITES; ++i)
+    {
+        while (!OPL_RegQueue_Push(queue, i & 0x1ff, i & 0xff, i))
+        {
+            SDL_Delay(0);
+        }
+    }
+
+    return 0;
+}
+
+static void RegQueueStress(void)
+{
+    opl_register_queue_t *queue;
+    SDL_Thread *thread;
+    unsigned int reg, value, time;
+    unsigned int i;
+    Uint64 start, ticks;
+
+    queue = OPL_RegQueue_Create();
+    start = SDL_GetPerformanceCounter();
+
+    thread = SDL_CreateThread(RegQueueProducer, "OPL queue test", queue);
+
+    for (i=0; i<REG_STRESS_WRITES; ++i)
+    {
+        while (!OPL_RegQueue_Peek(queue, &time))
+        {
+            SDL_Delay(0);
+        }
+
+        assert(time == i);
+        assert(OPL_RegQueue_Pop(queue, &reg, &value));
+
+        assert(reg == (i & 0x1ff));
+        assert(value == (i & 0xff));
+    }
+
+    SDL_WaitThread(thread, NULL);
+    ticks = SDL_GetPerformanceCounter() - start;
+
+    assert(!OPL_RegQueue_Pop(queue, &reg, &value));
+    OPL_RegQueue_Destroy(queue);
+
+    printf("Register queue: %u writes in %.3f s (%.0f writes/sec)\n",
+           REG_STRESS_WRITES,
+           (double) ticks / SDL_GetPerformanceFrequency(),
+           REG_STRESS_WRITES * (double) SDL_GetPerformanceFrequency() / ticks);
+}
+
+int main(int argc, char *argv[])
 {
     opl_callback_queue_t *queue;
     int iteration;
@@ -283,6 +461,10 @@ int main()
         assert(OPL_Queue_IsEmpty(queue));
         assert(!OPL_Queue_Pop(queue, &callback, &data));
     }
+
+    RegQueueStress();
+
+    return 0;
 }
 
 #endif
@@ -14,7 +14,7 @@
 // GNU General Public License for more details.
 //
 // DESCRIPTION:
-//     OPL callback queue.
+//     OPL callback queue and register write queue.
 //
 
 
@@ -37,3 +37,20 @@ int OPL_Queue_Pop(opl_callback_queue_t *queue,
 uint64_t OPL_Queue_Peek(opl_callback_queue_t *queue);
 void OPL_Queue_AdjustCallbacks(opl_callback_queue_t *queue,
                                uint64_t time, float factor);
+
+// Lock-free queue of register writes.  Used to hand writes made by the
+// game thread over to the thread that owns the software emulator.
+// Only one thread may push and only one thread may pop at a time.
+// Each write carries the time, in output frames, it is meant to reach
+// the emulator at.
+
+typedef struct opl_register_queue_s opl_register_queue_t;
+
+opl_register_queue_t *OPL_RegQueue_Create(void);
+void OPL_RegQueue_Destroy(opl_register_queue_t *queue);
+int OPL_RegQueue_Push(opl_register_queue_t *queue,
+                      unsigned int reg, unsigned int value,
+                      unsigned int time);
+int OPL_RegQueue_Pop(opl_register_queue_t *queue,
+                     unsigned int *reg, unsigned int *value);
+int OPL_RegQueue_Peek(opl_register_queue_t *queue, unsigned int *time);
@@ -70,14 +70,68 @@ static int opl_sdl_paused;
 
 static uint64_t pause_offset;
 
-// OPL software emulator structure.
+// OPL software emulator structure.  Only the synthesis thread touches
+// the chip once it is running; register writes made by other threads
+// are passed to it through register_queue.
 
 static opl3_chip opl_chip;
 static int opl_opl3mode;
 
-// Temporary mixing buffer used by the mixing callback.
+static opl_register_queue_t *register_queue;
 
-static uint8_t *mix_buffer = NULL;
+// Writes made by the control thread while the register queue is full.
+// The control thread may hold callback_mutex through OPL_Lock(), and the
+// synthesis thread may be waiting for it in AdvanceTime(), so waiting for
+// room could deadlock.  They are kept here instead, moved to the queue
+// when it has room or applied by the synthesis thread.  Only accessed
+// while holding callback_mutex.
+
+typedef struct
+{
+    unsigned int reg;
+    unsigned int value;
+    unsigned int time;
+} opl_pending_write_t;
+
+static opl_pending_write_t *pending_writes = NULL;
+static unsigned int num_pending_writes, pending_writes_alloced;
+
+// Thread that runs the emulator ahead of the mixer.
+
+static SDL_Thread *synth_thread = NULL;
+static SDL_threadID synth_thread_id;
+static SDL_atomic_t synth_thread_quit;
+
+// Posted by the mixer every time samples are consumed, to wake up the
+// synthesis thread.
+
+static SDL_sem *synth_sem = NULL;
+
+// Ring buffer of rendered samples (16 bits * 2 channels per frame).
+// ring_write and ring_read count frames ever written and read; the
+// synthesis thread advances ring_write and the mixer advances ring_read.
+// ring_size is a power of two.
+
+static Bit16s *ring_buffer = NULL;
+static unsigned int ring_size;
+static SDL_atomic_t ring_write;
+static SDL_atomic_t ring_read;
+
+// Number of frames the synthesis thread tries to keep buffered.  Set to
+// twice the size of the last chunk requested by the mixer.
+
+static SDL_atomic_t ring_target;
+
+// SDL_GetTicks() when the mixer last consumed samples.
+
+static SDL_atomic_t mix_ticks;
+
+// Statistics, printed on shutdown if the OPL_STATS environment variable
+// is set.
+
+static uint64_t stats_samples;
+static uint64_t stats_synth_ticks;
+static SDL_atomic_t stats_underruns;
 
 // Register number that was written.
 
@@ -102,6 +156,55 @@ static int SDLIsInitialized(void)
     return Mix_QuerySpec(&freq, &format, &channels);
 }
 
+// Apply register writes queued by other threads that are due by the
+// given frame, or all of them if all is non-zero.
+
+static void DrainRegisterQueue(unsigned int pos, int all)
+{
+    unsigned int reg, value, time;
+
+    while (OPL_RegQueue_Peek(register_queue, &time)
+        && (all || (int) (time - pos) <= 0))
+    {
+        OPL_RegQueue_Pop(register_queue, &reg, &value);
+        OPL3_WriteRegBuffered(&opl_chip, reg, value);
+    }
+}
+
+// Apply the queued writes and those that did not fit in the queue,
+// which come after them.  Must be called with callback_mutex held.
+
+static void DrainAllWrites(void)
+{
+    unsigned int i;
+
+    DrainRegisterQueue(0, 1);
+
+    for (i = 0; i < num_pending_writes; ++i)
+    {
+        OPL3_WriteRegBuffered(&opl_chip, pending_writes[i].reg,
+                              pending_writes[i].value);
+    }
+
+    num_pending_writes = 0;
+}
+
+// Apply the writes that did not fit in the queue, unless the control
+// thread is holding callback_mutex.
+
+static void TryDrainPendingWrites(void)
+{
+    if (SDL_TryLockMutex(callback_mutex) == 0)
+    {
+        if (num_pending_writes > 0)
+        {
+            DrainAllWrites();
+        }
+
+        SDL_UnlockMutex(callback_mutex);
+    }
+}
+
 // Advance time by the specified number of samples, invoking any
 // callback functions as appropriate.
 
@@ -146,6 +249,12 @@ static void AdvanceTime(unsigned int nsamples)
         SDL_UnlockMutex(callback_queue_mutex);
 
         SDL_LockMutex(callback_mutex);
+
+        // Writes queued by the control thread inside OPL_Lock() must
+        // reach the chip before anything the callback writes, even
+        // those queued for a later frame.
+
+        DrainAllWrites();
         callback(callback_data);
         SDL_UnlockMutex(callback_mutex);
 
@@ -155,39 +264,61 @@ static void AdvanceTime(unsigned int nsamples)
     SDL_UnlockMutex(callback_queue_mutex);
 }
 
-// Call the OPL emulator code to fill the specified buffer.
+// Call the OPL emulator code to append the specified number of frames
+// to the ring buffer.
 
-static void FillBuffer(uint8_t *buffer, unsigned int nsamples)
+static void FillBuffer(unsigned int nsamples)
 {
-    // This seems like a reasonable assumption.  mix_buffer is
-    // 1 second long, which should always be much longer than the
-    // SDL mix buffer.
-    assert(nsamples < mixing_freq);
-
-    // OPL output is generated into temporary buffer and then mixed
-    // (to avoid overflows etc.)
-    OPL3_GenerateStream(&opl_chip, (Bit16s *) mix_buffer, nsamples);
-    SDL_MixAudioFormat(buffer, mix_buffer, AUDIO_S16SYS, nsamples * 4,
-                       SDL_MIX_MAXVOLUME);
+    unsigned int pos, chunk;
+    Uint64 start;
+
+    start = SDL_GetPerformanceCounter();
+    pos = (unsigned int) SDL_AtomicGet(&ring_write);
+
+    while (nsamples > 0)
+    {
+        chunk = ring_size - (pos & (ring_size - 1));
+
+        if (chunk > nsamples)
+        {
+            chunk = nsamples;
+        }
+
+        OPL3_GenerateStream(&opl_chip,
+                            ring_buffer + (pos & (ring_size - 1)) * 2, chunk);
+        pos += chunk;
+        nsamples -= chunk;
+        stats_samples += chunk;
+
+        // Publish the samples to the mixer.
+
+        SDL_AtomicSet(&ring_write, (int) pos);
+    }
+
+    stats_synth_ticks += SDL_GetPerformanceCounter() - start;
 }
 
-// Callback function to fill a new sound buffer:
+// Render the specified number of frames, invoking callbacks at the
+// appropriate points in time.
 
-static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
+static void RenderSamples(unsigned int buffer_samples)
 {
-    unsigned int filled, buffer_samples;
-    Uint8 *buffer = (Uint8*)stream;
+    unsigned int filled, pos, time;
 
-    // Repeatedly call the OPL emulator update function until the buffer is
-    // full.
     filled = 0;
-    buffer_samples = len / 4;
 
     while (filled < buffer_samples)
     {
         uint64_t next_callback_time;
         uint64_t nsamples;
 
+        // Apply the writes due by now, and stop at the next one so it
+        // reaches the chip on the frame it was queued for.
+
+        TryDrainPendingWrites();
+        pos = (unsigned int) SDL_AtomicGet(&ring_write);
+        DrainRegisterQueue(pos, 0);
+
         SDL_LockMutex(callback_queue_mutex);
 
         // Work out the time until the next callback waiting in
@@ -213,9 +344,14 @@ static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
 
         SDL_UnlockMutex(callback_queue_mutex);
 
+        if (OPL_RegQueue_Peek(register_queue, &time) && time - pos < nsamples)
+        {
+            nsamples = time - pos;
+        }
+
         // Add emulator output to buffer.
 
-        FillBuffer(buffer + filled * 4, nsamples);
+        FillBuffer(nsamples);
         filled += nsamples;
 
         // Invoke callbacks for this point in time.
@@ -224,19 +360,167 @@ static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
     }
 }
 
+// Synthesis thread: keep the ring buffer filled up to ring_target
+// frames ahead of the mixer.
+
+static int SynthThread(void *unused)
+{
+    unsigned int buffered, target;
+
+    synth_thread_id = SDL_ThreadID();
+
+    while (!SDL_AtomicGet(&synth_thread_quit))
+    {
+        buffered = (unsigned int) SDL_AtomicGet(&ring_write)
+                 - (unsigned int) SDL_AtomicGet(&ring_read);
+        target = (unsigned int) SDL_AtomicGet(&ring_target);
+
+        if (buffered >= target)
+        {
+            // Nothing to render; still apply register writes.  Writes
+            // are never queued past what is rendered here.
+
+            TryDrainPendingWrites();
+            DrainRegisterQueue((unsigned int) SDL_AtomicGet(&ring_write), 0);
+            SDL_SemWaitTimeout(synth_sem, 10);
+            continue;
+        }
+
+        RenderSamples(target - buffered);
+    }
+
+    return 0;
+}
+
+// Callback function to fill a new sound buffer:
+
+static void OPL_Mix_Callback(int chan, void *stream, int len, void *udata)
+{
+    unsigned int buffer_samples, available, nsamples;
+    unsigned int pos, chunk;
+    Uint8 *buffer = (Uint8*)stream;
+
+    buffer_samples = len / 4;
+
+    // Ask the synthesis thread to stay two mixer chunks ahead.
+
+    SDL_AtomicSet(&ring_target, (int) SDL_min(buffer_samples * 2, ring_size));
+
+    pos = (unsigned int) SDL_AtomicGet(&ring_read);
+    available = (unsigned int) SDL_AtomicGet(&ring_write) - pos;
+
+    // When rendering offline there is no deadline to meet, so wait for
+    // the synthesis thread rather than drop samples.
+
+    while (opl_offline_render
+        && available < SDL_min(buffer_samples, ring_size)
+        && !SDL_AtomicGet(&synth_thread_quit))
+    {
+        SDL_SemPost(synth_sem);
+        SDL_Delay(1);
+        available = (unsigned int) SDL_AtomicGet(&ring_write) - pos;
+    }
+
+    nsamples = buffer_samples;
+
+    if (available < nsamples)
+    {
+        nsamples = available;
+        SDL_AtomicIncRef(&stats_underruns);
+    }
+
+    // Mix the rendered samples into the output (to avoid overflows etc.)
+
+    while (nsamples > 0)
+    {
+        chunk = ring_size - (pos & (ring_size - 1));
+
+        if (chunk > nsamples)
+        {
+            chunk = nsamples;
+        }
+
+        SDL_MixAudioFormat(buffer,
+                           (Uint8 *) (ring_buffer + (pos & (ring_size - 1)) * 2),
+                           AUDIO_S16SYS, chunk * 4, SDL_MIX_MAXVOLUME);
+        buffer += chunk * 4;
+        pos += chunk;
+        nsamples -= chunk;
+    }
+
+    SDL_AtomicSet(&ring_read, (int) pos);
+    SDL_AtomicSet(&mix_ticks, (int) SDL_GetTicks());
+    SDL_SemPost(synth_sem);
+}
+
+static void StopSynthThread(void)
+{
+    if (synth_thread != NULL)
+    {
+        SDL_AtomicSet(&synth_thread_quit, 1);
+        SDL_SemPost(synth_sem);
+        SDL_WaitThread(synth_thread, NULL);
+        synth_thread = NULL;
+        synth_thread_id = 0;
+    }
+}
+
+static void PrintStats(void)
+{
+    if (getenv("OPL_STATS") == NULL || stats_synth_ticks == 0)
+    {
+        return;
+    }
+
+    printf("OPL_SDL: %" PRIu64 " samples rendered, %.0f samples/sec, "
+           "%i underruns.\n",
+           stats_samples,
+           (double) stats_samples * SDL_GetPerformanceFrequency()
+                                  / stats_synth_ticks,
+           SDL_AtomicGet(&stats_underruns));
+}
+
 static void OPL_SDL_Shutdown(void)
 {
     Mix_HookMusic(NULL, NULL);
+    Mix_UnregisterEffect(MIX_CHANNEL_POST, OPL_Mix_Callback);
+
+    StopSynthThread();
+    PrintStats();
 
     if (sdl_was_initialized)
     {
         Mix_CloseAudio();
         SDL_QuitSubSystem(SDL_INIT_AUDIO);
-        OPL_Queue_Destroy(callback_queue);
-        free(mix_buffer);
         sdl_was_initialized = 0;
     }
 
+    if (callback_queue != NULL)
+    {
+        OPL_Queue_Destroy(callback_queue);
+        callback_queue = NULL;
+    }
+
+    if (register_queue != NULL)
+    {
+        OPL_RegQueue_Destroy(register_queue);
+        register_queue = NULL;
+    }
+
+    free(pending_writes);
+    pending_writes = NULL;
+    num_pending_writes = 0;
+    pending_writes_alloced = 0;
+
+    if (synth_sem != NULL)
+    {
+        SDL_DestroySemaphore(synth_sem);
+        synth_sem = NULL;
+    }
+
+    free(ring_buffer);
+    ring_buffer = NULL;
+
 /*
     if (opl_chip != NULL)
     {
@@ -339,8 +623,24 @@ static int OPL_SDL_Init(unsigned int port_base)
         return 0;
     }
 
-    // Mix buffer: four bytes per sample (16 bits * 2 channels):
-    mix_buffer = malloc(mixing_freq * 4);
+    // Ring buffer: four bytes per sample (16 bits * 2 channels), large
+    // enough for two of the longest mixer slices.
+
+    ring_size = 1;
+
+    while (ring_size < (mixing_freq * 2 * MAX_SOUND_SLICE_TIME) / 1000)
+    {
+        ring_size <<= 1;
+    }
+
+    ring_buffer = malloc(ring_size * 4);
+    SDL_AtomicSet(&ring_write, 0);
+    SDL_AtomicSet(&ring_read, 0);
+    SDL_AtomicSet(&ring_target, (int) (ring_size / 2));
+
+    stats_samples = 0;
+    stats_synth_ticks = 0;
+    SDL_AtomicSet(&stats_underruns, 0);
 
     // Create the emulator structure:
 
@@ -349,6 +649,22 @@ static int OPL_SDL_Init(unsigned int port_base)
 
     callback_mutex = SDL_CreateMutex();
     callback_queue_mutex = SDL_CreateMutex();
+    register_queue = OPL_RegQueue_Create();
+    synth_sem = SDL_CreateSemaphore(0);
+
+    // Start the thread that renders ahead of the mixer.
+
+    SDL_AtomicSet(&synth_thread_quit, 0);
+    synth_thread = SDL_CreateThread(SynthThread, "OPL synthesis thread", NULL);
+
+    if (synth_thread == NULL)
+    {
+        fprintf(stderr, "OPL_SDL: Failed to create synthesis thread: %s\n",
+                SDL_GetError());
+
+        OPL_SDL_Shutdown();
+        return 0;
+    }
 
     // Set postmix that adds the OPL music. This is deliberately done
     // as a postmix and not using Mix_HookMusic() as the latter disables
@@ -397,6 +713,83 @@ static void OPLTimer_CalculateEndTime(opl_timer_t *timer)
     }
 }
 
+// Frame at which a write made by the control thread now should reach
+// the chip: the frame being played, plus one mixer chunk, as when the
+// chip was run from the mixer callback.  It is never past the frames
+// the synthesis thread keeps rendered, so it is always reached.
+
+static unsigned int WriteTime(void)
+{
+    unsigned int chunk, elapsed;
+
+    chunk = (unsigned int) SDL_AtomicGet(&ring_target) / 2;
+    elapsed = 0;
+
+    if (!opl_offline_render)
+    {
+        elapsed = SDL_GetTicks() - (Uint32) SDL_AtomicGet(&mix_ticks);
+        elapsed = SDL_min(elapsed, 1000) * mixing_freq / 1000;
+    }
+
+    return (unsigned int) SDL_AtomicGet(&ring_read)
+         + SDL_min(elapsed, chunk) + chunk;
+}
+
+// Move writes that did not fit in the register queue to it, in order,
+// as far as there is room.  Must be called with callback_mutex held.
+
+static void FlushPendingWrites(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < num_pending_writes; ++i)
+    {
+        if (!OPL_RegQueue_Push(register_queue, pending_writes[i].reg,
+                               pending_writes[i].value,
+                               pending_writes[i].time))
+        {
+            break;
+        }
+    }
+
+    memmove(pending_writes, pending_writes + i,
+            (num_pending_writes - i) * sizeof(*pending_writes));
+    num_pending_writes -= i;
+}
+
+static void QueueWrite(unsigned int reg_num, unsigned int value)
+{
+    const unsigned int time = WriteTime();
+
+    // callback_mutex is recursive, so this is fine inside OPL_Lock().
+
+    SDL_LockMutex(callback_mutex);
+
+    FlushPendingWrites();
+
+    if (num_pending_writes > 0
+     || !OPL_RegQueue_Push(register_queue, reg_num, value, time))
+    {
+        if (num_pending_writes == pending_writes_alloced)
+        {
+            pending_writes_alloced = pending_writes_alloced ?
+                                     pending_writes_alloced * 2 : 256;
+            pending_writes = realloc(pending_writes,
+                                     pending_writes_alloced
+                                   * sizeof(*pending_writes));
+        }
+
+        pending_writes[num_pending_writes].reg = reg_num;
+        pending_writes[num_pending_writes].value = value;
+        pending_writes[num_pending_writes].time = time;
+        ++num_pending_writes;
+
+        SDL_SemPost(synth_sem);
+    }
+
+    SDL_UnlockMutex(callback_mutex);
+}
+
 static void WriteRegister(unsigned int reg_num, unsigned int value)
 {
     switch (reg_num)
@@ -438,7 +831,17 @@ static void WriteRegister(unsigned int reg_num, unsigned int value)
             opl_opl3mode = value & 0x01;
 
         default:
-            OPL3_WriteRegBuffered(&opl_chip, reg_num, value);
+            // Writes made from callbacks run on the synthesis thread and
+            // can go to the chip directly; anything else is queued.
+
+            if (SDL_ThreadID() == synth_thread_id)
+            {
+                OPL3_WriteRegBuffered(&opl_chip, reg_num, value);
+            }
+            else
+            {
+                QueueWrite(reg_num, value);
+            }
             break;
     }
 }
@@ -24,6 +24,7 @@
 #include "i_system.h"
 #include "st_bar.h"
 #include "p_local.h"
+#include "m_bbox.h"
 #include "m_misc.h"
 #include "v_video.h"
 #include "doomstat.h"
@@ -259,6 +260,51 @@ static void AM_rotatePoint (mpoint_t *pt);
 static mpoint_t mapcenter;
 static angle_t mapangle;
 
+// Lines that may be visible in the automap window, in linedef order.
+// Rebuilt every frame by AM_updateCulling from the grid cells under
+// the window, so zoomed in views don't have to touch every linedef.
+static int      *am_lines;
+static int       am_numlines;
+static int       am_linesalloced;
+static uint32_t *am_linemarks;
+
+// Lines listed in every grid cell their bounding box touches, built by
+// AM_SetupLevel. The blockmap is not used for this: maps may leave
+// lines out of it on purpose, and some node builders miss lines.
+// am_gridcells holds the start of each cell's list in am_gridlist,
+// plus the end of the last one.
+#define AM_GRIDMAXCELLS 65536
+
+static int      *am_gridcells;
+static int       am_gridcellsalloced;
+static int      *am_gridlist;
+static int       am_gridlistalloced;
+static int64_t   am_gridorgx, am_gridorgy;  // map coordinates
+static int       am_gridshift;              // cell size, in map coordinates
+static int       am_gridwidth, am_gridheight;
+
+// Window bounding box in unrotated map coordinates.
+static int64_t am_cullx1, am_cully1, am_cullx2, am_cully2;
+
+// Vertices transformed to (rotated) map coordinates for this frame.
+// Most vertices are shared by two or more lines, so they are only
+// rotated once per frame.
+static mpoint_t *am_vertexcache;
+static int      *am_vertexframe;
+static int       am_vertexalloced;
+static int       am_frame;
+
+// Clipped lines waiting to be rasterized, in drawing order.
+typedef struct
+{
+    fline_t fl;
+    int     color;
+} amline_t;
+
+static amline_t *am_linequeue;
+static int       am_linequeued;
+static int       am_linequeuealloced;
+
 // -----------------------------------------------------------------------------
 // AM_activateNewScale
 // Changes the map scale after zooming or translating.
@@ -625,6 +671,120 @@ static void AM_LevelInit (void)
     }
 }
 
+// -----------------------------------------------------------------------------
+// AM_SetupLevel
+// Builds the line grid used by AM_updateCulling. Cells are 128 units,
+// or bigger if the map is too large or its lines too long for that.
+// -----------------------------------------------------------------------------
+
+static void AM_gridRange (const line_t *ld, int *x1, int *y1, int *x2, int *y2)
+{
+    *x1 = (int) (((ld->bbox[BOXLEFT] >> FRACTOMAPBITS) - am_gridorgx) >> am_gridshift);
+    *x2 = (int) (((ld->bbox[BOXRIGHT] >> FRACTOMAPBITS) - am_gridorgx) >> am_gridshift);
+    *y1 = (int) (((ld->bbox[BOXBOTTOM] >> FRACTOMAPBITS) - am_gridorgy) >> am_gridshift);
+    *y2 = (int) (((ld->bbox[BOXTOP] >> FRACTOMAPBITS) - am_gridorgy) >> am_gridshift);
+}
+
+void AM_SetupLevel (void)
+{
+    int64_t maxx, maxy, total = 0;
+    int     i, x, y, x1, y1, x2, y2, cells;
+
+    am_gridwidth = am_gridheight = 0;
+
+    if (numlines == 0)
+    {
+        return;
+    }
+
+    am_gridorgx = maxx = lines[0].bbox[BOXLEFT] >> FRACTOMAPBITS;
+    am_gridorgy = maxy = lines[0].bbox[BOXBOTTOM] >> FRACTOMAPBITS;
+
+    for (i = 0 ; i < numlines ; i++)
+    {
+        am_gridorgx = MIN(am_gridorgx, lines[i].bbox[BOXLEFT] >> FRACTOMAPBITS);
+        am_gridorgy = MIN(am_gridorgy, lines[i].bbox[BOXBOTTOM] >> FRACTOMAPBITS);
+        maxx = MAX(maxx, lines[i].bbox[BOXRIGHT] >> FRACTOMAPBITS);
+        maxy = MAX(maxy, lines[i].bbox[BOXTOP] >> FRACTOMAPBITS);
+    }
+
+    // Long lines are listed in many cells, so use bigger cells
+    // if the lists would get much longer than the lines themselves.
+    for (am_gridshift = MAPBLOCKSHIFT - FRACTOMAPBITS ; ; am_gridshift++)
+    {
+        am_gridwidth = (int) ((maxx - am_gridorgx) >> am_gridshift) + 1;
+        am_gridheight = (int) ((maxy - am_gridorgy) >> am_gridshift) + 1;
+
+        if ((int64_t) am_gridwidth * am_gridheight > AM_GRIDMAXCELLS)
+        {
+            continue;
+        }
+
+        total = 0;
+
+        for (i = 0 ; i < numlines ; i++)
+        {
+            AM_gridRange(&lines[i], &x1, &y1, &x2, &y2);
+            total += (int64_t) (x2 - x1 + 1) * (y2 - y1 + 1);
+        }
+
+        if (total <= (int64_t) numlines * 16)
+        {
+            break;
+        }
+    }
+
+    cells = am_gridwidth * am_gridheight;
+
+    if (am_gridcellsalloced < cells + 1)
+    {
+        am_gridcellsalloced = cells + 1;
+        am_gridcells = I_Realloc(am_gridcells, am_gridcellsalloced * sizeof(*am_gridcells));
+    }
+
+    if (am_gridlistalloced < total)
+    {
+        am_gridlistalloced = (int) total;
+        am_gridlist = I_Realloc(am_gridlist, am_gridlistalloced * sizeof(*am_gridlist));
+    }
+
+    // Count the lines of each cell, then turn the counts into
+    // the end of each list and fill them in from the back,
+    // which leaves every list in linedef order.
+    memset(am_gridcells, 0, (cells + 1) * sizeof(*am_gridcells));
+
+    for (i = 0 ; i < numlines ; i++)
+    {
+        AM_gridRange(&lines[i], &x1, &y1, &x2, &y2);
+
+        for (y = y1 ; y <= y2 ; y++)
+        {
+            for (x = x1 ; x <= x2 ; x++)
+            {
+                am_gridcells[y * am_gridwidth + x]++;
+            }
+        }
+    }
+
+    for (i = 1 ; i <= cells ; i++)
+    {
+        am_gridcells[i] += am_gridcells[i - 1];
+    }
+
+    for (i = numlines - 1 ; i >= 0 ; i--)
+    {
+        AM_gridRange(&lines[i], &x1, &y1, &x2, &y2);
+
+        for (y = y1 ; y <= y2 ; y++)
+        {
+            for (x = x1 ; x <= x2 ; x++)
+            {
+                am_gridlist[--am_gridcells[y * am_gridwidth + x]] = i;
+            }
+        }
+    }
+}
+
 // -----------------------------------------------------------------------------
 // AM_Stop
 // -----------------------------------------------------------------------------
@@ -1184,13 +1344,7 @@ static void AM_drawFline (const fline_t *fl, const int color)
     // [JN] Apply line antialiasing
     if (automap_antialias && !vanillaparm)
     {
-        for (int i = 0 ; i < 256 ; i++)
-        {
-            if (color == i)
-            {
-                DrawWuLine(fl, i);
-            }
-        }
+        DrawWuLine(fl, color);
     }
     else
     {
@@ -1459,6 +1613,75 @@ static void AM_drawMline (const mline_t *ml, const int color)
     }
 }
 
+// -----------------------------------------------------------------------------
+// AM_queueMline
+// Clip line and queue its visible part for AM_drawQueuedLines.
+// When zoomed out, neighbouring lines often collapse to the same pixels;
+// repeating the previous line exactly would draw nothing new, so skip it.
+// -----------------------------------------------------------------------------
+
+static void AM_queueMline (const mline_t *ml, const int color)
+{
+    amline_t *q;
+
+    if (am_linequeued == am_linequeuealloced)
+    {
+        am_linequeuealloced = am_linequeuealloced ? am_linequeuealloced * 2 : 1024;
+        am_linequeue = I_Realloc(am_linequeue, am_linequeuealloced * sizeof(*am_linequeue));
+    }
+
+    q = &am_linequeue[am_linequeued];
+
+    if (!AM_clipMline(ml, &q->fl))
+    {
+        return;
+    }
+
+    q->color = color;
+
+    if (am_linequeued > 0)
+    {
+        const amline_t *prev = q - 1;
+
+        if (prev->color == color
+        &&  prev->fl.a.x == q->fl.a.x && prev->fl.a.y == q->fl.a.y
+        &&  prev->fl.b.x == q->fl.b.x && prev->fl.b.y == q->fl.b.y)
+        {
+            return;
+        }
+    }
+
+    am_linequeued++;
+}
+
+// -----------------------------------------------------------------------------
+// AM_drawQueuedLines
+// Rasterize queued lines in the order they were queued.
+// -----------------------------------------------------------------------------
+
+static void AM_drawQueuedLines (void)
+{
+    const amline_t *q = am_linequeue;
+    const amline_t *end = am_linequeue + am_linequeued;
+
+    if (automap_antialias && !vanillaparm)
+    {
+        for ( ; q < end ; q++)
+        {
+            DrawWuLine(&q->fl, q->color);
+        }
+    }
+    else
+    {
+        for ( ; q < end ; q++)
+        {
+            AM_drawFline(&q->fl, q->color);
+        }
+    }
+
+    am_linequeued = 0;
+}
+
 // -----------------------------------------------------------------------------
 // AM_drawGrid
 // Draws flat (floor/ceiling tile) aligned grid lines.
@@ -1546,29 +1769,222 @@ static void AM_drawGrid (const int color)
     }
 }
 
+// -----------------------------------------------------------------------------
+// AM_drawProfile
+// With -levelprofile, outline the blockmap cells frames were drawn
+// from, brighter for slower ones. Must follow AM_updateCulling.
+// -----------------------------------------------------------------------------
+
+static void AM_drawProfile (void)
+{
+    // Darkest red for the fastest cells, brightest for the slowest.
+    static const int heatcolors[] = { 0, REDS+15, REDS+10, REDS+5, REDS };
+    const int64_t orgx = bmaporgx >> FRACTOMAPBITS;
+    const int64_t orgy = bmaporgy >> FRACTOMAPBITS;
+    const int64_t size = MAPBLOCKSIZE >> FRACTOMAPBITS;
+    const int64_t inset = size / 8;
+    int     bx1, by1, bx2, by2;
+    mpoint_t corners[4];
+    mline_t ml;
+
+    bx1 = BETWEEN(0, bmapwidth - 1, (am_cullx1 - orgx) / size);
+    bx2 = BETWEEN(0, bmapwidth - 1, (am_cullx2 - orgx) / size);
+    by1 = BETWEEN(0, bmapheight - 1, (am_cully1 - orgy) / size);
+    by2 = BETWEEN(0, bmapheight - 1, (am_cully2 - orgy) / size);
+
+    for (int by = by1 ; by <= by2 ; by++)
+    {
+        for (int bx = bx1 ; bx <= bx2 ; bx++)
+        {
+            const int heat = P_ProfileHeat(bx, by);
+
+            if (!heat)
+            {
+                continue;
+            }
+
+            corners[0].x = corners[3].x = orgx + bx * size + inset;
+            corners[1].x = corners[2].x = orgx + (bx + 1) * size - inset;
+            corners[0].y = corners[1].y = orgy + by * size + inset;
+            corners[2].y = corners[3].y = orgy + (by + 1) * size - inset;
+
+            if (automap_rotate)
+            {
+                for (int i = 0 ; i < 4 ; i++)
+                {
+                    AM_rotatePoint(&corners[i]);
+                }
+            }
+
+            for (int i = 0 ; i < 4 ; i++)
+            {
+                ml.a = corners[i];
+                ml.b = corners[(i + 1) % 4];
+                AM_drawMline(&ml, heatcolors[heat]);
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// AM_updateCulling
+// Finds the lines that may be visible in the automap window by
+// gathering the grid cells under it. Must be called after mapcenter
+// and mapangle are set for this frame.
+// -----------------------------------------------------------------------------
+
+static void AM_updateCulling (void)
+{
+    int     i, x, y;
+    int     bx1, by1, bx2, by2;
+    int64_t rx, ry;
+    const int words = (numlines + 31) / 32;
+
+    am_frame++;
+
+    if (am_linesalloced < numlines)
+    {
+        am_linesalloced = numlines;
+        am_lines = I_Realloc(am_lines, numlines * sizeof(*am_lines));
+        am_linemarks = I_Realloc(am_linemarks, words * sizeof(*am_linemarks));
+    }
+
+    if (am_vertexalloced < numvertexes)
+    {
+        am_vertexalloced = numvertexes;
+        am_vertexcache = I_Realloc(am_vertexcache, numvertexes * sizeof(*am_vertexcache));
+        am_vertexframe = I_Realloc(am_vertexframe, numvertexes * sizeof(*am_vertexframe));
+        memset(am_vertexframe, 0, numvertexes * sizeof(*am_vertexframe));
+    }
+
+    // The window rotates around its own center, so when rotating,
+    // take a box that holds it at any angle.
+    if (automap_rotate)
+    {
+        rx = ry = (m_w + m_h) / 2 + 1;
+    }
+    else
+    {
+        rx = m_w / 2 + 1;
+        ry = m_h / 2 + 1;
+    }
+
+    am_cullx1 = m_x + m_w / 2 - rx;
+    am_cullx2 = m_x + m_w / 2 + rx;
+    am_cully1 = m_y + m_h / 2 - ry;
+    am_cully2 = m_y + m_h / 2 + ry;
+
+    // Grid cells under the box.
+    bx1 = BETWEEN(0, am_gridwidth - 1, (am_cullx1 - am_gridorgx) >> am_gridshift);
+    bx2 = BETWEEN(0, am_gridwidth - 1, (am_cullx2 - am_gridorgx) >> am_gridshift);
+    by1 = BETWEEN(0, am_gridheight - 1, (am_cully1 - am_gridorgy) >> am_gridshift);
+    by2 = BETWEEN(0, am_gridheight - 1, (am_cully2 - am_gridorgy) >> am_gridshift);
+
+    // When most of the map is in view, gathering the cells
+    // costs more than it saves.
+    if ((int64_t) (bx2 - bx1 + 1) * (by2 - by1 + 1) * 4
+    >=  (int64_t) am_gridwidth * am_gridheight * 3)
+    {
+        for (i = 0 ; i < numlines ; i++)
+        {
+            am_lines[i] = i;
+        }
+
+        am_numlines = numlines;
+        return;
+    }
+
+    memset(am_linemarks, 0, words * sizeof(*am_linemarks));
+
+    for (y = by1 ; y <= by2 ; y++)
+    {
+        for (x = bx1 ; x <= bx2 ; x++)
+        {
+            const int cell = y * am_gridwidth + x;
+
+            for (int j = am_gridcells[cell] ; j < am_gridcells[cell + 1] ; j++)
+            {
+                const int line = am_gridlist[j];
+
+                am_linemarks[line >> 5] |= 1u << (line & 31);
+            }
+        }
+    }
+
+    // Collect marked lines in linedef order, so they
+    // overlap each other the same way as before.
+    am_numlines = 0;
+
+    for (i = 0 ; i < words ; i++)
+    {
+        uint32_t bits = am_linemarks[i];
+        int      line = i * 32;
+
+        for ( ; bits ; bits >>= 1, line++)
+        {
+            if (bits & 1)
+            {
+                am_lines[am_numlines++] = line;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// AM_transformVertex
+// Returns vertex in map coordinates, rotated if needed.
+// Each vertex is transformed only once per frame.
+// -----------------------------------------------------------------------------
+
+static void AM_transformVertex (const vertex_t *v, mpoint_t *pt)
+{
+    const int n = v - vertexes;
+
+    if (n < 0 || n >= am_vertexalloced)
+    {
+        pt->x = v->x >> FRACTOMAPBITS;
+        pt->y = v->y >> FRACTOMAPBITS;
+
+        if (automap_rotate)
+        {
+            AM_rotatePoint(pt);
+        }
+        return;
+    }
+
+    if (am_vertexframe[n] != am_frame)
+    {
+        am_vertexcache[n].x = v->x >> FRACTOMAPBITS;
+        am_vertexcache[n].y = v->y >> FRACTOMAPBITS;
+
+        if (automap_rotate)
+        {
+            AM_rotatePoint(&am_vertexcache[n]);
+        }
+
+        am_vertexframe[n] = am_frame;
+    }
+
+    *pt = am_vertexcache[n];
+}
+
 // -----------------------------------------------------------------------------
 // AM_drawWalls
-// Determines visible lines, draws them. 
+// Determines visible lines, draws them.
 // This is LineDef based, not LineSeg based.
 // -----------------------------------------------------------------------------
 
 static void AM_drawWalls (const int automap_color_set)
 {
-    int    i;
+    int    i, n;
     static mline_t l;
 
-    for (i = 0 ; i < numlines ; i++)
+    for (n = 0 ; n < am_numlines ; n++)
     {
-        l.a.x = lines[i].v1->x >> FRACTOMAPBITS;
-        l.a.y = lines[i].v1->y >> FRACTOMAPBITS;
-        l.b.x = lines[i].v2->x >> FRACTOMAPBITS;
-        l.b.y = lines[i].v2->y >> FRACTOMAPBITS;
+        i = am_lines[n];
 
-        if (automap_rotate)
-        {
-            AM_rotatePoint(&l.a);
-            AM_rotatePoint(&l.b);
-        }
+        AM_transformVertex(lines[i].v1, &l.a);
+        AM_transformVertex(lines[i].v2, &l.b);
 
         switch (automap_color_set)
         {
@@ -1584,11 +2000,11 @@ static void AM_drawWalls (const int automap_color_set)
                         // [JN] Highlight secret sectors
                         if (automap_secrets && lines[i].frontsector->special == 9)
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         else
                         {
-                            AM_drawMline(&l, 23);
+                            AM_queueMline(&l, 23);
                         }
                     }
                     else
@@ -1597,40 +2013,40 @@ static void AM_drawWalls (const int automap_color_set)
                         if (lines[i].special == 39  || lines[i].special == 97
                         ||  lines[i].special == 125 || lines[i].special == 126)
                         {
-                            AM_drawMline(&l, 119);
+                            AM_queueMline(&l, 119);
                         }
                         // Secret door
                         else if (lines[i].flags & ML_SECRET)
                         {
-                            AM_drawMline(&l, 23);      // wall color
+                            AM_queueMline(&l, 23);      // wall color
                         }
                         // [JN] Highlight secret sectors
                         else if (automap_secrets
                         && (lines[i].frontsector->special == 9
                         ||  lines[i].backsector->special == 9))
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         // BLUE locked doors
                         else
                         if (lines[i].special == 26 || lines[i].special == 32
                         ||  lines[i].special == 99 || lines[i].special == 133)
                         {
-                            AM_drawMline(&l, 204);
+                            AM_queueMline(&l, 204);
                         }
                         // RED locked doors
                         else
                         if (lines[i].special == 28  || lines[i].special == 33
                         ||  lines[i].special == 134 || lines[i].special == 135)
                         {
-                            AM_drawMline(&l, 175);
+                            AM_queueMline(&l, 175);
                         }
                         // YELLOW locked doors
                         else
                         if (lines[i].special == 27  || lines[i].special == 34
                         ||  lines[i].special == 136 || lines[i].special == 137)
                         {
-                            AM_drawMline(&l, 231);
+                            AM_queueMline(&l, 231);
                         }
                         // non-secret closed door
                         else
@@ -1638,24 +2054,24 @@ static void AM_drawWalls (const int automap_color_set)
                         ((lines[i].backsector->floorheight == lines[i].backsector->ceilingheight) ||
                         (lines[i].frontsector->floorheight == lines[i].frontsector->ceilingheight)))
                         {
-                            AM_drawMline(&l, 208);      // non-secret closed door
+                            AM_queueMline(&l, 208);      // non-secret closed door
                         } //jff 1/6/98 show secret sector 2S lines
                         // floor level change
                         else
                         if (lines[i].backsector->floorheight != lines[i].frontsector->floorheight)
                         {
-                            AM_drawMline(&l, 55);
+                            AM_queueMline(&l, 55);
                         }
                         // ceiling level change
                         else
                         if (lines[i].backsector->ceilingheight != lines[i].frontsector->ceilingheight)
                         {
-                            AM_drawMline(&l, 215);
+                            AM_queueMline(&l, 215);
                         }
                         //2S lines that appear only in IDDT
                         else if (cheating)
                         {
-                            AM_drawMline(&l, 88);
+                            AM_queueMline(&l, 88);
                         }
                     }
                 }
@@ -1669,7 +2085,7 @@ static void AM_drawWalls (const int automap_color_set)
                         || lines[i].backsector->floorheight != lines[i].frontsector->floorheight
                         || lines[i].backsector->ceilingheight != lines[i].frontsector->ceilingheight)
                         {
-                            AM_drawMline(&l, 104);
+                            AM_queueMline(&l, 104);
                         }
                     }
                 }
@@ -1687,11 +2103,11 @@ static void AM_drawWalls (const int automap_color_set)
                         // [JN] Highlight secret sectors
                         if (automap_secrets && lines[i].frontsector->special == 9)
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         else
                         {
-                            AM_drawMline(&l, RED_JAGUAR);
+                            AM_queueMline(&l, RED_JAGUAR);
                         }
                     }
                     else
@@ -1699,45 +2115,45 @@ static void AM_drawWalls (const int automap_color_set)
                         // Teleport line
                         if (lines[i].special == 39 || lines[i].special == 97)
                         {
-                            AM_drawMline(&l, GREEN_JAGUAR);
+                            AM_queueMline(&l, GREEN_JAGUAR);
                         }
                         // Secret door
                         else if (lines[i].flags & ML_SECRET)
                         {
-                            AM_drawMline(&l, RED_JAGUAR);
+                            AM_queueMline(&l, RED_JAGUAR);
                         }
                         // [JN] Highlight secret sectors
                         else if (automap_secrets
                         && (lines[i].frontsector->special == 9
                         ||  lines[i].backsector->special == 9))
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         // Any special linedef
                         else if (lines[i].special)
                         {
-                            AM_drawMline(&l, MAGENTA_JAGUAR);
+                            AM_queueMline(&l, MAGENTA_JAGUAR);
                         }
                         // Floor level change
                         else if (lines[i].backsector->floorheight != lines[i].frontsector->floorheight)
                         {
-                            AM_drawMline(&l, YELLOW_JAGUAR);
+                            AM_queueMline(&l, YELLOW_JAGUAR);
                         }
                         // Ceiling level change
                         else if (lines[i].backsector->ceilingheight != lines[i].frontsector->ceilingheight)
                         {
-                            AM_drawMline(&l, YELLOW_JAGUAR);
+                            AM_queueMline(&l, YELLOW_JAGUAR);
                         }
                         // Hidden gray walls
                         else if (cheating)
                         {
-                            AM_drawMline(&l, TSWALLCOLORS);
+                            AM_queueMline(&l, TSWALLCOLORS);
                         }
                     }
                 }
                 else if (plr->powers[pw_allmap])
                 {
-                    if (!(lines[i].flags & ML_DONTDRAW)) AM_drawMline(&l, GRAYS+3);
+                    if (!(lines[i].flags & ML_DONTDRAW)) AM_queueMline(&l, GRAYS+3);
                 }
                 break;
             }
@@ -1753,11 +2169,11 @@ static void AM_drawWalls (const int automap_color_set)
                         // [JN] Highlight secret sectors
                         if (automap_secrets && lines[i].frontsector->special == 9)
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         else
                         {
-                            AM_drawMline(&l, 151);
+                            AM_queueMline(&l, 151);
                         }
                     }
                     else
@@ -1766,55 +2182,55 @@ static void AM_drawWalls (const int automap_color_set)
                         if (lines[i].special == 39  || lines[i].special == 97
                         ||  lines[i].special == 125 || lines[i].special == 126)
                         {
-                            AM_drawMline(&l, 116);
+                            AM_queueMline(&l, 116);
                         }
                         // [JN] Secret door
                         else
                         if (lines[i].flags & ML_SECRET)
                         {
-                                AM_drawMline(&l, cheating ? 0 : 108);
+                                AM_queueMline(&l, cheating ? 0 : 108);
                         }
                         // [JN] Highlight secret sectors
                         else if (automap_secrets
                         && (lines[i].frontsector->special == 9
                         ||  lines[i].backsector->special == 9))
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         // [JN] BLUE locked doors
                         else
                         if (lines[i].special == 26 || lines[i].special == 32
                         ||  lines[i].special == 99 || lines[i].special == 133)
                         {
-                            AM_drawMline(&l, 199);
+                            AM_queueMline(&l, 199);
                         }
                         // [JN] RED locked doors
                         else
                         if (lines[i].special == 28  || lines[i].special == 33
                         ||  lines[i].special == 134 || lines[i].special == 135)
                         {
-                            AM_drawMline(&l, 178);
+                            AM_queueMline(&l, 178);
                         }
                         // [JN] YELLOW locked doors
                         else
                         if (lines[i].special == 27  || lines[i].special == 34
                         ||  lines[i].special == 136 || lines[i].special == 137)
                         {
-                            AM_drawMline(&l, 161);
+                            AM_queueMline(&l, 161);
                         }
                         // [JN] floor level change
                         else if (lines[i].backsector->floorheight != lines[i].frontsector->floorheight) 
                         {
-                            AM_drawMline(&l, 239);
+                            AM_queueMline(&l, 239);
                         }
                         // [JN] ceiling level change
                         else if (lines[i].backsector->ceilingheight != lines[i].frontsector->ceilingheight) 
                         {
-                            AM_drawMline(&l, 133);
+                            AM_queueMline(&l, 133);
                         }
                         else if (cheating)
                         {
-                            AM_drawMline(&l, 99);
+                            AM_queueMline(&l, 99);
                         }
                     }
                 }
@@ -1822,7 +2238,7 @@ static void AM_drawWalls (const int automap_color_set)
                 {
                     if (!(lines[i].flags & ML_DONTDRAW))
                     {
-                        AM_drawMline(&l, 99);
+                        AM_queueMline(&l, 99);
                     }
                 }
                 break;
@@ -1839,7 +2255,7 @@ static void AM_drawWalls (const int automap_color_set)
                     if (lines[i].special == 11 || lines[i].special == 51
                     ||  lines[i].special == 52 || lines[i].special == 124)
                     {
-                        AM_drawMline(&l, 119);
+                        AM_queueMline(&l, 119);
                     }
                     // villsa [STRIFE] lightlev is unused here
                     else if (!lines[i].backsector)
@@ -1847,11 +2263,11 @@ static void AM_drawWalls (const int automap_color_set)
                         // [JN] Highlight secret sectors
                         if (automap_secrets && lines[i].frontsector->special == 9)
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         else
                         {
-                            AM_drawMline(&l, 86);
+                            AM_queueMline(&l, 86);
                         }
                     }
                     else
@@ -1860,34 +2276,34 @@ static void AM_drawWalls (const int automap_color_set)
                         if (lines[i].special == 39  || lines[i].special == 97
                         ||  lines[i].special == 125 || lines[i].special == 126)
                         {
-                            AM_drawMline(&l, 135);
+                            AM_queueMline(&l, 135);
                         }
                         // secret door
                         else if (lines[i].flags & ML_SECRET)
                         {
                             // villsa [STRIFE] just draw the wall as is!
-                            AM_drawMline(&l, 86);
+                            AM_queueMline(&l, 86);
                         }
                         // [JN] Highlight secret sectors
                         else if (automap_secrets
                         && (lines[i].frontsector->special == 9
                         ||  lines[i].backsector->special == 9))
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         // floor level change
                         else if (lines[i].backsector->floorheight != lines[i].frontsector->floorheight) 
                         {
-                            AM_drawMline(&l, 203);
+                            AM_queueMline(&l, 203);
                         }
                         // ceiling level change
                         else if (lines[i].backsector->ceilingheight != lines[i].frontsector->ceilingheight) 
                         {
-                            AM_drawMline(&l, 195);
+                            AM_queueMline(&l, 195);
                         }
                         else if (cheating)
                         {
-                            AM_drawMline(&l, 98);
+                            AM_queueMline(&l, 98);
                         }
                     }
                 }
@@ -1895,7 +2311,7 @@ static void AM_drawWalls (const int automap_color_set)
                 {
                     if (!(lines[i].flags & ML_DONTDRAW))
                     {
-                        AM_drawMline(&l, 102);
+                        AM_queueMline(&l, 102);
                     }
                 }
                 break;
@@ -1918,11 +2334,11 @@ static void AM_drawWalls (const int automap_color_set)
                         // [JN] Highlight secret sectors
                         if (automap_secrets && lines[i].frontsector->special == 9)
                         {    
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         else
                         {
-                            AM_drawMline(&l, 184);
+                            AM_queueMline(&l, 184);
                         }
                     }
                     else
@@ -1930,77 +2346,77 @@ static void AM_drawWalls (const int automap_color_set)
                         // [JN] Secret door
                         if (lines[i].flags & ML_SECRET)
                         {
-                            AM_drawMline(&l, 184);
+                            AM_queueMline(&l, 184);
                         }
                         // [JN] Highlight secret sectors
                         else if (automap_secrets
                         && (lines[i].frontsector->special == 9
                         ||  lines[i].backsector->special == 9))
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         // [JN] Various Doors
                         else
                         if (lines[i].special == 1   || lines[i].special == 31
                         ||  lines[i].special == 117 || lines[i].special == 118)
                         {
-                            AM_drawMline(&l, 81);
+                            AM_queueMline(&l, 81);
                         }
                         // [JN] Various teleporters
                         else
                         if (lines[i].special == 39  || lines[i].special == 97
                         ||  lines[i].special == 125 || lines[i].special == 126)
                         {
-                            AM_drawMline(&l, 120);
+                            AM_queueMline(&l, 120);
                         }
                         // [JN] BLUE locked doors
                         else
                         if (lines[i].special == 26 || lines[i].special == 32
                         ||  lines[i].special == 99 || lines[i].special == 133)
                         {
-                            AM_drawMline(&l, 200);
+                            AM_queueMline(&l, 200);
                         }
                         // [JN] RED locked doors
                         else
                         if (lines[i].special == 28  || lines[i].special == 33
                         ||  lines[i].special == 134 || lines[i].special == 135)
                         {
-                            AM_drawMline(&l, 176);
+                            AM_queueMline(&l, 176);
                         }
                         // [JN] YELLOW locked doors
                         else
                         if (lines[i].special == 27  || lines[i].special == 34
                         ||  lines[i].special == 136 || lines[i].special == 137)
                         {
-                            AM_drawMline(&l, 160);
+                            AM_queueMline(&l, 160);
                         }
                         // [JN] Floor level change
                         else if (lines[i].backsector->floorheight != lines[i].frontsector->floorheight) 
                         {
-                            AM_drawMline(&l, 72);
+                            AM_queueMline(&l, 72);
                         }
                         // [JN] Ceiling level change
                         else if (lines[i].backsector->ceilingheight != lines[i].frontsector->ceilingheight) 
                         {
-                            AM_drawMline(&l, 64);
+                            AM_queueMline(&l, 64);
                         }
                         // [JN] IDDT visible lines
                         else if (cheating)
                         {
-                            AM_drawMline(&l, 96);
+                            AM_queueMline(&l, 96);
                         }
                     }
                     // [JN] Exit (can be one-sided or two-sided)
                     if (lines[i].special == 11 || lines[i].special == 51
                     ||  lines[i].special == 52 || lines[i].special == 124)
                     {
-                        AM_drawMline(&l, 112);
+                        AM_queueMline(&l, 112);
                     }
                 }
                 // [JN] Computermap visible lines
                 else if (plr->powers[pw_allmap])
                 {
-                    if (!(lines[i].flags & ML_DONTDRAW)) AM_drawMline(&l, 104);
+                    if (!(lines[i].flags & ML_DONTDRAW)) AM_queueMline(&l, 104);
                 }
                 break;
             }
@@ -2022,11 +2438,11 @@ static void AM_drawWalls (const int automap_color_set)
                         if (automap_secrets && !vanillaparm
                         &&  lines[i].frontsector->special == 9)
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         else
                         {
-                            AM_drawMline(&l, WALLCOLORS);
+                            AM_queueMline(&l, WALLCOLORS);
                         }
                     }
                     else
@@ -2034,44 +2450,46 @@ static void AM_drawWalls (const int automap_color_set)
                         // teleporters
                         if (lines[i].special == 39)
                         {
-                            AM_drawMline(&l, WALLCOLORS+WALLRANGE/2);
+                            AM_queueMline(&l, WALLCOLORS+WALLRANGE/2);
                         }
                         // secret door
                         else if (lines[i].flags & ML_SECRET)
                         {
-                            AM_drawMline(&l, WALLCOLORS);
+                            AM_queueMline(&l, WALLCOLORS);
                         }
                         // [JN] Highlight secret sectors
                         else if (automap_secrets && !vanillaparm
                         && (lines[i].frontsector->special == 9
                         ||  lines[i].backsector->special == 9))
                         {
-                            AM_drawMline(&l, secretwallcolors);
+                            AM_queueMline(&l, secretwallcolors);
                         }
                         // floor level change
                         else if (lines[i].backsector->floorheight != lines[i].frontsector->floorheight) 
                         {
-                            AM_drawMline(&l, FDWALLCOLORS);
+                            AM_queueMline(&l, FDWALLCOLORS);
                         }
                         // ceiling level change
                         else if (lines[i].backsector->ceilingheight != lines[i].frontsector->ceilingheight) 
                         {
-                            AM_drawMline(&l, CDWALLCOLORS);
+                            AM_queueMline(&l, CDWALLCOLORS);
                         }
                         else if (cheating)
                         {
-                            AM_drawMline(&l, TSWALLCOLORS);
+                            AM_queueMline(&l, TSWALLCOLORS);
                         }
                     }
                 }
                 else if (plr->powers[pw_allmap])
                 {
-                    if (!(lines[i].flags & ML_DONTDRAW)) AM_drawMline(&l, GRAYS+3);
+                    if (!(lines[i].flags & ML_DONTDRAW)) AM_queueMline(&l, GRAYS+3);
                 }
                 break;
             }
         }
     }
+
+    AM_drawQueuedLines();
 }
 
 // -----------------------------------------------------------------------------
@@ -2324,6 +2742,18 @@ static void AM_drawThings (const int colors, const int colorrange)
                 actualangle = t->angle;
             }
 
+            // Skip things outside of the automap window.
+            {
+                const int64_t margin = (t->radius >> FRACTOMAPBITS) + (16 << MAPBITS);
+
+                if (pt.x + margin < am_cullx1 || pt.x - margin > am_cullx2
+                ||  pt.y + margin < am_cully1 || pt.y - margin > am_cully2)
+                {
+                    t = t->snext;
+                    continue;
+                }
+            }
+
             if (automap_rotate)
             {
                 AM_rotatePoint(&pt);
@@ -2515,11 +2945,18 @@ void AM_Drawer (void)
         skippsprinterp = true;
     }
 
+    AM_updateCulling();
+
     if (automap_grid)
     {
         AM_drawGrid(GRIDCOLORS);
     }
 
+    if (levelprofile)
+    {
+        AM_drawProfile();
+    }
+
     AM_drawWalls(automap_color_set);
 
     AM_drawPlayers();
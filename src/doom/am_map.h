@@ -69,4 +69,7 @@ void AM_clearMarks (void);
 // [JN] Re-init in G_Responder on toggling spy mode (F12).
 void AM_initVariables (void);
 
+// Called by P_SetupLevel once the lines are loaded.
+void AM_SetupLevel (void);
+
 extern cheatseq_t cheat_amap;
@@ -608,6 +608,10 @@ static void DrawTimeAndFPS (void)
                 sprintf (digit, "%9d", rendered_vissprites);
                 RD_M_DrawTextC("SPRITES", 286 + (wide_4_3 ? wide_delta : wide_delta*2), 68);
                 RD_M_DrawTextC(digit, 278 + (wide_4_3 ? wide_delta : wide_delta*2), 75);
+
+                sprintf (digit, "%9d", rendered_clipsegs);
+                RD_M_DrawTextC("CLIPSEGS", 282 + (wide_4_3 ? wide_delta : wide_delta*2), 84);
+                RD_M_DrawTextC(digit, 278 + (wide_4_3 ? wide_delta : wide_delta*2), 91);
             }
         }
     }
@@ -902,6 +906,8 @@ void D_BindVariables(void)
 
     // Rendering
     M_BindIntVariable("uncapped_fps",           &uncapped_fps);
+    M_BindIntVariable("render_scale",           &render_scale);
+    M_BindIntVariable("dynamic_resolution",     &dynamic_resolution);
     M_BindIntVariable("smoothlight",            &smoothlight);
     M_BindIntVariable("show_diskicon",          &show_diskicon);
     M_BindIntVariable("screen_wiping",          &screen_wiping);
@@ -3475,6 +3481,7 @@ void D_DoomMain (void)
                "S_Init: Setting up sound.\n" :
                "S_Init: Активация звуковой системы.\n");
     S_Init (sfxVolume * 8, musicVolume);
+    I_RenderAudio();
 
     DEH_printf(english_language ?
                "D_CheckNetGame: Checking network game status.\n" :
@@ -3512,6 +3519,24 @@ void D_DoomMain (void)
                    "Регистрация внешней статистики.\n");
     }
 
+    //!
+    // @arg <dir>
+    // @category game
+    //
+    // Profile each level played, or replayed from a demo. When the level
+    // ends, write what drawing from and running each of its sectors and
+    // blockmap cells cost to <dir>/<map>.csv, and a heatmap of the frame
+    // time from each cell to <dir>/<map>.pgm. The automap shows the
+    // slowest cells so far.
+    //
+
+    p = M_CheckParmWithArgs("-levelprofile", 1);
+
+    if (p)
+    {
+        P_StartLevelProfile(myargv[p + 1]);
+    }
+
     //!
     // @arg <x>
     // @category demo
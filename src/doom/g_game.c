@@ -1099,10 +1099,12 @@ void G_Ticker (void)
 
         case GS_INTERMISSION: 
         WI_Ticker (); 
+        P_PrefetchTicker ();
         break; 
 
         case GS_FINALE: 
         F_Ticker (); 
+        P_PrefetchTicker ();
         break; 
 
         case GS_DEMOSCREEN: 
@@ -1731,6 +1733,13 @@ void G_DoCompleted (void)
     }
 
     WI_Start (&wminfo); 
+
+    // Start loading the next level while the intermission is shown.
+    // There is none after ExM8, where the game ends or the episode does.
+    if (gamemode == commercial || gamemap != 8)
+    {
+        P_StartPrefetch(gameepisode, wminfo.next + 1);
+    }
 } 
 
 
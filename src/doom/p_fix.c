@@ -24,7 +24,11 @@
 
 
 #include "doomstat.h"
+#include "i_swap.h"
+#include "i_system.h"
 #include "p_local.h"
+#include "jn.h"
+#include "z_zone.h"
 
 
 #define VERTEXFIX_END  { -1, 0, 0, 0, 0, 0, 0, 0 }
@@ -42,13 +46,13 @@ static const flow_t flow_dummy[] = { FLOW_END };
 static const fall_t fall_dummy[] = { FLOW_END };
 
 // [JN] Tables with map fixes.
-const vertexfix_t *selected_vertexfix;
-const linefix_t   *selected_linefix;
-const sectorfix_t *selected_sectorfix;
+static const vertexfix_t *selected_vertexfix;
+static const linefix_t   *selected_linefix;
+static const sectorfix_t *selected_sectorfix;
 
 // [JN] Tables with liquid flow/fall effect.
-const flow_t *selected_flow;
-const fall_t *selected_fall;
+static const flow_t *selected_flow;
+static const fall_t *selected_fall;
 
 
 // =============================================================================
@@ -9120,957 +9124,330 @@ static const flow_t flow_tnt_map32[] =
 
 
 // -----------------------------------------------------------------------------
-// P_SetupFixes
-// [JN] Sets appropriated fixes for selected map.
-// -----------------------------------------------------------------------------
-
-void P_SetupFixes (const int episode, const int map)
-{
-    // First, initialize all fixes with dummies.
-    selected_vertexfix = vertexfix_dummy;
-    selected_linefix   = linefix_dummy;
-    selected_sectorfix = sectorfix_dummy;
+// Fix tables of each map. Episode 0 matches any episode.
+// -----------------------------------------------------------------------------
+
+typedef struct
+{
+    int                mission;
+    int                episode;
+    int                map;
+    const vertexfix_t *vertexfix;
+    const linefix_t   *linefix;
+    const sectorfix_t *sectorfix;
+    const flow_t      *flow;
+    const fall_t      *fall;
+} mapfix_t;
+
+static const mapfix_t mapfixes[] =
+{
+    { doom,      1, 1,  NULL,                  linefix_doom1_e1m1,  sectorfix_doom1_e1m1,  flow_doom1_e1m1,  NULL },
+    { doom,      1, 2,  NULL,                  linefix_doom1_e1m2,  NULL,                  flow_doom1_e1m2,  NULL },
+    { doom,      1, 3,  vertexfix_doom1_e1m3,  linefix_doom1_e1m3,  sectorfix_doom1_e1m3,  flow_doom1_e1m3,  NULL },
+    { doom,      1, 4,  NULL,                  linefix_doom1_e1m4,  sectorfix_doom1_e1m4,  flow_doom1_e1m4,  NULL },
+    { doom,      1, 5,  NULL,                  linefix_doom1_e1m5,  sectorfix_doom1_e1m5,  flow_doom1_e1m5,  NULL },
+    { doom,      1, 6,  NULL,                  linefix_doom1_e1m6,  sectorfix_doom1_e1m6,  flow_doom1_e1m6,  NULL },
+    { doom,      1, 7,  NULL,                  linefix_doom1_e1m7,  sectorfix_doom1_e1m7,  flow_doom1_e1m7,  NULL },
+    { doom,      1, 8,  NULL,                  linefix_doom1_e1m8,  NULL,                  NULL,             NULL },
+    { doom,      1, 9,  NULL,                  NULL,                sectorfix_doom1_e1m9,  flow_doom1_e1m9,  NULL },
+    { doom,      2, 1,  NULL,                  linefix_doom1_e2m1,  sectorfix_doom1_e2m1,  flow_doom1_e2m1,  NULL },
+    { doom,      2, 2,  vertexfix_doom1_e2m2,  linefix_doom1_e2m2,  sectorfix_doom1_e2m2,  flow_doom1_e2m2,  NULL },
+    { doom,      2, 3,  NULL,                  linefix_doom1_e2m3,  sectorfix_doom1_e2m3,  flow_doom1_e2m3,  NULL },
+    { doom,      2, 4,  NULL,                  linefix_doom1_e2m4,  sectorfix_doom1_e2m4,  flow_doom1_e2m4,  NULL },
+    { doom,      2, 5,  NULL,                  linefix_doom1_e2m5,  sectorfix_doom1_e2m5,  flow_doom1_e2m5,  NULL },
+    { doom,      2, 6,  vertexfix_doom1_e2m6,  linefix_doom1_e2m6,  sectorfix_doom1_e2m6,  flow_doom1_e2m6,  NULL },
+    { doom,      2, 7,  vertexfix_doom1_e2m7,  linefix_doom1_e2m7,  sectorfix_doom1_e2m7,  flow_doom1_e2m7,  NULL },
+    { doom,      2, 9,  NULL,                  linefix_doom1_e2m9,  sectorfix_doom1_e2m9,  flow_doom1_e2m9,  NULL },
+    { doom,      3, 1,  NULL,                  linefix_doom1_e3m1,  NULL,                  flow_doom1_e3m1,  NULL },
+    { doom,      3, 2,  NULL,                  linefix_doom1_e3m2,  sectorfix_doom1_e3m2,  flow_doom1_e3m2,  NULL },
+    { doom,      3, 3,  NULL,                  linefix_doom1_e3m3,  sectorfix_doom1_e3m3,  flow_doom1_e3m3,  NULL },
+    { doom,      3, 4,  NULL,                  linefix_doom1_e3m4,  sectorfix_doom1_e3m4,  flow_doom1_e3m4,  NULL },
+    { doom,      3, 5,  NULL,                  linefix_doom1_e3m5,  sectorfix_doom1_e3m5,  flow_doom1_e3m5,  NULL },
+    { doom,      3, 6,  NULL,                  linefix_doom1_e3m6,  sectorfix_doom1_e3m6,  flow_doom1_e3m6,  NULL },
+    { doom,      3, 7,  NULL,                  linefix_doom1_e3m7,  sectorfix_doom1_e3m7,  flow_doom1_e3m7,  NULL },
+    { doom,      3, 8,  NULL,                  NULL,                sectorfix_doom1_e3m8,  NULL,             NULL },
+    { doom,      3, 9,  NULL,                  linefix_doom1_e3m9,  sectorfix_doom1_e3m9,  flow_doom1_e3m9,  NULL },
+    { doom,      4, 1,  NULL,                  linefix_doom1_e4m1,  sectorfix_doom1_e4m1,  flow_doom1_e4m1,  NULL },
+    { doom,      4, 2,  NULL,                  linefix_doom1_e4m2,  sectorfix_doom1_e4m2,  flow_doom1_e4m2,  NULL },
+    { doom,      4, 3,  NULL,                  linefix_doom1_e4m3,  sectorfix_doom1_e4m3,  flow_doom1_e4m3,  NULL },
+    { doom,      4, 4,  NULL,                  linefix_doom1_e4m4,  sectorfix_doom1_e4m4,  flow_doom1_e4m4,  NULL },
+    { doom,      4, 5,  NULL,                  linefix_doom1_e4m5,  sectorfix_doom1_e4m5,  flow_doom1_e4m5,  NULL },
+    { doom,      4, 6,  NULL,                  linefix_doom1_e4m6,  NULL,                  flow_doom1_e4m6,  NULL },
+    { doom,      4, 7,  NULL,                  linefix_doom1_e4m7,  sectorfix_doom1_e4m7,  flow_doom1_e4m7,  NULL },
+    { doom,      4, 8,  NULL,                  linefix_doom1_e4m8,  sectorfix_doom1_e4m8,  flow_doom1_e4m8,  NULL },
+    { doom,      4, 9,  NULL,                  linefix_doom1_e4m9,  sectorfix_doom1_e4m9,  flow_doom1_e4m9,  NULL },
+
+    { doom2,     0, 1,  vertexfix_doom2_map01, linefix_doom2_map01, sectorfix_doom2_map01, flow_doom2_map01, NULL },
+    { doom2,     0, 2,  vertexfix_doom2_map02, linefix_doom2_map02, sectorfix_doom2_map02, flow_doom2_map02, NULL },
+    { doom2,     0, 3,  NULL,                  linefix_doom2_map03, sectorfix_doom2_map03, flow_doom2_map03, NULL },
+    { doom2,     0, 4,  NULL,                  linefix_doom2_map04, sectorfix_doom2_map04, flow_doom2_map04, NULL },
+    { doom2,     0, 5,  NULL,                  linefix_doom2_map05, sectorfix_doom2_map05, flow_doom2_map05, NULL },
+    { doom2,     0, 6,  NULL,                  linefix_doom2_map06, sectorfix_doom2_map06, flow_doom2_map06, NULL },
+    { doom2,     0, 7,  NULL,                  linefix_doom2_map07, NULL,                  NULL,             NULL },
+    { doom2,     0, 8,  NULL,                  linefix_doom2_map08, sectorfix_doom2_map08, flow_doom2_map08, NULL },
+    { doom2,     0, 9,  NULL,                  linefix_doom2_map09, sectorfix_doom2_map09, flow_doom2_map09, NULL },
+    { doom2,     0, 10, NULL,                  linefix_doom2_map10, sectorfix_doom2_map10, flow_doom2_map10, NULL },
+    { doom2,     0, 11, NULL,                  linefix_doom2_map11, sectorfix_doom2_map11, flow_doom2_map11, NULL },
+    { doom2,     0, 12, NULL,                  linefix_doom2_map12, sectorfix_doom2_map12, flow_doom2_map12, NULL },
+    { doom2,     0, 13, NULL,                  linefix_doom2_map13, sectorfix_doom2_map13, NULL,             NULL },
+    { doom2,     0, 14, NULL,                  linefix_doom2_map14, sectorfix_doom2_map14, flow_doom2_map14, NULL },
+    { doom2,     0, 15, NULL,                  linefix_doom2_map15, sectorfix_doom2_map15, flow_doom2_map15, NULL },
+    { doom2,     0, 16, NULL,                  linefix_doom2_map16, NULL,                  flow_doom2_map16, NULL },
+    { doom2,     0, 17, NULL,                  linefix_doom2_map17, sectorfix_doom2_map17, flow_doom2_map17, NULL },
+    { doom2,     0, 18, NULL,                  linefix_doom2_map18, sectorfix_doom2_map18, flow_doom2_map18, NULL },
+    { doom2,     0, 19, NULL,                  linefix_doom2_map19, sectorfix_doom2_map19, flow_doom2_map19, NULL },
+    { doom2,     0, 20, NULL,                  linefix_doom2_map20, sectorfix_doom2_map20, flow_doom2_map20, NULL },
+    { doom2,     0, 21, NULL,                  linefix_doom2_map21, sectorfix_doom2_map21, flow_doom2_map21, NULL },
+    { doom2,     0, 22, NULL,                  linefix_doom2_map22, sectorfix_doom2_map22, flow_doom2_map22, NULL },
+    { doom2,     0, 23, NULL,                  linefix_doom2_map23, sectorfix_doom2_map23, flow_doom2_map23, NULL },
+    { doom2,     0, 24, NULL,                  linefix_doom2_map24, NULL,                  flow_doom2_map24, fall_doom2_map24 },
+    { doom2,     0, 25, NULL,                  linefix_doom2_map25, sectorfix_doom2_map25, flow_doom2_map25, fall_doom2_map25 },
+    { doom2,     0, 26, NULL,                  linefix_doom2_map26, sectorfix_doom2_map26, flow_doom2_map26, NULL },
+    { doom2,     0, 27, NULL,                  linefix_doom2_map27, sectorfix_doom2_map27, flow_doom2_map27, NULL },
+    { doom2,     0, 28, NULL,                  linefix_doom2_map28, NULL,                  flow_doom2_map28, fall_doom2_map28 },
+    { doom2,     0, 29, NULL,                  linefix_doom2_map29, sectorfix_doom2_map29, flow_doom2_map29, NULL },
+    { doom2,     0, 30, vertexfix_doom2_map30, linefix_doom2_map30, NULL,                  flow_doom2_map30, fall_doom2_map30 },
+    { doom2,     0, 31, NULL,                  linefix_doom2_map31, NULL,                  NULL,             NULL },
+    { doom2,     0, 32, NULL,                  linefix_doom2_map32, NULL,                  NULL,             NULL },
+
+    { pack_plut, 0, 1,  NULL,                  linefix_plut_map01,  sectorfix_plut_map01,  flow_plut_map01,  NULL },
+    { pack_plut, 0, 2,  NULL,                  linefix_plut_map02,  sectorfix_plut_map02,  flow_plut_map02,  fall_plut_map02 },
+    { pack_plut, 0, 3,  NULL,                  linefix_plut_map03,  sectorfix_plut_map03,  flow_plut_map03,  NULL },
+    { pack_plut, 0, 4,  NULL,                  linefix_plut_map04,  sectorfix_plut_map04,  flow_plut_map04,  NULL },
+    { pack_plut, 0, 5,  NULL,                  linefix_plut_map05,  sectorfix_plut_map05,  flow_plut_map05,  fall_plut_map05 },
+    { pack_plut, 0, 6,  NULL,                  linefix_plut_map06,  sectorfix_plut_map06,  flow_plut_map06,  fall_plut_map06 },
+    { pack_plut, 0, 7,  NULL,                  linefix_plut_map07,  sectorfix_plut_map07,  flow_plut_map07,  NULL },
+    { pack_plut, 0, 8,  NULL,                  linefix_plut_map08,  sectorfix_plut_map08,  flow_plut_map08,  fall_plut_map08 },
+    { pack_plut, 0, 9,  NULL,                  linefix_plut_map09,  sectorfix_plut_map09,  flow_plut_map09,  fall_plut_map09 },
+    { pack_plut, 0, 10, NULL,                  linefix_plut_map10,  sectorfix_plut_map10,  flow_plut_map10,  NULL },
+    { pack_plut, 0, 11, NULL,                  NULL,                sectorfix_plut_map11,  flow_plut_map11,  NULL },
+    { pack_plut, 0, 12, NULL,                  linefix_plut_map12,  sectorfix_plut_map12,  flow_plut_map12,  fall_plut_map12 },
+    { pack_plut, 0, 13, NULL,                  linefix_plut_map13,  sectorfix_plut_map13,  flow_plut_map13,  fall_plut_map13 },
+    { pack_plut, 0, 14, NULL,                  linefix_plut_map14,  sectorfix_plut_map14,  flow_plut_map14,  fall_plut_map14 },
+    { pack_plut, 0, 15, NULL,                  linefix_plut_map15,  sectorfix_plut_map15,  flow_plut_map15,  NULL },
+    { pack_plut, 0, 16, NULL,                  linefix_plut_map16,  sectorfix_plut_map16,  flow_plut_map16,  fall_plut_map16 },
+    { pack_plut, 0, 17, NULL,                  NULL,                sectorfix_plut_map17,  flow_plut_map17,  fall_plut_map17 },
+    { pack_plut, 0, 18, NULL,                  NULL,                sectorfix_plut_map18,  flow_plut_map18,  NULL },
+    { pack_plut, 0, 19, NULL,                  linefix_plut_map19,  sectorfix_plut_map19,  flow_plut_map19,  fall_plut_map19 },
+    { pack_plut, 0, 20, NULL,                  linefix_plut_map20,  sectorfix_plut_map20,  flow_plut_map20,  NULL },
+    { pack_plut, 0, 21, NULL,                  NULL,                sectorfix_plut_map21,  flow_plut_map21,  NULL },
+    { pack_plut, 0, 22, NULL,                  linefix_plut_map22,  sectorfix_plut_map22,  flow_plut_map22,  fall_plut_map22 },
+    { pack_plut, 0, 23, NULL,                  linefix_plut_map23,  sectorfix_plut_map23,  flow_plut_map23,  fall_plut_map23 },
+    { pack_plut, 0, 24, NULL,                  linefix_plut_map24,  sectorfix_plut_map24,  flow_plut_map24,  fall_plut_map24 },
+    { pack_plut, 0, 25, NULL,                  linefix_plut_map25,  sectorfix_plut_map25,  flow_plut_map25,  NULL },
+    { pack_plut, 0, 26, NULL,                  linefix_plut_map26,  sectorfix_plut_map26,  flow_plut_map26,  fall_plut_map26 },
+    { pack_plut, 0, 27, NULL,                  NULL,                sectorfix_plut_map27,  flow_plut_map27,  NULL },
+    { pack_plut, 0, 28, NULL,                  linefix_plut_map28,  sectorfix_plut_map28,  flow_plut_map28,  fall_plut_map28 },
+    { pack_plut, 0, 29, NULL,                  linefix_plut_map29,  sectorfix_plut_map29,  flow_plut_map29,  NULL },
+    { pack_plut, 0, 30, NULL,                  linefix_plut_map30,  sectorfix_plut_map30,  flow_plut_map30,  fall_plut_map30 },
+    { pack_plut, 0, 31, NULL,                  linefix_plut_map31,  sectorfix_plut_map31,  flow_plut_map31,  fall_plut_map31 },
+    { pack_plut, 0, 32, NULL,                  linefix_plut_map32,  sectorfix_plut_map32,  flow_plut_map32,  NULL },
+
+    { pack_tnt,  0, 1,  NULL,                  linefix_tnt_map01,   NULL,                  flow_tnt_map01,   NULL },
+    { pack_tnt,  0, 2,  NULL,                  linefix_tnt_map02,   sectorfix_tnt_map02,   flow_tnt_map02,   NULL },
+    { pack_tnt,  0, 3,  NULL,                  linefix_tnt_map03,   NULL,                  flow_tnt_map03,   NULL },
+    { pack_tnt,  0, 4,  NULL,                  linefix_tnt_map04,   sectorfix_tnt_map04,   NULL,             NULL },
+    { pack_tnt,  0, 5,  NULL,                  linefix_tnt_map05,   sectorfix_tnt_map05,   NULL,             NULL },
+    { pack_tnt,  0, 6,  NULL,                  linefix_tnt_map06,   sectorfix_tnt_map06,   flow_tnt_map06,   NULL },
+    { pack_tnt,  0, 7,  NULL,                  NULL,                sectorfix_tnt_map07,   flow_tnt_map07,   NULL },
+    { pack_tnt,  0, 8,  NULL,                  NULL,                sectorfix_tnt_map08,   flow_tnt_map08,   NULL },
+    { pack_tnt,  0, 9,  NULL,                  linefix_tnt_map09,   sectorfix_tnt_map09,   flow_tnt_map09,   fall_tnt_map09 },
+    { pack_tnt,  0, 10, NULL,                  linefix_tnt_map10,   sectorfix_tnt_map10,   flow_tnt_map10,   fall_tnt_map10 },
+    { pack_tnt,  0, 11, NULL,                  linefix_tnt_map11,   sectorfix_tnt_map11,   flow_tnt_map11,   NULL },
+    { pack_tnt,  0, 12, NULL,                  linefix_tnt_map12,   sectorfix_tnt_map12,   flow_tnt_map12,   fall_tnt_map12 },
+    { pack_tnt,  0, 13, NULL,                  linefix_tnt_map13,   sectorfix_tnt_map13,   flow_tnt_map13,   NULL },
+    { pack_tnt,  0, 14, NULL,                  NULL,                sectorfix_tnt_map14,   flow_tnt_map14,   fall_tnt_map14 },
+    { pack_tnt,  0, 15, NULL,                  linefix_tnt_map15,   sectorfix_tnt_map15,   flow_tnt_map15,   NULL },
+    { pack_tnt,  0, 16, NULL,                  NULL,                sectorfix_tnt_map16,   flow_tnt_map16,   fall_tnt_map16 },
+    { pack_tnt,  0, 17, NULL,                  linefix_tnt_map17,   sectorfix_tnt_map17,   flow_tnt_map17,   NULL },
+    { pack_tnt,  0, 18, NULL,                  NULL,                sectorfix_tnt_map18,   flow_tnt_map18,   NULL },
+    { pack_tnt,  0, 19, NULL,                  linefix_tnt_map19,   sectorfix_tnt_map19,   flow_tnt_map19,   NULL },
+    { pack_tnt,  0, 20, NULL,                  linefix_tnt_map20,   sectorfix_tnt_map20,   flow_tnt_map20,   fall_tnt_map20 },
+    { pack_tnt,  0, 21, NULL,                  NULL,                NULL,                  flow_tnt_map21,   NULL },
+    { pack_tnt,  0, 22, NULL,                  linefix_tnt_map22,   sectorfix_tnt_map22,   flow_tnt_map22,   fall_tnt_map22 },
+    { pack_tnt,  0, 23, NULL,                  NULL,                NULL,                  flow_tnt_map23,   fall_tnt_map23 },
+    { pack_tnt,  0, 24, NULL,                  NULL,                sectorfix_tnt_map24,   flow_tnt_map24,   NULL },
+    { pack_tnt,  0, 25, NULL,                  linefix_tnt_map25,   sectorfix_tnt_map25,   flow_tnt_map25,   NULL },
+    { pack_tnt,  0, 26, NULL,                  linefix_tnt_map26,   sectorfix_tnt_map26,   flow_tnt_map26,   fall_tnt_map26 },
+    { pack_tnt,  0, 27, NULL,                  linefix_tnt_map27,   NULL,                  flow_tnt_map27,   NULL },
+    { pack_tnt,  0, 28, NULL,                  NULL,                sectorfix_tnt_map28,   flow_tnt_map28,   NULL },
+    { pack_tnt,  0, 29, NULL,                  linefix_tnt_map29,   sectorfix_tnt_map29,   flow_tnt_map29,   fall_tnt_map29 },
+    { pack_tnt,  0, 30, NULL,                  NULL,                sectorfix_tnt_map30,   flow_tnt_map30,   NULL },
+    { pack_tnt,  0, 31, NULL,                  linefix_tnt_map31,   sectorfix_tnt_map31,   flow_tnt_map31,   NULL },
+    { pack_tnt,  0, 32, NULL,                  linefix_tnt_map32,   sectorfix_tnt_map32,   flow_tnt_map32,   NULL },
+};
+
+// -----------------------------------------------------------------------------
+// Index of the selected fixes by vertex, line side or sector number,
+// so loading a map finds the fixes of each item directly instead of
+// scanning the whole table for every vertex, seg, sector and linedef.
+// -----------------------------------------------------------------------------
+
+typedef struct
+{
+    int *first;     // first fix of each item, or -1
+    int *next;      // next fix of the same item, or -1
+    int  numitems;
+} fixindex_t;
+
+static fixindex_t vertexfixes, linefixes, sectorfixes, flows, falls;
+
+// Fixes are only used if they are for the current map.
+
+#define P_FixForMap(fix) \
+    ((fix).mission == gamemission && (fix).epsiode == gameepisode && (fix).map == gamemap)
+
+// -----------------------------------------------------------------------------
+// P_IndexFixes
+// Keys are the item number of each fix, or -1 for fixes not to be used.
+// The fixes of an item stay in table order.
+// -----------------------------------------------------------------------------
+
+static void P_IndexFixes (fixindex_t *index, const int *keys, const int count)
+{
+    int j;
+
+    index->numitems = 0;
+
+    for (j = 0 ; j < count ; j++)
+    {
+        index->numitems = MAX(index->numitems, keys[j] + 1);
+    }
 
-    selected_flow = flow_dummy;
-    selected_fall = fall_dummy;
+    index->first = Z_Malloc((index->numitems + count) * sizeof(int), PU_LEVEL, NULL);
+    index->next = index->first + index->numitems;
 
-    // Next, define which game will use which map fixes.
-    if (logical_gamemission == doom)
+    for (j = 0 ; j < index->numitems ; j++)
     {
-        if (gameepisode == 1)
-        {
-            if (gamemap == 1)
-            {
-                selected_linefix   = linefix_doom1_e1m1;
-                selected_sectorfix = sectorfix_doom1_e1m1;
-                selected_flow      = flow_doom1_e1m1;
-            }
-            else
-            if (gamemap == 2)
-            {
-                selected_linefix   = linefix_doom1_e1m2;
-                selected_flow      = flow_doom1_e1m2;
-            }
-            else
-            if (gamemap == 3)
-            {
-                selected_vertexfix = vertexfix_doom1_e1m3;
-                selected_linefix   = linefix_doom1_e1m3;
-                selected_sectorfix = sectorfix_doom1_e1m3;
-                selected_flow      = flow_doom1_e1m3;
-            }
-            else
-            if (gamemap == 4)
-            {
-                selected_linefix   = linefix_doom1_e1m4;
-                selected_sectorfix = sectorfix_doom1_e1m4;
-                selected_flow      = flow_doom1_e1m4;
-            }
-            else
-            if (gamemap == 5)
-            {
-                selected_linefix   = linefix_doom1_e1m5;
-                selected_sectorfix = sectorfix_doom1_e1m5;
-                selected_flow      = flow_doom1_e1m5;
-            }
-            else
-            if (gamemap == 6)
-            {
-                selected_linefix   = linefix_doom1_e1m6;
-                selected_sectorfix = sectorfix_doom1_e1m6;
-                selected_flow      = flow_doom1_e1m6;
-            }
-            else
-            if (gamemap == 7)
-            {
-                selected_linefix   = linefix_doom1_e1m7;
-                selected_sectorfix = sectorfix_doom1_e1m7;
-                selected_flow      = flow_doom1_e1m7;
-            }
-            else
-            if (gamemap == 8)
-            {
-                selected_linefix   = linefix_doom1_e1m8;
-            }
-            else
-            if (gamemap == 9)
-            {
-                selected_sectorfix = sectorfix_doom1_e1m9;
-                selected_flow      = flow_doom1_e1m9;
-            }
-        }
-        else
-        if (gameepisode == 2)
-        {
-            if (gamemap == 1)
-            {
-                selected_linefix   = linefix_doom1_e2m1;
-                selected_sectorfix = sectorfix_doom1_e2m1;
-                selected_flow      = flow_doom1_e2m1;
-            }
-            else
-            if (gamemap == 2)
-            {
-                selected_vertexfix = vertexfix_doom1_e2m2;
-                selected_linefix   = linefix_doom1_e2m2;
-                selected_sectorfix = sectorfix_doom1_e2m2;
-                selected_flow      = flow_doom1_e2m2;
-            }
-            else
-            if (gamemap == 3)
-            {
-                selected_linefix   = linefix_doom1_e2m3;
-                selected_sectorfix = sectorfix_doom1_e2m3;
-                selected_flow      = flow_doom1_e2m3;
-            }
-            else
-            if (gamemap == 4)
-            {
-                selected_linefix   = linefix_doom1_e2m4;
-                selected_sectorfix = sectorfix_doom1_e2m4;
-                selected_flow      = flow_doom1_e2m4;
-            }
-            else
-            if (gamemap == 5)
-            {
-                selected_linefix   = linefix_doom1_e2m5;
-                selected_sectorfix = sectorfix_doom1_e2m5;
-                selected_flow      = flow_doom1_e2m5;
-            }
-            else
-            if (gamemap == 6)
-            {
-                selected_vertexfix = vertexfix_doom1_e2m6;
-                selected_linefix   = linefix_doom1_e2m6;
-                selected_sectorfix = sectorfix_doom1_e2m6;
-                selected_flow      = flow_doom1_e2m6;
-            }
-            else
-            if (gamemap == 7)
-            {
-                selected_vertexfix = vertexfix_doom1_e2m7;
-                selected_linefix   = linefix_doom1_e2m7;
-                selected_sectorfix = sectorfix_doom1_e2m7;
-                selected_flow      = flow_doom1_e2m7;
-            }
-            else
-            if (gamemap == 9)
-            {
-                selected_linefix   = linefix_doom1_e2m9;
-                selected_sectorfix = sectorfix_doom1_e2m9;
-                selected_flow      = flow_doom1_e2m9;
-            }
-        }
-        else
-        if (gameepisode == 3)
-        {
-            if (gamemap == 1)
-            {
-                selected_linefix   = linefix_doom1_e3m1;
-                selected_flow      = flow_doom1_e3m1;
-            }
-            else
-            if (gamemap == 2)
-            {
-                selected_linefix   = linefix_doom1_e3m2;
-                selected_sectorfix = sectorfix_doom1_e3m2;
-                selected_flow      = flow_doom1_e3m2;
-            }
-            else
-            if (gamemap == 3)
-            {
-                selected_linefix   = linefix_doom1_e3m3;
-                selected_sectorfix = sectorfix_doom1_e3m3;
-                selected_flow      = flow_doom1_e3m3;
-            }
-            else
-            if (gamemap == 4)
-            {
-                selected_linefix   = linefix_doom1_e3m4;
-                selected_sectorfix = sectorfix_doom1_e3m4;
-                selected_flow      = flow_doom1_e3m4;
-            }
-            else
-            if (gamemap == 5)
-            {
-                selected_linefix   = linefix_doom1_e3m5;
-                selected_sectorfix = sectorfix_doom1_e3m5;
-                selected_flow      = flow_doom1_e3m5;
-            }
-            else
-            if (gamemap == 6)
-            {
-                selected_linefix   = linefix_doom1_e3m6;
-                selected_sectorfix = sectorfix_doom1_e3m6;
-                selected_flow      = flow_doom1_e3m6;
-            }
-            else
-            if (gamemap == 7)
-            {
-                selected_linefix   = linefix_doom1_e3m7;
-                selected_sectorfix = sectorfix_doom1_e3m7;
-                selected_flow      = flow_doom1_e3m7;
-            }
-            else
-            if (gamemap == 8)
-            {
-                selected_sectorfix = sectorfix_doom1_e3m8;
-            }
-            else
-            if (gamemap == 9)
-            {
-                selected_linefix   = linefix_doom1_e3m9;
-                selected_sectorfix = sectorfix_doom1_e3m9;
-                selected_flow      = flow_doom1_e3m9;
-            }
-        }
-        else
-        if (gameepisode == 4)
-        {
-            if (gamemap == 1)
-            {
-                selected_linefix   = linefix_doom1_e4m1;
-                selected_sectorfix = sectorfix_doom1_e4m1;
-                selected_flow      = flow_doom1_e4m1;
-            }
-            else
-            if (gamemap == 2)
-            {
-                selected_linefix   = linefix_doom1_e4m2;
-                selected_sectorfix = sectorfix_doom1_e4m2;
-                selected_flow      = flow_doom1_e4m2;
-            }
-            else
-            if (gamemap == 3)
-            {
-                selected_linefix   = linefix_doom1_e4m3;
-                selected_sectorfix = sectorfix_doom1_e4m3;
-                selected_flow      = flow_doom1_e4m3;
-            }
-            else
-            if (gamemap == 4)
-            {
-                selected_linefix   = linefix_doom1_e4m4;
-                selected_sectorfix = sectorfix_doom1_e4m4;
-                selected_flow      = flow_doom1_e4m4;
-            }
-            else
-            if (gamemap == 5)
-            {
-                selected_linefix   = linefix_doom1_e4m5;
-                selected_sectorfix = sectorfix_doom1_e4m5;
-                selected_flow      = flow_doom1_e4m5;
-            }
-            else
-            if (gamemap == 6)
-            {
-                selected_linefix   = linefix_doom1_e4m6;
-                selected_flow      = flow_doom1_e4m6;
-            }
-            else
-            if (gamemap == 7)
-            {
-                selected_linefix   = linefix_doom1_e4m7;
-                selected_sectorfix = sectorfix_doom1_e4m7;
-                selected_flow      = flow_doom1_e4m7;
-            }
-            else
-            if (gamemap == 8)
-            {
-                selected_linefix   = linefix_doom1_e4m8;
-                selected_sectorfix = sectorfix_doom1_e4m8;
-                selected_flow      = flow_doom1_e4m8;
-            }
-            else
-            if (gamemap == 9)
-            {
-                selected_linefix   = linefix_doom1_e4m9;
-                selected_sectorfix = sectorfix_doom1_e4m9;
-                selected_flow      = flow_doom1_e4m9;
-            }
-        }
+        index->first[j] = -1;
     }
-    else
-    if (logical_gamemission == doom2)
+
+    for (j = count - 1 ; j >= 0 ; j--)
     {
-        if (gamemap == 1)
-        {
-            selected_vertexfix = vertexfix_doom2_map01;
-            selected_linefix   = linefix_doom2_map01;
-            selected_sectorfix = sectorfix_doom2_map01;
-            selected_flow      = flow_doom2_map01;
-        }
-        else
-        if (gamemap == 2)
-        {
-            selected_vertexfix = vertexfix_doom2_map02;
-            selected_linefix   = linefix_doom2_map02;
-            selected_sectorfix = sectorfix_doom2_map02;
-            selected_flow      = flow_doom2_map02;
-        }
-        else
-        if (gamemap == 3)
-        {
-            selected_linefix   = linefix_doom2_map03;
-            selected_sectorfix = sectorfix_doom2_map03;
-            selected_flow      = flow_doom2_map03;
-        }
-        else
-        if (gamemap == 4)
-        {
-            selected_linefix   = linefix_doom2_map04;
-            selected_sectorfix = sectorfix_doom2_map04;
-            selected_flow      = flow_doom2_map04;
-        }
-        else
-        if (gamemap == 5)
-        {
-            selected_linefix   = linefix_doom2_map05;
-            selected_sectorfix = sectorfix_doom2_map05;
-            selected_flow      = flow_doom2_map05;
-        }
-        else
-        if (gamemap == 6)
-        {
-            selected_linefix   = linefix_doom2_map06;
-            selected_sectorfix = sectorfix_doom2_map06;
-            selected_flow      = flow_doom2_map06;
-        }
-        else
-        if (gamemap == 7)
-        {
-            selected_linefix   = linefix_doom2_map07;
-        }
-        else
-        if (gamemap == 8)
-        {
-            selected_linefix   = linefix_doom2_map08;
-            selected_sectorfix = sectorfix_doom2_map08;
-            selected_flow      = flow_doom2_map08;
-        }
-        else
-        if (gamemap == 9)
-        {
-            selected_linefix   = linefix_doom2_map09;
-            selected_sectorfix = sectorfix_doom2_map09;
-            selected_flow      = flow_doom2_map09;
-        }
-        else
-        if (gamemap == 10)
-        {
-            selected_linefix   = linefix_doom2_map10;
-            selected_sectorfix = sectorfix_doom2_map10;
-            selected_flow      = flow_doom2_map10;
-        }
-        else
-        if (gamemap == 11)
-        {
-            selected_linefix   = linefix_doom2_map11;
-            selected_sectorfix = sectorfix_doom2_map11;
-            selected_flow      = flow_doom2_map11;
-        }
-        else
-        if (gamemap == 12)
-        {
-            selected_linefix   = linefix_doom2_map12;
-            selected_sectorfix = sectorfix_doom2_map12;
-            selected_flow      = flow_doom2_map12;
-        }
-        else
-        if (gamemap == 13)
-        {
-            selected_linefix   = linefix_doom2_map13;
-            selected_sectorfix = sectorfix_doom2_map13;
-        }
-        else
-        if (gamemap == 14)
-        {
-            selected_linefix   = linefix_doom2_map14;
-            selected_sectorfix = sectorfix_doom2_map14;
-            selected_flow      = flow_doom2_map14;
-        }
-        else
-        if (gamemap == 15)
-        {
-            selected_linefix   = linefix_doom2_map15;
-            selected_sectorfix = sectorfix_doom2_map15;
-            selected_flow      = flow_doom2_map15;
-        }
-        else
-        if (gamemap == 16)
-        {
-            selected_linefix   = linefix_doom2_map16;
-            selected_flow      = flow_doom2_map16;
-        }
-        else
-        if (gamemap == 17)
-        {
-            selected_linefix   = linefix_doom2_map17;
-            selected_sectorfix = sectorfix_doom2_map17;
-            selected_flow      = flow_doom2_map17;
-        }
-        else
-        if (gamemap == 18)
-        {
-             selected_linefix   = linefix_doom2_map18;
-             selected_sectorfix = sectorfix_doom2_map18;
-             selected_flow      = flow_doom2_map18;
-        }
-        else
-        if (gamemap == 19)
-        {
-            selected_linefix   = linefix_doom2_map19;
-            selected_sectorfix = sectorfix_doom2_map19;
-            selected_flow      = flow_doom2_map19;
-        }
-        else
-        if (gamemap == 20)
-        {
-            selected_linefix   = linefix_doom2_map20;
-            selected_sectorfix = sectorfix_doom2_map20;
-            selected_flow      = flow_doom2_map20;
-        }
-        else
-        if (gamemap == 21)
-        {
-             selected_linefix   = linefix_doom2_map21;
-             selected_sectorfix = sectorfix_doom2_map21;
-             selected_flow      = flow_doom2_map21;
-        }
-        else
-        if (gamemap == 22)
-        {
-            selected_linefix   = linefix_doom2_map22;
-            selected_sectorfix = sectorfix_doom2_map22;
-            selected_flow      = flow_doom2_map22;
-        }
-        else
-        if (gamemap == 23)
+        if (keys[j] >= 0)
         {
-            selected_linefix   = linefix_doom2_map23;
-            selected_sectorfix = sectorfix_doom2_map23;
-            selected_flow      = flow_doom2_map23;
-        }
-        else
-        if (gamemap == 24)
-        {
-             selected_linefix   = linefix_doom2_map24;
-             selected_flow      = flow_doom2_map24;
-             selected_fall      = fall_doom2_map24;
-        }
-        else
-        if (gamemap == 25)
-        {
-            selected_linefix   = linefix_doom2_map25;
-            selected_sectorfix = sectorfix_doom2_map25;
-            selected_flow      = flow_doom2_map25;
-            selected_fall      = fall_doom2_map25;
-        }
-        else
-        if (gamemap == 26)
-        {
-            selected_linefix   = linefix_doom2_map26;
-            selected_sectorfix = sectorfix_doom2_map26;
-            selected_flow      = flow_doom2_map26;
-        }
-        else
-        if (gamemap == 27)
-        {
-            selected_linefix   = linefix_doom2_map27;
-            selected_sectorfix = sectorfix_doom2_map27;
-            selected_flow      = flow_doom2_map27;
-        }
-        else
-        if (gamemap == 28)
-        {
-            selected_linefix   = linefix_doom2_map28;
-            selected_flow      = flow_doom2_map28;
-            selected_fall      = fall_doom2_map28;
-        }
-        else
-        if (gamemap == 29)
-        {
-            selected_linefix   = linefix_doom2_map29;
-            selected_sectorfix = sectorfix_doom2_map29;
-            selected_flow      = flow_doom2_map29;
-        }
-        else
-        if (gamemap == 30)
-        {
-            selected_vertexfix = vertexfix_doom2_map30;
-            selected_linefix   = linefix_doom2_map30;
-            selected_flow      = flow_doom2_map30;
-            selected_fall      = fall_doom2_map30;
-        }
-        else
-        if (gamemap == 31)
-        {
-            selected_linefix   = linefix_doom2_map31;
-        }
-        else
-        if (gamemap == 32)
-        {
-            selected_linefix   = linefix_doom2_map32;
+            index->next[j] = index->first[keys[j]];
+            index->first[keys[j]] = j;
         }
     }
-    else
-    if (logical_gamemission == pack_plut)
+}
+
+static const int P_FirstFix (const fixindex_t *index, const int item)
+{
+    return item >= 0 && item < index->numitems ? index->first[item] : -1;
+}
+
+// -----------------------------------------------------------------------------
+// P_SetupFixes
+// [JN] Sets appropriated fixes for selected map.
+// Must be called after the previous level's PU_LEVEL memory is freed.
+// -----------------------------------------------------------------------------
+
+void P_SetupFixes (const int episode, const int map)
+{
+    const vertexfix_t *vertexfix = vertexfix_dummy;
+    const linefix_t   *linefix   = linefix_dummy;
+    const sectorfix_t *sectorfix = sectorfix_dummy;
+    const flow_t      *flow      = flow_dummy;
+    const fall_t      *fall      = fall_dummy;
+    int  *keys;
+    int   count;
+
+    // Find the fix tables of the map. Tables that are not defined
+    // for it are left as dummies.
+    for (int i = 0 ; i < arrlen(mapfixes) ; i++)
     {
-        if (gamemap == 1)
-        {
-            selected_linefix   = linefix_plut_map01;
-            selected_sectorfix = sectorfix_plut_map01;
-            selected_flow      = flow_plut_map01;
-        }
-        else
-        if (gamemap == 2)
-        {
-            selected_linefix   = linefix_plut_map02;
-            selected_sectorfix = sectorfix_plut_map02;
-            selected_flow      = flow_plut_map02;
-            selected_fall      = fall_plut_map02;
-        }
-        else
-        if (gamemap == 3)
-        {
-            selected_linefix   = linefix_plut_map03;
-            selected_sectorfix = sectorfix_plut_map03;
-            selected_flow      = flow_plut_map03;
-        }
-        else
-        if (gamemap == 4)
-        {
-            selected_linefix   = linefix_plut_map04;
-            selected_sectorfix = sectorfix_plut_map04;
-            selected_flow      = flow_plut_map04;
-        }
-        else
-        if (gamemap == 5)
-        {
-            selected_linefix   = linefix_plut_map05;
-            selected_sectorfix = sectorfix_plut_map05;
-            selected_flow      = flow_plut_map05;
-            selected_fall      = fall_plut_map05;
-        }
-        else
-        if (gamemap == 6)
-        {
-            selected_linefix   = linefix_plut_map06;
-            selected_sectorfix = sectorfix_plut_map06;
-            selected_flow      = flow_plut_map06;
-            selected_fall      = fall_plut_map06;
-        }
-        else
-        if (gamemap == 7)
-        {
-            selected_linefix   = linefix_plut_map07;
-            selected_sectorfix = sectorfix_plut_map07;
-            selected_flow      = flow_plut_map07;
-        }
-        else
-        if (gamemap == 8)
-        {
-            selected_linefix   = linefix_plut_map08;
-            selected_sectorfix = sectorfix_plut_map08;
-            selected_flow      = flow_plut_map08;
-            selected_fall      = fall_plut_map08;
-        }
-        else
-        if (gamemap == 9)
-        {
-            selected_linefix   = linefix_plut_map09;
-            selected_sectorfix = sectorfix_plut_map09;
-            selected_flow      = flow_plut_map09;
-            selected_fall      = fall_plut_map09;
-        }
-        else
-        if (gamemap == 10)
-        {
-            selected_linefix   = linefix_plut_map10;
-            selected_sectorfix = sectorfix_plut_map10;
-            selected_flow      = flow_plut_map10;
-        }
-        else
-        if (gamemap == 11)
-        {
-            selected_sectorfix = sectorfix_plut_map11;
-            selected_flow      = flow_plut_map11;
-        }
-        else
-        if (gamemap == 12)
-        {
-            selected_linefix   = linefix_plut_map12;
-            selected_sectorfix = sectorfix_plut_map12;
-            selected_flow      = flow_plut_map12;
-            selected_fall      = fall_plut_map12;
-        }
-        else
-        if (gamemap == 13)
-        {
-            selected_linefix   = linefix_plut_map13;
-            selected_sectorfix = sectorfix_plut_map13;
-            selected_flow      = flow_plut_map13;
-            selected_fall      = fall_plut_map13;
-        }
-        else
-        if (gamemap == 14)
-        {
-            selected_linefix   = linefix_plut_map14;
-            selected_sectorfix = sectorfix_plut_map14;
-            selected_flow      = flow_plut_map14;
-            selected_fall      = fall_plut_map14;
-        }
-        else
-        if (gamemap == 15)
-        {
-            selected_linefix   = linefix_plut_map15;
-            selected_sectorfix = sectorfix_plut_map15;
-            selected_flow      = flow_plut_map15;
-        }
-        else
-        if (gamemap == 16)
-        {
-            selected_linefix   = linefix_plut_map16;
-            selected_sectorfix = sectorfix_plut_map16;
-            selected_flow      = flow_plut_map16;
-            selected_fall      = fall_plut_map16;
-        }
-        else
-        if (gamemap == 17)
-        {
-            selected_sectorfix = sectorfix_plut_map17;
-            selected_flow      = flow_plut_map17;
-            selected_fall      = fall_plut_map17;
-        }
-        else
-        if (gamemap == 18)
-        {
-            selected_sectorfix = sectorfix_plut_map18;
-            selected_flow      = flow_plut_map18;
-        }
-        else
-        if (gamemap == 19)
-        {
-            selected_linefix   = linefix_plut_map19;
-            selected_sectorfix = sectorfix_plut_map19;
-            selected_flow      = flow_plut_map19;
-            selected_fall      = fall_plut_map19;
-        }
-        else
-        if (gamemap == 20)
-        {
-            selected_linefix   = linefix_plut_map20;
-            selected_sectorfix = sectorfix_plut_map20;
-            selected_flow      = flow_plut_map20;
-        }
-        else
-        if (gamemap == 21)
-        {
-            selected_sectorfix = sectorfix_plut_map21;
-            selected_flow      = flow_plut_map21;
-        }
-        else
-        if (gamemap == 22)
-        {
-            selected_linefix   = linefix_plut_map22;
-            selected_sectorfix = sectorfix_plut_map22;
-            selected_flow      = flow_plut_map22;
-            selected_fall      = fall_plut_map22;
-        }
-        else
-        if (gamemap == 23)
-        {
-            selected_linefix   = linefix_plut_map23;
-            selected_sectorfix = sectorfix_plut_map23;
-            selected_flow      = flow_plut_map23;
-            selected_fall      = fall_plut_map23;
-        }
-        else
-        if (gamemap == 24)
-        {
-            selected_linefix   = linefix_plut_map24;
-            selected_sectorfix = sectorfix_plut_map24;
-            selected_flow      = flow_plut_map24;
-            selected_fall      = fall_plut_map24;
-        }
-        else
-        if (gamemap == 25)
-        {
-            selected_linefix   = linefix_plut_map25;
-            selected_sectorfix = sectorfix_plut_map25;
-            selected_flow      = flow_plut_map25;
-        }
-        else
-        if (gamemap == 26)
-        {
-            selected_linefix   = linefix_plut_map26;
-            selected_sectorfix = sectorfix_plut_map26;
-            selected_flow      = flow_plut_map26;
-            selected_fall      = fall_plut_map26;
-        }
-        else
-        if (gamemap == 27)
-        {
-            selected_sectorfix = sectorfix_plut_map27;
-            selected_flow      = flow_plut_map27;
-        }
-        else
-        if (gamemap == 28)
-        {
-            selected_linefix   = linefix_plut_map28;
-            selected_sectorfix = sectorfix_plut_map28;
-            selected_flow      = flow_plut_map28;
-            selected_fall      = fall_plut_map28;
-        }
-        else
-        if (gamemap == 29)
-        {
-            selected_linefix   = linefix_plut_map29;
-            selected_sectorfix = sectorfix_plut_map29;
-            selected_flow      = flow_plut_map29;
-        }
-        else
-        if (gamemap == 30)
-        {
-            selected_linefix   = linefix_plut_map30;
-            selected_sectorfix = sectorfix_plut_map30;
-            selected_flow      = flow_plut_map30;
-            selected_fall      = fall_plut_map30;
-        }
-        else
-        if (gamemap == 31)
-        {
-            selected_linefix   = linefix_plut_map31;
-            selected_sectorfix = sectorfix_plut_map31;
-            selected_flow      = flow_plut_map31;
-            selected_fall      = fall_plut_map31;
-        }
-        else
-        if (gamemap == 32)
+        const mapfix_t *const mf = &mapfixes[i];
+
+        if (mf->mission == logical_gamemission
+        && (mf->episode == 0 || mf->episode == gameepisode) && mf->map == gamemap)
         {
-            selected_linefix   = linefix_plut_map32;
-            selected_sectorfix = sectorfix_plut_map32;
-            selected_flow      = flow_plut_map32;
+            if (mf->vertexfix) vertexfix = mf->vertexfix;
+            if (mf->linefix)   linefix   = mf->linefix;
+            if (mf->sectorfix) sectorfix = mf->sectorfix;
+            if (mf->flow)      flow      = mf->flow;
+            if (mf->fall)      fall      = mf->fall;
+            break;
         }
     }
-    else
-    if (logical_gamemission == pack_tnt)
+
+    // Index them.
+    keys = NULL;
+
+#define INDEX_FIXES(index, table, key)                                  \
+    for (count = 0 ; table[count].mission != -1 ; count++);             \
+    keys = I_Realloc(keys, MAX(count, 1) * sizeof(*keys));              \
+    for (int j = 0 ; j < count ; j++)                                   \
+    {                                                                   \
+        keys[j] = P_FixForMap(table[j]) ? (key) : -1;                   \
+    }                                                                   \
+    P_IndexFixes(&index, keys, count)
+
+    INDEX_FIXES(vertexfixes, vertexfix, vertexfix[j].vertex);
+    INDEX_FIXES(linefixes, linefix, linefix[j].linedef * 2 + linefix[j].side);
+    INDEX_FIXES(sectorfixes, sectorfix, sectorfix[j].sector);
+    INDEX_FIXES(flows, flow, flow[j].sector);
+    INDEX_FIXES(falls, fall, fall[j].linedef);
+
+#undef INDEX_FIXES
+
+    free(keys);
+
+    selected_vertexfix = vertexfix;
+    selected_linefix   = linefix;
+    selected_sectorfix = sectorfix;
+    selected_flow      = flow;
+    selected_fall      = fall;
+}
+
+// -----------------------------------------------------------------------------
+// P_FindVertexFix
+// Fix of a vertex that is still at the given old position, or NULL.
+// -----------------------------------------------------------------------------
+
+const vertexfix_t *P_FindVertexFix (const int vertex, const fixed_t x, const fixed_t y)
+{
+    for (int j = P_FirstFix(&vertexfixes, vertex) ; j >= 0 ; j = vertexfixes.next[j])
     {
-        if (gamemap == 1)
-        {
-            selected_linefix   = linefix_tnt_map01;
-            selected_flow      = flow_tnt_map01;
-        }
-        else
-        if (gamemap == 2)
-        {
-            selected_linefix   = linefix_tnt_map02;
-            selected_sectorfix = sectorfix_tnt_map02;
-            selected_flow      = flow_tnt_map02;
-        }
-        else
-        if (gamemap == 3)
-        {
-            selected_linefix   = linefix_tnt_map03;
-            selected_flow      = flow_tnt_map03;
-        }
-        else
-        if (gamemap == 4)
-        {
-            selected_linefix   = linefix_tnt_map04;
-            selected_sectorfix = sectorfix_tnt_map04;
-        }
-        else
-        if (gamemap == 5)
-        {
-            selected_linefix   = linefix_tnt_map05;
-            selected_sectorfix = sectorfix_tnt_map05;
-        }
-        else
-        if (gamemap == 6)
-        {
-            selected_linefix   = linefix_tnt_map06;
-            selected_sectorfix = sectorfix_tnt_map06;
-            selected_flow      = flow_tnt_map06;
-        }
-        else
-        if (gamemap == 7)
-        {
-            selected_sectorfix = sectorfix_tnt_map07;
-            selected_flow      = flow_tnt_map07;
-        }
-        else
-        if (gamemap == 8)
-        {
-            selected_sectorfix = sectorfix_tnt_map08;
-            selected_flow      = flow_tnt_map08;
-        }
-        else
-        if (gamemap == 9)
-        {
-            selected_linefix   = linefix_tnt_map09;
-            selected_sectorfix = sectorfix_tnt_map09;
-            selected_flow      = flow_tnt_map09;
-            selected_fall      = fall_tnt_map09;
-        }
-        else
-        if (gamemap == 10)
-        {
-            selected_linefix   = linefix_tnt_map10;
-            selected_sectorfix = sectorfix_tnt_map10;
-            selected_flow      = flow_tnt_map10;
-            selected_fall      = fall_tnt_map10;
-        }
-        else
-        if (gamemap == 11)
-        {
-            selected_linefix   = linefix_tnt_map11;
-            selected_sectorfix = sectorfix_tnt_map11;
-            selected_flow      = flow_tnt_map11;
-        }
-        else
-        if (gamemap == 12)
+        if (x == SHORT(selected_vertexfix[j].oldx) << FRACBITS
+        &&  y == SHORT(selected_vertexfix[j].oldy) << FRACBITS)
         {
-            selected_linefix   = linefix_tnt_map12;
-            selected_sectorfix = sectorfix_tnt_map12;
-            selected_flow      = flow_tnt_map12;
-            selected_fall      = fall_tnt_map12;
-        }
-        else
-        if (gamemap == 13)
-        {
-            selected_linefix   = linefix_tnt_map13;
-            selected_sectorfix = sectorfix_tnt_map13;
-            selected_flow      = flow_tnt_map13;
-        }
-        else
-        if (gamemap == 14)
-        {
-            selected_sectorfix = sectorfix_tnt_map14;
-            selected_flow      = flow_tnt_map14;
-            selected_fall      = fall_tnt_map14;
-        }
-        else
-        if (gamemap == 15)
-        {
-            selected_linefix   = linefix_tnt_map15;
-            selected_sectorfix = sectorfix_tnt_map15;
-            selected_flow      = flow_tnt_map15;
-        }
-        else
-        if (gamemap == 16)
-        {
-            selected_sectorfix = sectorfix_tnt_map16;
-            selected_flow      = flow_tnt_map16;
-            selected_fall      = fall_tnt_map16;
-        }
-        else
-        if (gamemap == 17)
-        {
-            selected_linefix   = linefix_tnt_map17;
-            selected_sectorfix = sectorfix_tnt_map17;
-            selected_flow      = flow_tnt_map17;
-        }
-        else
-        if (gamemap == 18)
-        {
-            selected_sectorfix = sectorfix_tnt_map18;
-            selected_flow      = flow_tnt_map18;
-        }
-        else
-        if (gamemap == 19)
-        {
-            selected_linefix   = linefix_tnt_map19;
-            selected_sectorfix = sectorfix_tnt_map19;
-            selected_flow      = flow_tnt_map19;
-        }
-        else
-        if (gamemap == 20)
-        {
-            selected_linefix   = linefix_tnt_map20;
-            selected_sectorfix = sectorfix_tnt_map20;
-            selected_flow      = flow_tnt_map20;
-            selected_fall      = fall_tnt_map20;
-        }
-        else
-        if (gamemap == 21)
-        {
-            selected_flow      = flow_tnt_map21;
-        }
-        else
-        if (gamemap == 22)
-        {
-            selected_linefix   = linefix_tnt_map22;
-            selected_sectorfix = sectorfix_tnt_map22;
-            selected_flow      = flow_tnt_map22;
-            selected_fall      = fall_tnt_map22;
-        }
-        else
-        if (gamemap == 23)
-        {
-            selected_flow      = flow_tnt_map23;
-            selected_fall      = fall_tnt_map23;
-        }
-        else
-        if (gamemap == 24)
-        {
-            selected_sectorfix = sectorfix_tnt_map24;
-            selected_flow      = flow_tnt_map24;
-        }
-        else
-        if (gamemap == 25)
-        {
-            selected_linefix   = linefix_tnt_map25;
-            selected_sectorfix = sectorfix_tnt_map25;
-            selected_flow      = flow_tnt_map25;
-        }
-        else
-        if (gamemap == 26)
-        {
-            selected_linefix   = linefix_tnt_map26;
-            selected_sectorfix = sectorfix_tnt_map26;
-            selected_flow      = flow_tnt_map26;
-            selected_fall      = fall_tnt_map26;
-        }
-        else
-        if (gamemap == 27)
-        {
-            selected_linefix   = linefix_tnt_map27;
-            selected_flow      = flow_tnt_map27;
-        }
-        else
-        if (gamemap == 28)
-        {
-            selected_sectorfix = sectorfix_tnt_map28;
-            selected_flow      = flow_tnt_map28;
-        }
-        else
-        if (gamemap == 29)
-        {
-            selected_linefix   = linefix_tnt_map29;
-            selected_sectorfix = sectorfix_tnt_map29;
-            selected_flow      = flow_tnt_map29;
-            selected_fall      = fall_tnt_map29;
-        }
-        else
-        if (gamemap == 30)
-        {
-            selected_sectorfix = sectorfix_tnt_map30;
-            selected_flow      = flow_tnt_map30;
-        }
-        else
-        if (gamemap == 31)
-        {
-            selected_linefix   = linefix_tnt_map31;
-            selected_sectorfix = sectorfix_tnt_map31;
-            selected_flow      = flow_tnt_map31;
-        }
-        else
-        if (gamemap == 32)
-        {
-            selected_linefix   = linefix_tnt_map32;
-            selected_sectorfix = sectorfix_tnt_map32;
-            selected_flow      = flow_tnt_map32;
+            return &selected_vertexfix[j];
         }
     }
+
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// P_FindLineFix, P_FindSectorFix, P_FindFlow, P_FindFall
+// Fix of a line side, sector or linedef, or NULL.
+// -----------------------------------------------------------------------------
+
+const linefix_t *P_FindLineFix (const int linedef, const int side)
+{
+    const int j = P_FirstFix(&linefixes, linedef * 2 + side);
+
+    return j >= 0 ? &selected_linefix[j] : NULL;
+}
+
+const sectorfix_t *P_FindSectorFix (const int sector)
+{
+    const int j = P_FirstFix(&sectorfixes, sector);
+
+    return j >= 0 ? &selected_sectorfix[j] : NULL;
+}
+
+const flow_t *P_FindFlow (const int sector)
+{
+    const int j = P_FirstFix(&flows, sector);
+
+    return j >= 0 ? &selected_flow[j] : NULL;
+}
+
+const fall_t *P_FindFall (const int linedef)
+{
+    const int j = P_FirstFix(&falls, linedef);
+
+    return j >= 0 ? &selected_fall[j] : NULL;
 }
@@ -542,15 +542,34 @@ extern fixed_t   bmaporgx;
 extern fixed_t   bmaporgy;      // origin of block map
 extern mobj_t  **blocklinks;    // for thing chains
 
-extern const vertexfix_t *selected_vertexfix;
-extern const linefix_t   *selected_linefix;
-extern const sectorfix_t *selected_sectorfix;
-extern const flow_t      *selected_flow;
-extern const fall_t      *selected_fall;
-
 void P_Init (void);
 void P_SetupLevel (const int episode, const int map, const skill_t skill);
+void P_StartPrefetch (const int episode, const int map);
+void P_PrefetchTicker (void);
+void P_CancelPrefetch (void);
 void P_SetupFixes (const int episode, const int map);
+const vertexfix_t *P_FindVertexFix (const int vertex, const fixed_t x, const fixed_t y);
+const linefix_t   *P_FindLineFix (const int linedef, const int side);
+const sectorfix_t *P_FindSectorFix (const int sector);
+const flow_t      *P_FindFlow (const int sector);
+const fall_t      *P_FindFall (const int linedef);
+
+// -----------------------------------------------------------------------------
+// P_PROFILE
+// -----------------------------------------------------------------------------
+
+extern boolean levelprofile;
+
+void P_StartLevelProfile (const char *dir);
+void P_InitLevelProfile (const char *lumpname);
+void P_WriteLevelProfile (void);
+uint64_t P_ProfileStartFrame (void);
+void P_ProfileSubsector (const sector_t *sector, const int sprites,
+                         const int drawsegs, const int visplanes);
+void P_ProfileFrame (const uint64_t start);
+void P_ProfileThinker (thinker_t *thinker);
+void P_ProfileSight (const mobj_t *looker);
+int  P_ProfileHeat (const int bx, const int by);
 
 // -----------------------------------------------------------------------------
 // P_SIGHT
@@ -573,6 +592,7 @@ const fixed_t P_FindLowestFloorSurrounding (const sector_t *sec);
 const fixed_t P_FindNextHighestFloor (const sector_t *sec, const int currentheight);
 const int P_FindMinSurroundingLight (const sector_t *sector, const int max);
 const int P_FindSectorFromLineTag (const line_t *line, const int start);
+void P_InitTagIndex (void);
 const int twoSided (const int sector, const int line);
 int EV_DoDonut (line_t *line);
 sector_t *getNextSector (const line_t *line, const sector_t *sec);
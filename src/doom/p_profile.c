@@ -0,0 +1,338 @@
+//
+// Copyright(C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Level profile, enabled with -levelprofile.
+//	Records what drawing and running each part of a level costs, by
+//	sector and by blockmap cell, and writes it out when the level ends:
+//	a table of both, and a heatmap of the time taken to draw a frame
+//	from each cell.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#include "doomstat.h"
+#include "i_system.h"
+#include "m_misc.h"
+#include "p_local.h"
+#include "z_zone.h"
+#include "jn.h"
+
+
+typedef struct
+{
+    unsigned int frames;     // frames drawn with the view here
+    unsigned int sprites;    // sprites projected
+    unsigned int drawsegs;
+    unsigned int visplanes;  // visplanes created
+    unsigned int sights;     // sight checks by things here
+    unsigned int thinkers;   // things updated here
+    uint64_t     drawtime;   // in performance counter ticks
+    uint64_t     thinktime;
+} profile_t;
+
+boolean levelprofile;
+
+static const char *profiledir;
+static char        profilemap[9];   // map being profiled, or empty
+
+static profile_t  *sectorprofiles;
+static profile_t  *cellprofiles;
+static profile_t   otherprofile;    // thinkers that are not things
+static profile_t   frameprofile;    // counts of the frame being drawn
+static uint64_t    maxframetime;    // highest frame time of a cell
+
+// -----------------------------------------------------------------------------
+// P_StartLevelProfile
+// Called once at startup, with the directory to write the profiles in.
+// -----------------------------------------------------------------------------
+
+void P_StartLevelProfile (const char *dir)
+{
+    profiledir = dir;
+    M_MakeDirectory((char *) dir);
+    levelprofile = true;
+
+    I_AtExit(P_WriteLevelProfile, true);
+}
+
+// -----------------------------------------------------------------------------
+// P_InitLevelProfile
+// Called once a level is loaded.
+// -----------------------------------------------------------------------------
+
+void P_InitLevelProfile (const char *lumpname)
+{
+    const int numcells = bmapwidth * bmapheight;
+
+    if (!levelprofile)
+    {
+        return;
+    }
+
+    sectorprofiles = Z_Malloc(numsectors * sizeof(*sectorprofiles), PU_LEVEL, 0);
+    cellprofiles = Z_Malloc(numcells * sizeof(*cellprofiles), PU_LEVEL, 0);
+    memset(sectorprofiles, 0, numsectors * sizeof(*sectorprofiles));
+    memset(cellprofiles, 0, numcells * sizeof(*cellprofiles));
+    memset(&otherprofile, 0, sizeof(otherprofile));
+    memset(&frameprofile, 0, sizeof(frameprofile));
+    maxframetime = 0;
+
+    M_StringCopy(profilemap, lumpname, sizeof(profilemap));
+}
+
+// -----------------------------------------------------------------------------
+// P_ProfileCell
+// Blockmap cell at a map position, or NULL if outside the blockmap.
+// -----------------------------------------------------------------------------
+
+static profile_t *P_ProfileCell (const fixed_t x, const fixed_t y)
+{
+    const int bx = (x - bmaporgx) >> MAPBLOCKSHIFT;
+    const int by = (y - bmaporgy) >> MAPBLOCKSHIFT;
+
+    if (bx < 0 || by < 0 || bx >= bmapwidth || by >= bmapheight)
+    {
+        return NULL;
+    }
+
+    return &cellprofiles[by * bmapwidth + bx];
+}
+
+static void P_AddProfile (profile_t *to, const profile_t *from)
+{
+    to->frames += from->frames;
+    to->sprites += from->sprites;
+    to->drawsegs += from->drawsegs;
+    to->visplanes += from->visplanes;
+    to->sights += from->sights;
+    to->thinkers += from->thinkers;
+    to->drawtime += from->drawtime;
+    to->thinktime += from->thinktime;
+}
+
+// -----------------------------------------------------------------------------
+// P_ProfileStartFrame, P_ProfileSubsector, P_ProfileFrame
+// The renderer reports what each subsector it draws costs. Frame totals
+// and the frame time go to the cell and the sector the view is in.
+// -----------------------------------------------------------------------------
+
+uint64_t P_ProfileStartFrame (void)
+{
+    memset(&frameprofile, 0, sizeof(frameprofile));
+
+    return SDL_GetPerformanceCounter();
+}
+
+void P_ProfileSubsector (const sector_t *sector, const int sprites,
+                         const int drawsegs, const int visplanes)
+{
+    profile_t *const sp = &sectorprofiles[sector - sectors];
+
+    sp->sprites += sprites;
+    sp->drawsegs += drawsegs;
+    sp->visplanes += visplanes;
+
+    frameprofile.sprites += sprites;
+    frameprofile.drawsegs += drawsegs;
+    frameprofile.visplanes += visplanes;
+}
+
+void P_ProfileFrame (const uint64_t start)
+{
+    profile_t *const cell = P_ProfileCell(viewx, viewy);
+    sector_t  *const sector = R_PointInSubsector(viewx, viewy)->sector;
+
+    frameprofile.frames = 1;
+    frameprofile.drawtime = SDL_GetPerformanceCounter() - start;
+
+    sectorprofiles[sector - sectors].frames++;
+    sectorprofiles[sector - sectors].drawtime += frameprofile.drawtime;
+
+    if (cell != NULL)
+    {
+        P_AddProfile(cell, &frameprofile);
+        maxframetime = MAX(maxframetime, cell->drawtime / cell->frames);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// P_ProfileThinker
+// Runs a thinker and records the time it took to where it started from.
+// -----------------------------------------------------------------------------
+
+void P_ProfileThinker (thinker_t *thinker)
+{
+    profile_t *cell = NULL;
+    profile_t *sector = &otherprofile;
+    uint64_t   start, time;
+
+    // Things may be removed by their own thinker, look where they are first.
+    if (thinker->function.acp1 == (actionf_p1)P_MobjThinker)
+    {
+        const mobj_t *mo = (mobj_t *) thinker;
+
+        cell = P_ProfileCell(mo->x, mo->y);
+        sector = &sectorprofiles[mo->subsector->sector - sectors];
+    }
+
+    start = SDL_GetPerformanceCounter();
+    thinker->function.acp1(thinker);
+    time = SDL_GetPerformanceCounter() - start;
+
+    sector->thinkers++;
+    sector->thinktime += time;
+
+    if (cell != NULL)
+    {
+        cell->thinkers++;
+        cell->thinktime += time;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// P_ProfileSight
+// Counts a sight check, to where the looker is.
+// -----------------------------------------------------------------------------
+
+void P_ProfileSight (const mobj_t *looker)
+{
+    profile_t *const cell = P_ProfileCell(looker->x, looker->y);
+
+    sectorprofiles[looker->subsector->sector - sectors].sights++;
+
+    if (cell != NULL)
+    {
+        cell->sights++;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// P_ProfileHeat
+// For the automap: how long frames drawn from a cell take, from 0 if none
+// were drawn there to 4 for the slowest cell so far.
+// -----------------------------------------------------------------------------
+
+int P_ProfileHeat (const int bx, const int by)
+{
+    const profile_t *const cell = &cellprofiles[by * bmapwidth + bx];
+
+    if (!cell->frames || !maxframetime)
+    {
+        return 0;
+    }
+
+    return 1 + (int) (cell->drawtime / cell->frames * 3 / maxframetime);
+}
+
+// -----------------------------------------------------------------------------
+// P_WriteLevelProfile
+// Writes <map>.csv with the counts and times of the sectors and cells,
+// and <map>.pgm, a heatmap of the frame time from each cell, north up.
+// Called when the next level is loaded, and on exit.
+// -----------------------------------------------------------------------------
+
+static void P_WriteProfileRow (FILE *file, const char *kind, const int index,
+                               const int x, const int y, const profile_t *p,
+                               const uint64_t freq)
+{
+    if (!p->frames && !p->sprites && !p->drawsegs && !p->sights && !p->thinkers)
+    {
+        return;
+    }
+
+    fprintf(file, "%s,%d,%d,%d,%u,%u,%u,%u,%u,%u,%llu,%llu\n",
+            kind, index, x, y, p->frames, p->sprites, p->drawsegs,
+            p->visplanes, p->sights, p->thinkers,
+            (unsigned long long) (p->drawtime * 1000000 / freq),
+            (unsigned long long) (p->thinktime * 1000000 / freq));
+}
+
+void P_WriteLevelProfile (void)
+{
+    const uint64_t freq = SDL_GetPerformanceFrequency();
+    char *filename;
+    FILE *file;
+    int   i;
+
+    if (!levelprofile || !profilemap[0])
+    {
+        return;
+    }
+
+    filename = M_StringJoin(profiledir, DIR_SEPARATOR_S, profilemap, ".csv", NULL);
+    file = M_fopen(filename, "w");
+
+    if (file != NULL)
+    {
+        fprintf(file, "kind,index,x,y,frames,sprites,drawsegs,visplanes,"
+                      "sights,thinkers,draw_us,think_us\n");
+
+        // Sector rows are placed at their sound origin.
+        for (i = 0 ; i < numsectors ; i++)
+        {
+            P_WriteProfileRow(file, "sector", i,
+                              sectors[i].soundorg.x >> FRACBITS,
+                              sectors[i].soundorg.y >> FRACBITS,
+                              &sectorprofiles[i], freq);
+        }
+
+        // Cell rows are placed at their lower left corner.
+        for (i = 0 ; i < bmapwidth * bmapheight ; i++)
+        {
+            P_WriteProfileRow(file, "cell", i,
+                              (bmaporgx >> FRACBITS) + (i % bmapwidth) * MAPBLOCKUNITS,
+                              (bmaporgy >> FRACBITS) + (i / bmapwidth) * MAPBLOCKUNITS,
+                              &cellprofiles[i], freq);
+        }
+
+        P_WriteProfileRow(file, "other", 0, 0, 0, &otherprofile, freq);
+        fclose(file);
+
+        printf(english_language ?
+               "P_WriteLevelProfile: %s written to %s.\n" :
+               "P_WriteLevelProfile: %s записан в %s.\n", profilemap, filename);
+    }
+
+    free(filename);
+
+    filename = M_StringJoin(profiledir, DIR_SEPARATOR_S, profilemap, ".pgm", NULL);
+    file = M_fopen(filename, "wb");
+
+    if (file != NULL)
+    {
+        fprintf(file, "P5\n%d %d\n255\n", bmapwidth, bmapheight);
+
+        for (int by = bmapheight - 1 ; by >= 0 ; by--)
+        {
+            for (int bx = 0 ; bx < bmapwidth ; bx++)
+            {
+                const profile_t *const cell = &cellprofiles[by * bmapwidth + bx];
+
+                fputc(cell->frames && maxframetime ?
+                      MIN(255, cell->drawtime / cell->frames * 255 / maxframetime) : 0,
+                      file);
+            }
+        }
+
+        fclose(file);
+    }
+
+    free(filename);
+    profilemap[0] = '\0';
+}
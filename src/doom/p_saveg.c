@@ -1710,6 +1710,9 @@ void P_UnArchiveWorld (void)
     b = saveg_read8();
     c = saveg_read8();
     totalleveltimes = (a<<16) + (b<<8) + c;
+
+    // Sector tags may have been changed
+    P_InitTagIndex();
 }
 
 
@@ -21,11 +21,14 @@
 
 #include <math.h>
 
+#include "am_map.h"
 #include "i_swap.h"
 #include "m_argv.h"
 #include "m_bbox.h"
 #include "g_game.h"
+#include "i_jobs.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "p_local.h"
 #include "s_sound.h"
 #include "doomstat.h"
@@ -52,6 +55,9 @@ int          numsubsectors;
 subsector_t *subsectors;
 int       numnodes;
 node_t   *nodes;
+bspnode_t *bspnodes;
+fixed_t  (*bspbboxes)[2][4];
+bspseg_t  *bspsegs;
 int       numlines;
 line_t   *lines;
 int       numsides;
@@ -398,18 +404,12 @@ static void P_LoadVertexes (const int lump)
         // [BH] Apply any map-specific fixes.
         if (canmodify && fix_map_errors)
         {
-            for (int j = 0; selected_vertexfix[j].mission != -1; j++)
-            {
-                if (i == selected_vertexfix[j].vertex && gamemission == selected_vertexfix[j].mission
-                && gameepisode == selected_vertexfix[j].epsiode && gamemap == selected_vertexfix[j].map
-                && vertexes[i].x == SHORT(selected_vertexfix[j].oldx) << FRACBITS
-                && vertexes[i].y == SHORT(selected_vertexfix[j].oldy) << FRACBITS)
-                {
-                    vertexes[i].px = SHORT(selected_vertexfix[j].newx) << FRACBITS;
-                    vertexes[i].py = SHORT(selected_vertexfix[j].newy) << FRACBITS;
+            const vertexfix_t *fix = P_FindVertexFix(i, vertexes[i].x, vertexes[i].y);
 
-                    break;
-                }
+            if (fix)
+            {
+                vertexes[i].px = SHORT(fix->newx) << FRACBITS;
+                vertexes[i].py = SHORT(fix->newy) << FRACBITS;
             }
         }
 
@@ -523,42 +523,37 @@ static void P_LoadSegs (const int lump)
         // [BH] Apply any map-specific fixes.
         if (canmodify && fix_map_errors)
         {
-            for (int j = 0; selected_linefix[j].mission != -1; j++)
+            const linefix_t *fix = P_FindLineFix(linedef_id, side);
+
+            if (fix)
             {
-                if (linedef_id == selected_linefix[j].linedef && gamemission == selected_linefix[j].mission
-                    && gameepisode == selected_linefix[j].epsiode && gamemap == selected_linefix[j].map
-                    && side == selected_linefix[j].side)
+                if (*fix->toptexture)
                 {
-                    if (*selected_linefix[j].toptexture)
-                    {
-                        li->sidedef->toptexture = R_TextureNumForName(selected_linefix[j].toptexture);
-                    }
-                    if (*selected_linefix[j].middletexture)
-                    {
-                        li->sidedef->midtexture = R_TextureNumForName(selected_linefix[j].middletexture);
-                    }
-                    if (*selected_linefix[j].bottomtexture)
-                    {
-                        li->sidedef->bottomtexture = R_TextureNumForName(selected_linefix[j].bottomtexture);
-                    }
-                    if (selected_linefix[j].offset != DEFAULT)
-                    {
-                        li->offset = SHORT(selected_linefix[j].offset) << FRACBITS;
-                        li->sidedef->textureoffset = 0;
-                    }
-                    if (selected_linefix[j].rowoffset != DEFAULT)
-                    {
-                        li->sidedef->rowoffset = SHORT(selected_linefix[j].rowoffset) << FRACBITS;
-                    }
-                    if (selected_linefix[j].flags != DEFAULT)
-                    {
-                        if (li->linedef->flags & selected_linefix[j].flags)
-                            li->linedef->flags &= ~selected_linefix[j].flags;
-                        else
-                            li->linedef->flags |= selected_linefix[j].flags;
-                    }
-
-                    break;
+                    li->sidedef->toptexture = R_TextureNumForName(fix->toptexture);
+                }
+                if (*fix->middletexture)
+                {
+                    li->sidedef->midtexture = R_TextureNumForName(fix->middletexture);
+                }
+                if (*fix->bottomtexture)
+                {
+                    li->sidedef->bottomtexture = R_TextureNumForName(fix->bottomtexture);
+                }
+                if (fix->offset != DEFAULT)
+                {
+                    li->offset = SHORT(fix->offset) << FRACBITS;
+                    li->sidedef->textureoffset = 0;
+                }
+                if (fix->rowoffset != DEFAULT)
+                {
+                    li->sidedef->rowoffset = SHORT(fix->rowoffset) << FRACBITS;
+                }
+                if (fix->flags != DEFAULT)
+                {
+                    if (li->linedef->flags & fix->flags)
+                        li->linedef->flags &= ~fix->flags;
+                    else
+                        li->linedef->flags |= fix->flags;
                 }
             }
         }
@@ -655,6 +650,41 @@ static void P_SegLengths (void)
     }
 }
 
+// -----------------------------------------------------------------------------
+// P_InitBSPTree
+// Copy what the BSP walks read into bspnodes, bspbboxes and bspsegs.
+// Must follow P_RemoveSlimeTrails, which moves the pseudovertexes.
+// -----------------------------------------------------------------------------
+
+static void P_InitBSPTree (void)
+{
+    bspnodes = Z_Malloc(numnodes * sizeof(*bspnodes), PU_LEVEL, 0);
+    bspbboxes = Z_Malloc(numnodes * sizeof(*bspbboxes), PU_LEVEL, 0);
+    bspsegs = Z_Malloc(numsegs * sizeof(*bspsegs), PU_LEVEL, 0);
+
+    for (int i = 0 ; i < numnodes ; i++)
+    {
+        const node_t *no = &nodes[i];
+        bspnode_t *bsp = &bspnodes[i];
+
+        bsp->x = no->x;
+        bsp->y = no->y;
+        bsp->dx = no->dx;
+        bsp->dy = no->dy;
+        bsp->children[0] = no->children[0];
+        bsp->children[1] = no->children[1];
+        memcpy(bspbboxes[i], no->bbox, sizeof(no->bbox));
+    }
+
+    for (int i = 0 ; i < numsegs ; i++)
+    {
+        bspsegs[i].x1 = segs[i].v1->px;
+        bspsegs[i].y1 = segs[i].v1->py;
+        bspsegs[i].x2 = segs[i].v2->px;
+        bspsegs[i].y2 = segs[i].v2->py;
+    }
+}
+
 // -----------------------------------------------------------------------------
 // P_LoadSubsectors
 // -----------------------------------------------------------------------------
@@ -756,42 +786,37 @@ static void P_LoadSectors (const int lump)
         {
             if (fix_map_errors)
             {
-                for (int j = 0; selected_sectorfix[j].mission != -1; j++)
+                const sectorfix_t *fix = P_FindSectorFix(i);
+
+                if (fix)
                 {
-                    if (i == selected_sectorfix[j].sector && gamemission == selected_sectorfix[j].mission
-                    && gameepisode == selected_sectorfix[j].epsiode && gamemap == selected_sectorfix[j].map)
+                    if (*fix->floorpic)
+                    {
+                        ss->floorpic = R_FlatNumForName(fix->floorpic);
+                    }
+                    if (*fix->ceilingpic)
                     {
-                        if (*selected_sectorfix[j].floorpic)
-                        {
-                            ss->floorpic = R_FlatNumForName(selected_sectorfix[j].floorpic);
-                        }
-                        if (*selected_sectorfix[j].ceilingpic)
-                        {
-                            ss->ceilingpic = R_FlatNumForName(selected_sectorfix[j].ceilingpic);
-                        }
-
-                        break;
+                        ss->ceilingpic = R_FlatNumForName(fix->ceilingpic);
                     }
                 }
             }
 
             // [JN] Inject flow effect to swirling liquids.
-            for (int j = 0; selected_flow[j].mission != -1; j++)
             {
-                if (i == selected_flow[j].sector && gamemission == selected_flow[j].mission
-                && gameepisode == selected_flow[j].epsiode && gamemap == selected_flow[j].map)
+                const flow_t *flow = P_FindFlow(i);
+
+                if (flow && flow->flow)
                 {
-                    if (selected_flow[j].flow)
-                    {
-                        ss->flow = SHORT(selected_flow[j].flow);
-                    }
-                    break;
+                    ss->flow = SHORT(flow->flow);
                 }
             }
         }
     }
 
     W_ReleaseLumpNum(lump);
+
+    // Drop interpolation snapshot of the previous level's sectors.
+    R_ClearInterpolation();
 }
 
 // -----------------------------------------------------------------------------
@@ -906,6 +931,66 @@ static void P_LoadNodes_DeePBSP (const int lump)
     W_ReleaseLumpNum(lump);
 }
 
+// -----------------------------------------------------------------------------
+// P_ReadZNodes
+// Reads the next len bytes of a ZDBSP nodes lump into dest. Compressed
+// nodes are inflated straight into dest, so the whole lump never has to be
+// decompressed into memory at once.
+// -----------------------------------------------------------------------------
+
+// Size of the chunks lump records are read in.
+#define ZNODES_CHUNK 4096
+
+typedef struct
+{
+    const byte *data;       // uncompressed nodes: next byte to read
+    const byte *end;        //  and the end of the lump
+    z_stream   *zstream;    // compressed nodes
+} znodes_t;
+
+static void P_ReadZNodes (znodes_t *const zn, void *const dest, const size_t len)
+{
+    if (zn->zstream)
+    {
+        int err;
+
+        zn->zstream->next_out = dest;
+        zn->zstream->avail_out = len;
+
+        while (zn->zstream->avail_out > 0)
+        {
+            if ((err = inflate(zn->zstream, Z_SYNC_FLUSH)) != Z_OK
+            && (err != Z_STREAM_END || zn->zstream->avail_out > 0))
+            {
+                I_QuitWithError(english_language ?
+                                "P_LoadNodes: Error during ZDBSP nodes decompression!" :
+                                "P_LoadNodes: ошибка при распаковке нодов ZDBSP!");
+            }
+        }
+    }
+    else
+    {
+        if (len > (size_t)(zn->end - zn->data))
+        {
+            I_QuitWithError(english_language ?
+                            "P_LoadNodes: ZDBSP nodes lump is truncated!" :
+                            "P_LoadNodes: блок нодов ZDBSP обрезан!");
+        }
+
+        memcpy(dest, zn->data, len);
+        zn->data += len;
+    }
+}
+
+static unsigned int P_ReadZNodesCount (znodes_t *const zn)
+{
+    unsigned int count;
+
+    P_ReadZNodes(zn, &count, sizeof(count));
+
+    return count;
+}
+
 // -----------------------------------------------------------------------------
 // P_LoadNodes_ZDBSP
 // [crispy] support maps with compressed or uncompressed ZDBSP nodes
@@ -916,13 +1001,16 @@ static void P_LoadNodes_DeePBSP (const int lump)
 // - inlined P_LoadZSegs()
 // - added support for compressed ZDBSP nodes
 // - added support for flipped levels
+// Records are read in chunks, straight into the level arrays.
 // -----------------------------------------------------------------------------
 
 static void P_LoadNodes_ZDBSP (const int lump, const boolean compressed)
 {
     byte *data;
-    unsigned int i;
-    byte *output;
+    unsigned int i, j, n;
+    znodes_t zn;
+    // Chunk buffer for the records, aligned for all of them
+    unsigned int chunk[ZNODES_CHUNK / sizeof(unsigned int)];
 
     unsigned int orgVerts, newVerts;
     unsigned int numSubs, currSeg;
@@ -930,85 +1018,37 @@ static void P_LoadNodes_ZDBSP (const int lump, const boolean compressed)
     unsigned int numNodes;
     vertex_t *newvertarray = NULL;
 
-    data = W_CacheLumpNum(lump, PU_LEVEL);
+    data = W_CacheLumpNum(lump, PU_STATIC);
+
+    // 0. Set up decompression of the nodes lump (or simply skip header)
 
-    // 0. Uncompress nodes lump (or simply skip header)
+    memset(&zn, 0, sizeof(zn));
 
     if (compressed)
     {
-        int len =  W_LumpLength(lump);
-        int outlen, err;
-        z_stream *zstream;
-
-        // first estimate for compression rate:
-        // output buffer size == 2.5 * input size
-        outlen = 2.5 * len;
-        output = Z_Malloc(outlen, PU_STATIC, 0);
+        zn.zstream = malloc(sizeof(*zn.zstream));
+        memset(zn.zstream, 0, sizeof(*zn.zstream));
+        zn.zstream->next_in = data + 4;
+        zn.zstream->avail_in = W_LumpLength(lump) - 4;
 
-        // initialize stream state for decompression
-        zstream = malloc(sizeof(*zstream));
-        memset(zstream, 0, sizeof(*zstream));
-        zstream->next_in = data + 4;
-        zstream->avail_in = len - 4;
-        zstream->next_out = output;
-        zstream->avail_out = outlen;
-
-        if (inflateInit(zstream) != Z_OK)
+        if (inflateInit(zn.zstream) != Z_OK)
         {
             I_QuitWithError(english_language ?
                             "P_LoadNodes: Error during ZDBSP nodes decompression initialization!" :
                             "P_LoadNodes: ошибка при инициализации распаковки нодов ZDBSP!");
         }
-
-        // resize if output buffer runs full
-        while ((err = inflate(zstream, Z_SYNC_FLUSH)) == Z_OK)
-        {
-            int outlen_old = outlen;
-            outlen = 2 * outlen_old;
-            output = I_Realloc(output, outlen);
-            zstream->next_out = output + outlen_old;
-            zstream->avail_out = outlen - outlen_old;
-        }
-
-        if (err != Z_STREAM_END)
-        {
-            I_QuitWithError(english_language ?
-                            "P_LoadNodes: Error during ZDBSP nodes decompression!" :
-                            "P_LoadNodes: ошибка при распаковке нодов ZDBSP!");
-        }
-
-        printf(english_language ?
-                "P_LoadNodes: ZDBSP nodes compression ratio %.3f\n" :
-                "P_LoadNodes: степень сжатия нодов ZDBSP: %.3f\n",
-                (float)zstream->total_out/zstream->total_in);
-
-        data = output;
-        len = zstream->total_out;
-
-        if (inflateEnd(zstream) != Z_OK)
-        {
-            I_QuitWithError(english_language ?
-                            "P_LoadNodes: Error during ZDBSP nodes decompression shut-down!" :
-                            "P_LoadNodes: ошибка при завершении распаковки нодов ZDBSP!");
-        }
-
-        // release the original data lump
-        W_ReleaseLumpNum(lump);
-        free(zstream);
     }
     else
     {
         // skip header
-        data += 4;
+        zn.data = data + 4;
+        zn.end = data + W_LumpLength(lump);
     }
 
     // 1. Load new vertices added during node building
 
-    orgVerts = *((unsigned int*)data);
-    data += sizeof(orgVerts);
-
-    newVerts = *((unsigned int*)data);
-    data += sizeof(newVerts);
+    orgVerts = P_ReadZNodesCount(&zn);
+    newVerts = P_ReadZNodesCount(&zn);
 
     if (orgVerts + newVerts == (unsigned int)numvertexes)
     {
@@ -1021,15 +1061,21 @@ static void P_LoadNodes_ZDBSP (const int lump, const boolean compressed)
         memcpy(newvertarray, vertexes, orgVerts * sizeof(vertex_t));
     }
 
-    for (i = 0; i < newVerts; i++)
+    for (i = 0; i < newVerts; i += n)
     {
-        newvertarray[i + orgVerts].px =
-        newvertarray[i + orgVerts].x = *((unsigned int*)data);
-        data += sizeof(newvertarray[0].x);
+        const fixed_t *mv = (fixed_t *) chunk;
 
-        newvertarray[i + orgVerts].py =
-        newvertarray[i + orgVerts].y = *((unsigned int*)data);
-        data += sizeof(newvertarray[0].y);
+        n = MIN(newVerts - i, ZNODES_CHUNK / (2 * sizeof(fixed_t)));
+        P_ReadZNodes(&zn, chunk, n * 2 * sizeof(fixed_t));
+
+        for (j = 0; j < n; j++, mv += 2)
+        {
+            newvertarray[i + j + orgVerts].px =
+            newvertarray[i + j + orgVerts].x = mv[0];
+
+            newvertarray[i + j + orgVerts].py =
+            newvertarray[i + j + orgVerts].y = mv[1];
+        }
     }
 
     if (vertexes != newvertarray)
@@ -1047,8 +1093,7 @@ static void P_LoadNodes_ZDBSP (const int lump, const boolean compressed)
 
     // 2. Load subsectors
 
-    numSubs = *((unsigned int*)data);
-    data += sizeof(numSubs);
+    numSubs = P_ReadZNodesCount(&zn);
 
     if (numSubs < 1)
     {
@@ -1060,21 +1105,24 @@ static void P_LoadNodes_ZDBSP (const int lump, const boolean compressed)
     numsubsectors = numSubs;
     subsectors = Z_Malloc(numsubsectors * sizeof(subsector_t), PU_LEVEL, 0);
 
-    for (i = currSeg = 0; i < numsubsectors; i++)
+    for (i = currSeg = 0; i < numsubsectors; i += n)
     {
-        mapsubsector_zdbsp_t *mseg = (mapsubsector_zdbsp_t*) data + i;
+        const mapsubsector_zdbsp_t *mseg = (mapsubsector_zdbsp_t *) chunk;
 
-        subsectors[i].firstline = currSeg;
-        subsectors[i].numlines = mseg->numsegs;
-        currSeg += mseg->numsegs;
-    }
+        n = MIN(numsubsectors - i, ZNODES_CHUNK / sizeof(mapsubsector_zdbsp_t));
+        P_ReadZNodes(&zn, chunk, n * sizeof(mapsubsector_zdbsp_t));
 
-    data += numsubsectors * sizeof(mapsubsector_zdbsp_t);
+        for (j = 0; j < n; j++, mseg++)
+        {
+            subsectors[i + j].firstline = currSeg;
+            subsectors[i + j].numlines = mseg->numsegs;
+            currSeg += mseg->numsegs;
+        }
+    }
 
     // 3. Load segs
 
-    numSegs = *((unsigned int*)data);
-    data += sizeof(numSegs);
+    numSegs = P_ReadZNodesCount(&zn);
 
     // The number of stored segs should match the number of segs used by subsectors
     if (numSegs != currSeg)
@@ -1087,13 +1135,20 @@ static void P_LoadNodes_ZDBSP (const int lump, const boolean compressed)
     numsegs = numSegs;
     segs = Z_Malloc(numsegs * sizeof(seg_t), PU_LEVEL, 0);
 
+    n = ZNODES_CHUNK / sizeof(mapseg_zdbsp_t);
+
     for (i = 0; i < numsegs; i++)
     {
         line_t *ldef;
         unsigned int linedef_id;
         unsigned char side;
         seg_t *li = segs + i;
-        mapseg_zdbsp_t *ml = (mapseg_zdbsp_t *) data + i;
+        const mapseg_zdbsp_t *ml = (mapseg_zdbsp_t *) chunk + i % n;
+
+        if (i % n == 0)
+        {
+            P_ReadZNodes(&zn, chunk, MIN(numsegs - i, n) * sizeof(mapseg_zdbsp_t));
+        }
 
         li->v1 = &vertexes[ml->v1];
         li->v2 = &vertexes[ml->v2];
@@ -1138,21 +1193,25 @@ static void P_LoadNodes_ZDBSP (const int lump, const boolean compressed)
         }
     }
 
-    data += numsegs * sizeof(mapseg_zdbsp_t);
-
     // 4. Load nodes
 
-    numNodes = *((unsigned int*)data);
-    data += sizeof(numNodes);
+    numNodes = P_ReadZNodesCount(&zn);
 
     numnodes = numNodes;
     nodes = Z_Malloc(numnodes * sizeof(node_t), PU_LEVEL, 0);
 
+    n = ZNODES_CHUNK / sizeof(mapnode_zdbsp_t);
+
     for (i = 0; i < numnodes; i++)
     {
         int j, k;
         node_t *no = nodes + i;
-        mapnode_zdbsp_t *mn = (mapnode_zdbsp_t *) data + i;
+        const mapnode_zdbsp_t *mn = (mapnode_zdbsp_t *) chunk + i % n;
+
+        if (i % n == 0)
+        {
+            P_ReadZNodes(&zn, chunk, MIN(numnodes - i, n) * sizeof(mapnode_zdbsp_t));
+        }
 
         no->x = SHORT(mn->x) << FRACBITS;
         no->y = SHORT(mn->y) << FRACBITS;
@@ -1168,12 +1227,24 @@ static void P_LoadNodes_ZDBSP (const int lump, const boolean compressed)
         }
     }
 
-    W_ReleaseLumpNum(lump);
-
     if (compressed)
     {
-        Z_Free(output);
+        printf(english_language ?
+                "P_LoadNodes: ZDBSP nodes compression ratio %.3f\n" :
+                "P_LoadNodes: степень сжатия нодов ZDBSP: %.3f\n",
+                (float)zn.zstream->total_out/zn.zstream->total_in);
+
+        if (inflateEnd(zn.zstream) != Z_OK)
+        {
+            I_QuitWithError(english_language ?
+                            "P_LoadNodes: Error during ZDBSP nodes decompression shut-down!" :
+                            "P_LoadNodes: ошибка при завершении распаковки нодов ZDBSP!");
+        }
+
+        free(zn.zstream);
     }
+
+    W_ReleaseLumpNum(lump);
 }
 
 // -----------------------------------------------------------------------------
@@ -1398,17 +1469,11 @@ static void P_LoadLineDefs (const int lump)
         // [JN] Inject fall effect to liquid linedefs on vanilla maps.
         if (canmodify)
         {
-            for (int j = 0; selected_fall[j].mission != -1; j++)
+            const fall_t *fall = P_FindFall(i);
+
+            if (fall && fall->fall)
             {
-                if (i == selected_fall[j].linedef && gamemission == selected_fall[j].mission
-                && gameepisode == selected_fall[j].epsiode && gamemap == selected_fall[j].map)
-                {
-                    if (selected_fall[j].fall)
-                    {
-                        ld->fall = SHORT(selected_fall[j].fall);
-                    }
-                    break;
-                }
+                ld->fall = SHORT(fall->fall);
             }
         }
     }
@@ -1568,9 +1633,179 @@ static void P_LoadSideDefs (const int lump)
 // -----------------------------------------------------------------------------
 // P_CreateBlockMap
 // [crispy] taken from mbfsrc/P_SETUP.C:547-707, slightly adapted
+//
+// Split in three parts, so the blockmap can be built on a worker thread
+// while the nodes and segs are loaded:
+//  - P_StartBlockMap finds the limits of the map and takes a copy of the
+//    linedef coordinates, so the job does not depend on the vertexes
+//    (ZDBSP nodes reallocate them and repoint the lines).
+//  - P_BlockMapJob builds the whole blockmap lump in its own malloc'd
+//    memory, never the zone.
+//  - P_FinishBlockMap waits for the job and copies the lump to the zone.
+//
+// The blocklists are built with a counting sort: one pass over the
+// linedefs counts the lines of each block, the next one stores them
+// straight into their place in the lump. No list is ever reallocated.
 // -----------------------------------------------------------------------------
 
-static void P_CreateBlockMap (void)
+typedef struct
+{
+    int     *coords;    // x1, y1, dx, dy, x2, y2 of each linedef, in map units
+    int      numlines;
+    int      minx, miny;
+    int      width;
+    unsigned tot;       // size of blockmap
+    int32_t *lump;      // the built blockmap lump
+    int      count;     //  and its size
+} bmapjob_t;
+
+static bmapjob_t bmapjob;
+
+// -----------------------------------------------------------------------------
+// P_BlockMapLine
+// Walks the blocks linedef i passes through. Without lump, counts the line
+// in each block. With it, stores the line in each block, filling each
+// block's list backwards from the end offset in ends.
+// -----------------------------------------------------------------------------
+
+static void P_BlockMapLine (const bmapjob_t *const job, const int i,
+                            int *const ends, int32_t *const lump)
+{
+    const int *const c = &job->coords[i * 6];
+    const unsigned tot = job->tot;
+    int x, y, adx, ady, bend;
+    int dx, dy, diff, b;
+
+    // Map the starting and ending vertices to blocks.
+    //
+    // Starting in the starting vertex's block, do:
+    //
+    //   Add linedef to current block's list.
+    //
+    //   If current block is the same as the ending vertex's block, exit loop.
+    //
+    //   Move to an adjacent block by moving towards the ending block in
+    //   either the x or y direction, to the block which contains the linedef.
+
+    // starting coordinates
+    x = c[0] - job->minx;
+    y = c[1] - job->miny;
+
+    // x-y deltas
+    adx = c[2], dx = adx < 0 ? -1 : 1;
+    ady = c[3], dy = ady < 0 ? -1 : 1;
+
+    // difference in preferring to move across y (>0) instead of x (<0)
+    diff = !adx ? 1 : !ady ? -1 :
+    (((x >> MAPBTOFRAC) << MAPBTOFRAC) +
+    (dx > 0 ? MAPBLOCKUNITS-1 : 0) - x) * (ady = abs(ady)) * dx -
+    (((y >> MAPBTOFRAC) << MAPBTOFRAC) +
+    (dy > 0 ? MAPBLOCKUNITS-1 : 0) - y) * (adx = abs(adx)) * dy;
+
+    // starting block
+    b = (y >> MAPBTOFRAC)*job->width + (x >> MAPBTOFRAC);
+
+    // ending block
+    bend = ((c[5] - job->miny) >> MAPBTOFRAC)
+         * job->width + ((c[4] - job->minx) >> MAPBTOFRAC);
+
+    // delta for pointer when moving across y
+    dy *= job->width;
+
+    // deltas for diff inside the loop
+    adx <<= MAPBTOFRAC;
+    ady <<= MAPBTOFRAC;
+
+    // Now we simply iterate block-by-block until we reach the end block.
+    while ((unsigned) b < tot)    // failsafe -- should ALWAYS be true
+    {
+        // Add linedef to the block
+        if (lump)
+        {
+            lump[--ends[b]] = i;
+        }
+        else
+        {
+            ends[b]++;
+        }
+
+        // If we have reached the last block, exit
+        if (b == bend)
+        {
+            break;
+        }
+
+        // Move in either the x or y direction to the next block
+        if (diff < 0)
+        {
+            diff += ady, b += dx;
+        }
+        else
+        {
+            diff -= adx, b += dy;
+        }
+    }
+}
+
+static void P_BlockMapJob (void *data, int index)
+{
+    bmapjob_t *const job = data;
+    const unsigned tot = job->tot;
+    int *ends = calloc(tot, sizeof(*ends));     // lines of each block, then end of its list
+    int32_t *lump;
+    int i, ndx;
+
+    // Count the lines of each block.
+
+    for (i = 0; i < job->numlines; i++)
+    {
+        P_BlockMapLine(job, i, ends, NULL);
+    }
+
+    // Compute the total size of the blockmap.
+    //
+    // Compression of empty blocks is performed by reserving two offset words
+    // at tot and tot+1.
+    //
+    // 4 words, unused if this routine is called, are reserved at the start.
+
+    job->count = tot+6;  // we need at least 1 word per block, plus reserved's
+
+    for (i = 0; i < tot; i++)
+        if (ends[i])
+            job->count += ends[i] + 2; // 1 header word + 1 trailer word + blocklist
+
+    lump = job->lump = calloc(job->count, sizeof(*lump));
+
+    // Lay out the compressed blockmap, leaving room for the linedef lists.
+
+    ndx = tot + 4;              // Start of linedef lists
+    lump[ndx++] = 0;            // Store an empty blockmap list at start
+    lump[ndx++] = -1;           // (Used for compression)
+
+    for (i = 0; i < tot; i++)
+        if (ends[i])                                    // Non-empty blocklist
+        {
+            lump[lump[i + 4] = ndx++] = 0;              // Store index & header
+            ndx += ends[i];                             // Room for linedef list
+            ends[i] = ndx;
+            lump[ndx++] = -1;                           // Store trailer
+        }
+        else            // Empty blocklist: point to reserved empty blocklist
+        lump[i + 4] = tot + 4;
+
+    // Store the linedefs. Each list is filled from its end, so it holds
+    // the linedefs in descending order, like the original code did.
+
+    for (i = 0; i < job->numlines; i++)
+    {
+        P_BlockMapLine(job, i, ends, lump);
+    }
+
+    free(ends);
+}
+
+static void P_StartBlockMap (void)
 {
     int i;
     fixed_t minx = INT_MAX, miny = INT_MAX, maxx = INT_MIN, maxy = INT_MIN;
@@ -1604,134 +1839,40 @@ static void P_CreateBlockMap (void)
     bmapwidth  = ((maxx-minx) >> MAPBTOFRAC) + 1;
     bmapheight = ((maxy-miny) >> MAPBTOFRAC) + 1;
 
-    // Compute blockmap, which is stored as a 2d array of variable-sized lists.
-    //
-    // Pseudocode:
-    //
-    // For each linedef:
-    //
-    //   Map the starting and ending vertices to blocks.
-    //
-    //   Starting in the starting vertex's block, do:
-    //
-    //     Add linedef to current block's list, dynamically resizing it.
-    //
-    //     If current block is the same as the ending vertex's block, exit loop.
-    //
-    //     Move to an adjacent block by moving towards the ending block in
-    //     either the x or y direction, to the block which contains the linedef.
+    bmapjob.minx = minx;
+    bmapjob.miny = miny;
+    bmapjob.width = bmapwidth;
+    bmapjob.tot = bmapwidth * bmapheight;
+    bmapjob.numlines = numlines;
+    bmapjob.coords = malloc(numlines * 6 * sizeof(*bmapjob.coords));
 
+    for (i=0; i < numlines; i++)
     {
-        typedef struct { int n, nalloc, *list; } bmap_t;  // blocklist structure
-        unsigned tot = bmapwidth * bmapheight;            // size of blockmap
-        bmap_t *bmap = calloc(sizeof *bmap, tot);         // array of blocklists
-        int x, y, adx, ady, bend;
-
-        for (i=0; i < numlines; i++)
-        {
-            int dx, dy, diff, b;
-
-            // starting coordinates
-            x = (lines[i].v1->x >> FRACBITS) - minx;
-            y = (lines[i].v1->y >> FRACBITS) - miny;
-
-            // x-y deltas
-            adx = lines[i].dx >> FRACBITS, dx = adx < 0 ? -1 : 1;
-            ady = lines[i].dy >> FRACBITS, dy = ady < 0 ? -1 : 1;
-
-            // difference in preferring to move across y (>0) instead of x (<0)
-            diff = !adx ? 1 : !ady ? -1 :
-            (((x >> MAPBTOFRAC) << MAPBTOFRAC) +
-            (dx > 0 ? MAPBLOCKUNITS-1 : 0) - x) * (ady = abs(ady)) * dx -
-            (((y >> MAPBTOFRAC) << MAPBTOFRAC) +
-            (dy > 0 ? MAPBLOCKUNITS-1 : 0) - y) * (adx = abs(adx)) * dy;
-
-            // starting block, and pointer to its blocklist structure
-            b = (y >> MAPBTOFRAC)*bmapwidth + (x >> MAPBTOFRAC);
+        int *const c = &bmapjob.coords[i * 6];
 
-            // ending block
-            bend = (((lines[i].v2->y >> FRACBITS) - miny) >> MAPBTOFRAC)
-                 * bmapwidth + (((lines[i].v2->x >> FRACBITS) - minx) >> MAPBTOFRAC);
-
-            // delta for pointer when moving across y
-            dy *= bmapwidth;
-
-            // deltas for diff inside the loop
-            adx <<= MAPBTOFRAC;
-            ady <<= MAPBTOFRAC;
-
-            // Now we simply iterate block-by-block until we reach the end block.
-            while ((unsigned) b < tot)    // failsafe -- should ALWAYS be true
-            {
-                // Increase size of allocated list if necessary
-                if (bmap[b].n >= bmap[b].nalloc)
-                    bmap[b].list = I_Realloc(bmap[b].list,
-                   (bmap[b].nalloc = bmap[b].nalloc ?
-                    bmap[b].nalloc*2 : 8)*sizeof*bmap->list);
-
-                // Add linedef to end of list
-                bmap[b].list[bmap[b].n++] = i;
-
-                // If we have reached the last block, exit
-                if (b == bend)
-                {
-                    break;
-                }
-
-                // Move in either the x or y direction to the next block
-                if (diff < 0)
-                {
-                    diff += ady, b += dx;
-                }
-                else
-                {
-                    diff -= adx, b += dy;
-                }
-            }
-        }
+        c[0] = lines[i].v1->x >> FRACBITS;
+        c[1] = lines[i].v1->y >> FRACBITS;
+        c[2] = lines[i].dx >> FRACBITS;
+        c[3] = lines[i].dy >> FRACBITS;
+        c[4] = lines[i].v2->x >> FRACBITS;
+        c[5] = lines[i].v2->y >> FRACBITS;
+    }
 
-        // Compute the total size of the blockmap.
-        //
-        // Compression of empty blocks is performed by reserving two offset words
-        // at tot and tot+1.
-        //
-        // 4 words, unused if this routine is called, are reserved at the start.
+    I_StartJob(P_BlockMapJob, &bmapjob, 1);
+}
 
-        {
-            int count = tot+6;  // we need at least 1 word per block, plus reserved's
-        
-            for (i = 0; i < tot; i++)
-                if (bmap[i].n)
-                    count += bmap[i].n + 2; // 1 header word + 1 trailer word + blocklist
-        
-            // Allocate blockmap lump with computed count
-            blockmaplump = Z_Malloc(sizeof(*blockmaplump) * count, PU_LEVEL, 0);
-        }
+static void P_FinishBlockMap (void)
+{
+    I_FinishJob();
 
-        // Now compress the blockmap.
-        {
-            int ndx = tot += 4;         // Advance index to start of linedef lists
-            bmap_t *bp = bmap;          // Start of uncompressed blockmap
+    // Allocate blockmap lump with computed count
+    blockmaplump = Z_Malloc(sizeof(*blockmaplump) * bmapjob.count, PU_LEVEL, 0);
+    memcpy(blockmaplump, bmapjob.lump, sizeof(*blockmaplump) * bmapjob.count);
 
-            blockmaplump[ndx++] = 0;    // Store an empty blockmap list at start
-            blockmaplump[ndx++] = -1;   // (Used for compression)
-
-            for (i = 4; i < tot; i++, bp++)
-                if (bp->n)                                      // Non-empty blocklist
-                {
-                    blockmaplump[blockmaplump[i] = ndx++] = 0;  // Store index & header
-                    do
-                    blockmaplump[ndx++] = bp->list[--bp->n];    // Copy linedef list
-                    while (bp->n);
-                    blockmaplump[ndx++] = -1;                   // Store trailer
-                    free(bp->list);                             // Free linedef list
-                }
-                else            // Empty blocklist: point to reserved empty blocklist
-                blockmaplump[i] = tot;
-        
-            free(bmap);    // Free uncompressed blockmap
-        }
-    }
+    free(bmapjob.lump);
+    free(bmapjob.coords);
+    bmapjob.lump = NULL;
+    bmapjob.coords = NULL;
 
     // [crispy] copied over from P_LoadBlockMap()
     {
@@ -2073,6 +2214,18 @@ static void P_LoadReject (const int lumpnum)
     }
 }
 
+// -----------------------------------------------------------------------------
+// P_HasBehavior
+// [crispy] Hexen format maps have a BEHAVIOR lump after the BLOCKMAP.
+// -----------------------------------------------------------------------------
+
+static boolean P_HasBehavior (const int lumpnum)
+{
+    const int b = lumpnum+ML_BLOCKMAP+1;
+
+    return b < numlumps && !strncasecmp(lumpinfo[b]->name, "BEHAVIOR", 8);
+}
+
 // -----------------------------------------------------------------------------
 // [crispy] support maps with NODES in compressed or uncompressed ZDBSP
 // format or DeePBSP format and/or LINEDEFS and THINGS lumps in Hexen format
@@ -2084,8 +2237,7 @@ static const mapformat_t P_CheckMapFormat (const int lumpnum)
     mapformat_t format = 0;
     byte *nodes_lump_data = NULL;
 
-    if ((b = lumpnum+ML_BLOCKMAP+1) < numlumps
-    && !strncasecmp(lumpinfo[b]->name, "BEHAVIOR", 8))
+    if (P_HasBehavior(lumpnum))
     {
         printf(english_language ?
                 "Hexen format (" :
@@ -2134,6 +2286,398 @@ static const mapformat_t P_CheckMapFormat (const int lumpnum)
     return format;
 }
 
+// -----------------------------------------------------------------------------
+// P_LoadPhase
+// Level load time of each phase, printed with -loadtimes. Each call
+// ends the phase started by the previous one.
+// -----------------------------------------------------------------------------
+
+typedef struct
+{
+    const char *name;
+    uint64_t    time;
+} loadphase_t;
+
+static loadphase_t loadphases[16];
+static int         numloadphases;
+static uint64_t    loadphasestart;
+
+static void P_StartLoadPhases (void)
+{
+    numloadphases = 0;
+    loadphasestart = I_GetTimeUS();
+}
+
+static void P_LoadPhase (const char *name)
+{
+    const uint64_t now = I_GetTimeUS();
+
+    if (numloadphases < arrlen(loadphases))
+    {
+        loadphases[numloadphases].name = name;
+        loadphases[numloadphases].time = now - loadphasestart;
+        numloadphases++;
+    }
+
+    loadphasestart = now;
+}
+
+static void P_PrintLoadPhases (void)
+{
+    //!
+    // @category game
+    //
+    // Print how long each phase of level loading took.
+    //
+
+    if (!M_ParmExists("-loadtimes"))
+    {
+        return;
+    }
+
+    printf(english_language ?
+           "    %d vertexes, %d linedefs, %d sectors, %d segs, %d nodes:\n" :
+           "    %d вершин, %d линий, %d секторов, %d сегментов, %d нодов:\n",
+           numvertexes, numlines, numsectors, numsegs, numnodes);
+
+    for (int i = 0 ; i < numloadphases ; i++)
+    {
+        printf("    %-12s %7.2f %s\n", loadphases[i].name,
+               loadphases[i].time / 1000.0, english_language ? "ms" : "мс");
+    }
+}
+
+// -----------------------------------------------------------------------------
+// P_BenchmarkBSP
+// Time the BSP walks on the loaded level, printed with -bspbench:
+// point lookups on a grid over the whole map, and sight checks between
+// the things in it.
+// -----------------------------------------------------------------------------
+
+#define BENCH_GRID    256
+#define BENCH_THINGS  256
+
+static void P_BenchmarkBSP (void)
+{
+    const mobj_t *things[BENCH_THINGS];
+    int      numthings = 0, visible = 0;
+    fixed_t  stepx, stepy;
+    uint64_t start, points, sights;
+
+    //!
+    // @category game
+    //
+    // Time the BSP walks on each level after it is loaded: point
+    // lookups over the map and sight checks between its things.
+    //
+
+    if (!M_ParmExists("-bspbench"))
+    {
+        return;
+    }
+
+    stepx = (fixed_t)(((int64_t) bmapwidth << MAPBLOCKSHIFT) / BENCH_GRID);
+    stepy = (fixed_t)(((int64_t) bmapheight << MAPBLOCKSHIFT) / BENCH_GRID);
+
+    start = I_GetTimeUS();
+
+    for (int y = 0 ; y < BENCH_GRID ; y++)
+    {
+        for (int x = 0 ; x < BENCH_GRID ; x++)
+        {
+            R_PointInSubsector(bmaporgx + x * stepx, bmaporgy + y * stepy);
+        }
+    }
+
+    points = I_GetTimeUS() - start;
+
+    for (thinker_t *th = thinkercap.next ; th != &thinkercap && numthings < BENCH_THINGS ; th = th->next)
+    {
+        if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+        {
+            things[numthings++] = (mobj_t *)th;
+        }
+    }
+
+    start = I_GetTimeUS();
+
+    for (int i = 0 ; i < numthings ; i++)
+    {
+        for (int j = 0 ; j < numthings ; j++)
+        {
+            visible += P_CheckSight(things[i], things[j]);
+        }
+    }
+
+    sights = I_GetTimeUS() - start;
+
+    printf(english_language ?
+           "    BSP: %d point lookups, %.1f ns each; %d sight checks (%d visible), %.1f ns each.\n" :
+           "    BSP: %d поисков точки, %.1f нс каждый; %d проверок видимости (%d видимо), %.1f нс каждая.\n",
+           BENCH_GRID * BENCH_GRID, points * 1000.0 / (BENCH_GRID * BENCH_GRID),
+           numthings * numthings, visible,
+           numthings ? sights * 1000.0 / (numthings * numthings) : 0.0);
+}
+
+// -----------------------------------------------------------------------------
+// P_MapLumpName
+// -----------------------------------------------------------------------------
+
+static void P_MapLumpName (char *lumpname, const int episode, const int map)
+{
+    if (gamemode == commercial)
+    {
+        DEH_snprintf(lumpname, 9, "MAP%02d", map);
+    }
+    else
+    {
+        DEH_snprintf(lumpname, 9, "E%dM%d", episode, map);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// P_StartPrefetch
+// Prefetch the next level while the intermission and the text screen
+// are shown, so it starts right away once they are over. The zone and the
+// WAD cache may only be used by this thread, so the work is done here in
+// slices of PREFETCH_BUDGET each tic, see P_PrefetchTicker. The sounds
+// are left to S_PrecacheLevelSounds, once the level is loaded.
+// Everything is cached purgable and used by P_SetupLevel and
+// R_PrecacheLevel if still there, so cancelling only needs to let go of
+// the lump being read.
+// -----------------------------------------------------------------------------
+
+#define PREFETCH_BUDGET 2000  // microseconds
+
+typedef enum
+{
+    PREFETCH_NONE,
+    PREFETCH_LUMPS,     // map lumps
+    PREFETCH_SECTORS,   // flats
+    PREFETCH_LINEDEFS,  // which sidedefs have masked mid textures
+    PREFETCH_SIDEDEFS,  // textures
+    PREFETCH_THINGS,    // which types of things are placed
+    PREFETCH_SPRITES,   // sprites of those things
+} prefetchstep_t;
+
+static struct
+{
+    prefetchstep_t step;
+    int      lumpnum;   // map marker
+    boolean  hexen;     // Hexen format linedefs and things
+    byte    *data;      // lump read by the current step, locked
+    int      lump;
+    int      item;      // next item of the current step
+    int      count;
+    byte    *maskedsides;
+    int      maskedsidesalloced;
+    int      numsides;
+    boolean  mobjtypes[NUMMOBJTYPES];
+} prefetch;
+
+void P_StartPrefetch (const int episode, const int map)
+{
+    char lumpname[9];
+    P_CancelPrefetch();
+
+    // Timing demos measure the level loading as well.
+    if (demoplayback)
+    {
+        return;
+    }
+
+    P_MapLumpName(lumpname, episode, map);
+
+    if ((prefetch.lumpnum = W_CheckNumForName(lumpname)) < 0
+    ||  prefetch.lumpnum + ML_BLOCKMAP >= numlumps)
+    {
+        return;
+    }
+
+    prefetch.hexen = P_HasBehavior(prefetch.lumpnum);
+
+    prefetch.numsides = W_LumpLength(prefetch.lumpnum + ML_SIDEDEFS) / sizeof(mapsidedef_t);
+
+    if (prefetch.maskedsidesalloced < prefetch.numsides)
+    {
+        prefetch.maskedsidesalloced = prefetch.numsides;
+        prefetch.maskedsides = I_Realloc(prefetch.maskedsides, prefetch.numsides);
+    }
+
+    memset(prefetch.maskedsides, 0, prefetch.numsides);
+    memset(prefetch.mobjtypes, 0, sizeof(prefetch.mobjtypes));
+
+    prefetch.step = PREFETCH_LUMPS;
+    prefetch.item = ML_THINGS;
+    prefetch.count = ML_BLOCKMAP + 1;
+}
+
+// -----------------------------------------------------------------------------
+// P_CancelPrefetch
+// -----------------------------------------------------------------------------
+
+static void P_ReleasePrefetchLump (void)
+{
+    if (prefetch.data != NULL)
+    {
+        W_ReleaseLumpNum(prefetch.lump);
+        prefetch.data = NULL;
+    }
+}
+
+void P_CancelPrefetch (void)
+{
+    P_ReleasePrefetchLump();
+    prefetch.step = PREFETCH_NONE;
+}
+
+// -----------------------------------------------------------------------------
+// P_PrefetchTicker
+// -----------------------------------------------------------------------------
+
+static void P_LockPrefetchLump (const prefetchstep_t step, const int ml, const size_t size)
+{
+    prefetch.step = step;
+    prefetch.lump = prefetch.lumpnum + ml;
+    prefetch.data = W_CacheLumpNum(prefetch.lump, PU_STATIC);
+    prefetch.item = 0;
+    prefetch.count = W_LumpLength(prefetch.lump) / size;
+}
+
+static void P_NextPrefetchStep (void)
+{
+    P_ReleasePrefetchLump();
+
+    switch (prefetch.step)
+    {
+        case PREFETCH_LUMPS:
+        P_LockPrefetchLump(PREFETCH_SECTORS, ML_SECTORS, sizeof(mapsector_t));
+        break;
+
+        case PREFETCH_SECTORS:
+        P_LockPrefetchLump(PREFETCH_LINEDEFS, ML_LINEDEFS, prefetch.hexen ?
+                           sizeof(maplinedef_hexen_t) : sizeof(maplinedef_t));
+        break;
+
+        case PREFETCH_LINEDEFS:
+        P_LockPrefetchLump(PREFETCH_SIDEDEFS, ML_SIDEDEFS, sizeof(mapsidedef_t));
+        break;
+
+        case PREFETCH_SIDEDEFS:
+        P_LockPrefetchLump(PREFETCH_THINGS, ML_THINGS, prefetch.hexen ?
+                           sizeof(mapthing_hexen_t) : sizeof(mapthing_t));
+        break;
+
+        case PREFETCH_THINGS:
+        prefetch.step = PREFETCH_SPRITES;
+        prefetch.item = 0;
+        prefetch.count = NUMMOBJTYPES;
+        break;
+
+        default:
+        prefetch.step = PREFETCH_NONE;
+        break;
+    }
+}
+
+static void P_PrefetchItem (const int i)
+{
+    switch (prefetch.step)
+    {
+        case PREFETCH_LUMPS:
+        W_CacheLumpNum(prefetch.lumpnum + i, PU_CACHE);
+        break;
+
+        case PREFETCH_SECTORS:
+        {
+            mapsector_t *ms = (mapsector_t *) prefetch.data + i;
+
+            R_PrefetchFlat(ms->floorpic);
+            R_PrefetchFlat(ms->ceilingpic);
+        }
+        break;
+
+        case PREFETCH_LINEDEFS:
+        {
+            unsigned short side0, side1;
+
+            if (prefetch.hexen)
+            {
+                const maplinedef_hexen_t *mld = (maplinedef_hexen_t *) prefetch.data + i;
+
+                side0 = SHORT(mld->sidenum[0]);
+                side1 = SHORT(mld->sidenum[1]);
+            }
+            else
+            {
+                const maplinedef_t *mld = (maplinedef_t *) prefetch.data + i;
+
+                side0 = SHORT(mld->sidenum[0]);
+                side1 = SHORT(mld->sidenum[1]);
+            }
+
+            // Mid textures of two-sided lines are masked.
+            if (side0 < prefetch.numsides && side1 < prefetch.numsides)
+            {
+                prefetch.maskedsides[side0] = prefetch.maskedsides[side1] = 1;
+            }
+        }
+        break;
+
+        case PREFETCH_SIDEDEFS:
+        {
+            mapsidedef_t *msd = (mapsidedef_t *) prefetch.data + i;
+
+            R_PrefetchTexture(msd->toptexture, false);
+            R_PrefetchTexture(msd->bottomtexture, false);
+            R_PrefetchTexture(msd->midtexture, prefetch.maskedsides[i]);
+        }
+        break;
+
+        case PREFETCH_THINGS:
+        {
+            const int type = prefetch.hexen ?
+                             SHORT(((mapthing_hexen_t *) prefetch.data + i)->type) :
+                             SHORT(((mapthing_t *) prefetch.data + i)->type);
+            const int mobjtype = P_FindDoomedNum(type);
+
+            if (mobjtype < NUMMOBJTYPES)
+            {
+                prefetch.mobjtypes[mobjtype] = true;
+            }
+        }
+        break;
+
+        case PREFETCH_SPRITES:
+        if (prefetch.mobjtypes[i])
+        {
+            R_PrefetchSprite(states[mobjinfo[i].spawnstate].sprite);
+        }
+        break;
+
+        default:
+        break;
+    }
+}
+
+void P_PrefetchTicker (void)
+{
+    const uint64_t start = I_GetTimeUS();
+
+    while (prefetch.step != PREFETCH_NONE
+    &&     I_GetTimeUS() - start < PREFETCH_BUDGET)
+    {
+        if (prefetch.item < prefetch.count)
+        {
+            P_PrefetchItem(prefetch.item++);
+        }
+        else
+        {
+            P_NextPrefetchStep();
+        }
+    }
+}
+
 // -----------------------------------------------------------------------------
 // P_SetupLevel
 // -----------------------------------------------------------------------------
@@ -2170,6 +2714,12 @@ void P_SetupLevel (const int episode, const int map, const skill_t skill)
         singletics = false;
     }
 
+    // Whatever the prefetch got to is used below.
+    P_CancelPrefetch();
+
+    // Write the profile of the previous level before it is freed.
+    P_WriteLevelProfile();
+
     // Make sure all sounds are stopped before Z_FreeTags.
     S_Start ();			
 
@@ -2181,14 +2731,7 @@ void P_SetupLevel (const int episode, const int map, const skill_t skill)
     W_Reload ();
 
     // find map name
-    if (gamemode == commercial)
-    {
-        DEH_snprintf(lumpname, 9, "MAP%02d", map);
-    }
-    else
-    {
-        DEH_snprintf(lumpname, 9, "E%dM%d", episode, map);
-    }
+    P_MapLumpName(lumpname, episode, map);
 
     lumpnum = W_GetNumForName (lumpname);
 
@@ -2227,9 +2770,11 @@ void P_SetupLevel (const int episode, const int map, const skill_t skill)
     crispy_mapformat = P_CheckMapFormat(lumpnum);
 
     // note: most of this ordering is important	
+    P_StartLoadPhases();
     crispy_validblockmap = P_LoadBlockMap (lumpnum+ML_BLOCKMAP); // [crispy] (re-)create BLOCKMAP if necessary
     P_LoadVertexes (lumpnum+ML_VERTEXES);
     P_LoadSectors (lumpnum+ML_SECTORS);
+    P_InitTagIndex ();
     P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
 
     if (crispy_mapformat & HEXEN)
@@ -2240,11 +2785,14 @@ void P_SetupLevel (const int episode, const int map, const skill_t skill)
     {
         P_LoadLineDefs (lumpnum+ML_LINEDEFS);
     }
+    P_LoadPhase("map lumps");
 
     // [crispy] (re-)create BLOCKMAP if necessary
+    // It only needs the linedefs, so build it on a worker thread
+    // while the nodes are loaded here.
     if (!crispy_validblockmap)
     {
-        P_CreateBlockMap();
+        P_StartBlockMap();
     }
 
     if (crispy_mapformat & (ZDBSPX | ZDBSPZ))
@@ -2263,14 +2811,27 @@ void P_SetupLevel (const int episode, const int map, const skill_t skill)
         P_LoadNodes (lumpnum+ML_NODES);
         P_LoadSegs (lumpnum+ML_SEGS);
     }
+    P_LoadPhase("nodes");
+
+    // Wait for the blockmap, P_GroupLines needs it.
+    if (!crispy_validblockmap)
+    {
+        P_FinishBlockMap();
+        P_LoadPhase("blockmap");
+    }
 
     P_GroupLines ();
+    // Must follow P_GroupLines, which counts the lines
+    // emulated in the padding of a short REJECT lump.
     P_LoadReject (lumpnum+ML_REJECT);
+    P_LoadPhase("lines/reject");
     
     // [crispy] remove slime trails
     P_RemoveSlimeTrails();
     // [crispy] fix long wall wobble
     P_SegLengths();
+    P_InitBSPTree();
+    P_LoadPhase("segs");
     // [crispy] blinking key or skull in the status bar
     memset(st_keyorskull, 0, sizeof(st_keyorskull));
 
@@ -2304,19 +2865,27 @@ void P_SetupLevel (const int episode, const int map, const skill_t skill)
 
     // set up world state
     P_SpawnSpecials ();
+
+    // automap line grid
+    AM_SetupLevel ();
 	
     // preload graphics
     if (precache)
     {
         R_PrecacheLevel ();
+        S_PrecacheLevelSounds ();
     }
 
     // [JN] Set level name.
     P_LevelNameInit();
+    P_InitLevelProfile(lumpname);
+    P_LoadPhase("spawn");
 
     endtime = SDL_GetTicks() - starttime;
     DEH_printf(english_language ? "loaded in %d ms.\n" :
                                   "загружен за %d мс.\n", endtime);
+    P_PrintLoadPhases();
+    P_BenchmarkBSP();
 }
 
 // -----------------------------------------------------------------------------
@@ -283,7 +283,7 @@ static const boolean P_CrossSubsector (const int num)
 
 static const boolean P_CrossBSPNode (const int bspnum)
 {
-    node_t *bsp;
+    const bspnode_t *bsp;
     int     side;
 
     if (bspnum & NF_SUBSECTOR)
@@ -291,10 +291,10 @@ static const boolean P_CrossBSPNode (const int bspnum)
         return P_CrossSubsector (bspnum == -1 ? 0 : bspnum&(~NF_SUBSECTOR));
     }
 
-    bsp = &nodes[bspnum];
+    bsp = &bspnodes[bspnum];
 
     // decide which side the start point is on
-    side = P_DivlineSide (strace.x, strace.y, (divline_t *)bsp);
+    side = P_DivlineSide (strace.x, strace.y, (const divline_t *)bsp);
     if (side == 2)
     {
         side = 0;  // an "on" should cross both sides
@@ -307,7 +307,7 @@ static const boolean P_CrossBSPNode (const int bspnum)
     }
 
     // the partition plane is crossed here
-    if (side == P_DivlineSide (t2x, t2y,(divline_t *)bsp))
+    if (side == P_DivlineSide (t2x, t2y, (const divline_t *)bsp))
     {
         // the line doesn't touch the other side
         return true;
@@ -330,6 +330,11 @@ const boolean P_CheckSight (const mobj_t *t1, const mobj_t *t2)
     const int s2 = (t2->subsector->sector - sectors);
     const int pnum = s1*numsectors + s2;
 
+    if (levelprofile)
+    {
+        P_ProfileSight(t1);
+    }
+
     // Check for trivial rejection in REJECT table.
     if (rejectmatrix[pnum>>3] & (1 << (pnum&7)))
     {
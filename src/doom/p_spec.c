@@ -29,6 +29,7 @@
 #include "m_argv.h"
 #include "m_misc.h"
 #include "m_random.h"
+#include "m_tags.h"
 #include "p_local.h"
 #include "g_game.h"
 #include "s_sound.h"
@@ -441,6 +442,25 @@ const fixed_t P_FindHighestCeilingSurrounding (const sector_t *sec)
     return height;
 }
 
+// -----------------------------------------------------------------------------
+// P_InitTagIndex
+// Index the sectors by tag, so activating a special does not have
+// to scan every sector. Must be called when sectors or their tags are
+// loaded, i.e. by P_SetupLevel and when a saved game is loaded.
+// -----------------------------------------------------------------------------
+
+static tagindex_t sectortags;
+
+static int P_SectorTag (const int i)
+{
+    return sectors[i].tag;
+}
+
+void P_InitTagIndex (void)
+{
+    M_BuildTagIndex(&sectortags, numsectors, P_SectorTag);
+}
+
 // -----------------------------------------------------------------------------
 // P_FindSectorFromLineTag
 // RETURN NEXT SECTOR # THAT LINE TAG REFERS TO
@@ -448,11 +468,7 @@ const fixed_t P_FindHighestCeilingSurrounding (const sector_t *sec)
 
 const int P_FindSectorFromLineTag (const line_t *line, const int start)
 {
-    for (int i = start+1 ; i < numsectors ; i++)
-        if (sectors[i].tag == line->tag)
-            return i;
-
-    return -1;
+    return M_NextTagged(&sectortags, line->tag, start);
 }
 
 // -----------------------------------------------------------------------------
@@ -1283,16 +1299,7 @@ void P_UpdateSpecials (void)
 
 void R_InterpolateTextureOffsets (void)
 {
-    fixed_t frac;
-
-    if (uncapped_fps && leveltime > oldleveltime)
-    {
-        frac = fractionaltic;
-    }
-    else
-    {
-        frac = FRACUNIT;
-    }
+    const fixed_t frac = interpfrac;
 
     for (int i = 0; i < numlinespecials; i++)
     {
@@ -73,6 +73,23 @@ void P_RemoveThinker (thinker_t *thinker)
     thinker->function.acv = (actionf_v)(-1);
 }
 
+// -----------------------------------------------------------------------------
+// P_RunThinker
+// Run one thinker, timing it with -levelprofile.
+// -----------------------------------------------------------------------------
+
+static inline void P_RunThinker (thinker_t *thinker)
+{
+    if (levelprofile)
+    {
+        P_ProfileThinker(thinker);
+    }
+    else
+    {
+        thinker->function.acp1(thinker);
+    }
+}
+
 // -----------------------------------------------------------------------------
 // P_RunThinkers
 // [JN] Additionally, animate flickering and glowing effect for brightmaps.
@@ -104,7 +121,7 @@ void P_RunThinkers (void)
         {
             if (currentthinker->function.acp1)
                 if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
-                    currentthinker->function.acp1 (currentthinker);
+                    P_RunThinker(currentthinker);
 
             nextthinker = currentthinker->next;
             currentthinker = nextthinker;
@@ -169,14 +186,14 @@ void P_RunThinkers (void)
             {
                 if (currentthinker->function.acp1)
                     if (currentthinker->function.acp1 != (actionf_p1)P_MobjThinker)
-                        currentthinker->function.acp1 (currentthinker);
+                        P_RunThinker(currentthinker);
 
                 nextthinker = currentthinker->next;
             }
             else
             {
                 if (currentthinker->function.acp1)
-                    currentthinker->function.acp1 (currentthinker);
+                    P_RunThinker(currentthinker);
 
                 nextthinker = currentthinker->next;
             }
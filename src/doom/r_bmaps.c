@@ -21,8 +21,12 @@
 //
 
 
+#include <ctype.h>
+
 #include "doomstat.h"
+#include "i_system.h"
 #include "r_local.h"
+#include "z_zone.h"
 #include "jn.h"
 
 
@@ -542,16 +546,63 @@ static const fullbright_t fullbright_finaldoom[] = {
 //  {"SW2SKULL", DOOM2ONLY, redonly},
 };
 
-const byte* R_BrightmapForTexName(const char* texname)
+// Brightmaps of the current game by texture name, hashed.
+// Filled by R_InitBrightmaps, so looking up every texture of a PWAD
+// does not compare it against every brightmapped texture name.
+
+#define TEXHASHSIZE 256 // power of two, at least twice the brightmaps
+
+// Fails to compile if the table could be more than half full.
+typedef char texhashsize_check[TEXHASHSIZE >= 2 * (arrlen(fullbright_walls)
+                                                 + arrlen(fullbright_finaldoom)) ? 1 : -1];
+
+static const fullbright_t* texbrightmaps[TEXHASHSIZE];
+static int numtexbrightmaps;
+
+static unsigned int R_TexNameHash(const char* texname)
 {
-    int i;
-    const fullbright_t* brightmap;
+    unsigned int hash = 0;
 
-    if(vanillaparm)
+    for(int i = 0; i < 8 && texname[i]; i++)
     {
-        return nobrightmap;
+        hash = hash * 31 + toupper(texname[i]);
+    }
+
+    return hash;
+}
+
+static void R_AddTexBrightmap(const fullbright_t* brightmap)
+{
+    unsigned int i = R_TexNameHash(brightmap->texture);
+
+    // Keep the first brightmap of a name, like a linear search would.
+    for(; texbrightmaps[i & (TEXHASHSIZE - 1)]; i++)
+    {
+        if(!strncasecmp(texbrightmaps[i & (TEXHASHSIZE - 1)]->texture, brightmap->texture, 8))
+        {
+            return;
+        }
+    }
+
+    // Lookups stop at an empty slot, so always leave one.
+    if(++numtexbrightmaps >= TEXHASHSIZE)
+    {
+        I_QuitWithError(english_language ?
+                        "R_AddTexBrightmap: too many brightmapped textures" :
+                        "R_AddTexBrightmap: слишком много текстур с брайтмапами");
     }
 
+    texbrightmaps[i & (TEXHASHSIZE - 1)] = brightmap;
+}
+
+static void R_InitTexBrightmaps(void)
+{
+    int i;
+    const fullbright_t* brightmap;
+
+    memset(texbrightmaps, 0, sizeof(texbrightmaps));
+    numtexbrightmaps = 0;
+
     for(i = 0; (size_t) i < arrlen(fullbright_walls); i++)
     {
         brightmap = &fullbright_walls[i];
@@ -562,10 +613,7 @@ const byte* R_BrightmapForTexName(const char* texname)
             continue;
         }
 
-        if(!strncasecmp(brightmap->texture, texname, 8))
-        {
-            return brightmap->colormask;
-        }
+        R_AddTexBrightmap(brightmap);
     }
 
     // Final Doom: Plutonia has no exclusive brightmaps
@@ -573,12 +621,25 @@ const byte* R_BrightmapForTexName(const char* texname)
     {
         for(i = 0; (size_t) i < arrlen(fullbright_finaldoom); i++)
         {
-            brightmap = &fullbright_finaldoom[i];
+            R_AddTexBrightmap(&fullbright_finaldoom[i]);
+        }
+    }
+}
+
+const byte* R_BrightmapForTexName(const char* texname)
+{
+    unsigned int i;
+
+    if(vanillaparm)
+    {
+        return nobrightmap;
+    }
 
-            if(!strncasecmp(brightmap->texture, texname, 8))
-            {
-                return brightmap->colormask;
-            }
+    for(i = R_TexNameHash(texname); texbrightmaps[i & (TEXHASHSIZE - 1)]; i++)
+    {
+        if(!strncasecmp(texbrightmaps[i & (TEXHASHSIZE - 1)]->texture, texname, 8))
+        {
+            return texbrightmaps[i & (TEXHASHSIZE - 1)]->colormask;
         }
     }
 
@@ -589,9 +650,14 @@ const byte* R_BrightmapForTexName(const char* texname)
 // [crispy] brightmaps for sprites
 // -----------------------------------------------------------------------------
 
-const byte* R_BrightmapForSprite(const int type)
+// Brightmap of each sprite, with brightmaps on and off.
+// Filled by R_InitBrightmaps from the cases below.
+
+static const byte* spritebrightmaps[2][NUMSPRITES];
+
+static const byte* R_SpriteBrightmap(const int type, const boolean on)
 {
-    if(brightmaps && !vanillaparm)
+    if(on)
     {
         switch(type)
         {
@@ -681,23 +747,28 @@ const byte* R_BrightmapForSprite(const int type)
     return nobrightmap;
 }
 
+const byte* R_BrightmapForSprite(const int type)
+{
+    if((unsigned int) type >= NUMSPRITES)
+    {
+        return nobrightmap;
+    }
+
+    return spritebrightmaps[brightmaps && !vanillaparm][type];
+}
+
 // -----------------------------------------------------------------------------
 // [crispy] brightmaps for flats
 // -----------------------------------------------------------------------------
 
-static int bmapflatnum[4];
+// Brightmap of each flat, filled by R_InitBrightmaps.
+static const byte** flatbrightmaps;
 
 const byte* R_BrightmapForFlatNum(const int num)
 {
-    if(brightmaps && !vanillaparm)
+    if(brightmaps && !vanillaparm && num >= 0 && num < numflats)
     {
-        if(num == bmapflatnum[0]
-        || num == bmapflatnum[1]
-        || num == bmapflatnum[2]
-        || num == bmapflatnum[3])
-        {
-            return notgrayorbrown;
-        }
+        return flatbrightmaps[num];
     }
 
     return nobrightmap;
@@ -707,18 +778,30 @@ const byte* R_BrightmapForFlatNum(const int num)
 // [crispy] brightmaps for states
 // -----------------------------------------------------------------------------
 
+// Brightmap of each state, with brightmaps on.
+// Filled by R_InitBrightmaps from the cases below.
+
+static const byte* statebrightmaps[NUMSTATES];
+
+static const byte* R_StateBrightmap(const int state)
+{
+    switch(state)
+    {
+        case S_BFG1:
+        case S_BFG2:
+        case S_BFG3:
+        case S_BFG4:
+            return redonly;
+    }
+
+    return nobrightmap;
+}
+
 const byte* R_BrightmapForState(const int state)
 {
     if(brightmaps && !vanillaparm)
     {
-        switch(state)
-        {
-            case S_BFG1:
-            case S_BFG2:
-            case S_BFG3:
-            case S_BFG4:
-                return redonly;
-        }
+        return statebrightmaps[state];
     }
 
     return nobrightmap;
@@ -726,13 +809,38 @@ const byte* R_BrightmapForState(const int state)
 
 // -----------------------------------------------------------------------------
 // [crispy] initialize brightmaps
+// Resolve the brightmap of every texture name, flat, sprite and state
+// once, so drawing only has to look them up by number.
+// Must be called after R_InitFlats and before R_InitTextures.
 // -----------------------------------------------------------------------------
 
 void R_InitBrightmaps(void)
 {
+    int i;
+
+    R_InitTexBrightmaps();
+
     // [crispy] only four select brightmapped flats
-    bmapflatnum[0] = R_FlatNumForName("CONS1_1");
-    bmapflatnum[1] = R_FlatNumForName("CONS1_5");
-    bmapflatnum[2] = R_FlatNumForName("CONS1_7");
-    bmapflatnum[3] = R_FlatNumForName("GATE6");
+    flatbrightmaps = Z_Malloc(numflats * sizeof(*flatbrightmaps), PU_STATIC, 0);
+
+    for(i = 0; i < numflats; i++)
+    {
+        flatbrightmaps[i] = nobrightmap;
+    }
+
+    flatbrightmaps[R_FlatNumForName("CONS1_1")] = notgrayorbrown;
+    flatbrightmaps[R_FlatNumForName("CONS1_5")] = notgrayorbrown;
+    flatbrightmaps[R_FlatNumForName("CONS1_7")] = notgrayorbrown;
+    flatbrightmaps[R_FlatNumForName("GATE6")] = notgrayorbrown;
+
+    for(i = 0; i < NUMSPRITES; i++)
+    {
+        spritebrightmaps[0][i] = R_SpriteBrightmap(i, false);
+        spritebrightmaps[1][i] = R_SpriteBrightmap(i, true);
+    }
+
+    for(i = 0; i < NUMSTATES; i++)
+    {
+        statebrightmaps[i] = R_StateBrightmap(i);
+    }
 }
@@ -24,6 +24,7 @@
 #include "m_bbox.h"
 #include "i_system.h"
 #include "r_local.h"
+#include "p_local.h"
 #include "doomstat.h"
 #include "jn.h"
 
@@ -212,42 +213,13 @@ void R_ClearClipSegs (void)
     memset(solidcol, 0, screenwidth);
 }
 
-// -----------------------------------------------------------------------------
-// R_MaybeInterpolateSector
-// [AM] Interpolate the passed sector, if prudent.
-// -----------------------------------------------------------------------------
-
-static void R_MaybeInterpolateSector (sector_t *sector)
-{
-    if (uncapped_fps &&
-        // Only if we moved the sector last tic.
-        sector->oldgametic == gametic - 1 &&
-        sector->specialdata)
-    {
-        // Interpolate between current and last floor/ceiling position.
-        if (sector->floorheight != sector->oldfloorheight)
-            sector->interpfloorheight = sector->oldfloorheight + FixedMul(sector->floorheight - sector->oldfloorheight, fractionaltic);
-        else
-            sector->interpfloorheight = sector->floorheight;
-        if (sector->ceilingheight != sector->oldceilingheight)
-            sector->interpceilingheight = sector->oldceilingheight + FixedMul(sector->ceilingheight - sector->oldceilingheight, fractionaltic);
-        else
-            sector->interpceilingheight = sector->ceilingheight;
-    }
-    else
-    {
-        sector->interpfloorheight = sector->floorheight;
-        sector->interpceilingheight = sector->ceilingheight;
-    }
-}
-
 // -----------------------------------------------------------------------------
 // R_AddLine
 // Clips the given segment
 // and adds any visible pieces to the line list.
 // -----------------------------------------------------------------------------
 
-static void R_AddLine (const seg_t *line)
+static void R_AddLine (const seg_t *line, const bspseg_t *bspseg)
 {
     int      x1, x2;
     angle_t  angle1, angle2;
@@ -256,8 +228,8 @@ static void R_AddLine (const seg_t *line)
     curline = line;
 
     // [crispy] remove slime trails
-    angle1 = R_PointToAngleCrispy (line->v1->px, line->v1->py);
-    angle2 = R_PointToAngleCrispy (line->v2->px, line->v2->py);
+    angle1 = R_PointToAngleCrispy (bspseg->x1, bspseg->y1);
+    angle2 = R_PointToAngleCrispy (bspseg->x2, bspseg->y2);
 
     // Clip to view edges.
     span = angle1 - angle2;
@@ -315,14 +287,8 @@ static void R_AddLine (const seg_t *line)
     backsector = line->backsector;
 
     // Single sided line?
-    if (backsector)
-    {
-        // [AM] Interpolate sector movement before
-        //      running clipping tests.  Frontsector
-        //      should already be interpolated.
-        R_MaybeInterpolateSector(backsector);
-    }
-    else
+    // Sector heights are interpolated by R_InterpolateFrame.
+    if (!backsector)
     {
         // [JN] If no backsector is present, 
         // just clip the line as a solid segment.
@@ -446,7 +412,12 @@ static void R_Subsector (const int num)
 {
     const subsector_t *sub = &subsectors[num];
     const seg_t       *line = &segs[sub->firstline];
+    const bspseg_t    *bspseg = &bspsegs[sub->firstline];
     int   count = sub->numlines;
+    // What drawing the subsector costs, for -levelprofile.
+    const int          firstds = ds_p - drawsegs;
+    const unsigned int firstplane = newvisplanes;
+    int   sprites = 0;
 
 #ifdef RANGECHECK
     if(num>=numsubsectors)
@@ -457,10 +428,6 @@ static void R_Subsector (const int num)
 
     frontsector = sub->sector;
 
-    // [AM] Interpolate sector movement.  Usually only needed
-    //      when you're standing inside the sector.
-    R_MaybeInterpolateSector(frontsector);
-
     floorplane = frontsector->interpfloorheight < viewz ?
                  R_FindPlane (frontsector->interpfloorheight,
                               frontsector->floorpic,
@@ -480,12 +447,18 @@ static void R_Subsector (const int num)
     if (sub->sector->validcount != validcount && (!automapactive || automap_overlay))
     {
         sub->sector->validcount = validcount;
-        R_AddSprites (frontsector);
+        sprites = R_AddSprites (frontsector);
     }
 
     while (count--)
     {
-        R_AddLine (line++);
+        R_AddLine (line++, bspseg++);
+    }
+
+    if (levelprofile)
+    {
+        P_ProfileSubsector(sub->sector, sprites, (ds_p - drawsegs) - firstds,
+                           newvisplanes - firstplane);
     }
 }
 
@@ -501,7 +474,7 @@ void R_RenderBSPNode (int bspnum)
 {
     while (!(bspnum & NF_SUBSECTOR))  // Found a subsector?
     {
-        const node_t *bsp = &nodes[bspnum];
+        const bspnode_t *bsp = &bspnodes[bspnum];
 
         // Decide which side the view point is on.
         int side = R_PointOnSide(viewx, viewy, bsp);
@@ -510,7 +483,7 @@ void R_RenderBSPNode (int bspnum)
         R_RenderBSPNode(bsp->children[side]);
 
         // Possibly divide back space.
-        if (!R_CheckBBox(bsp->bbox[side^1]))
+        if (!R_CheckBBox(bspbboxes[bspnum][side^1]))
         {
             return;
         }
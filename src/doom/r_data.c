@@ -25,11 +25,13 @@
 #include <stdlib.h>
 
 #include "deh_main.h"
+#include "i_jobs.h"
 #include "i_swap.h"
 #include "i_system.h"
 #include "z_zone.h"
 #include "w_wad.h"
 #include "doomdef.h"
+#include "m_argv.h"
 #include "m_misc.h"
 #include "r_local.h"
 #include "p_local.h"
@@ -141,6 +143,12 @@ unsigned   **texturecolumnofs2;  // [crispy] column offsets for composited opaqu
 const byte **texturecomposite;   // [crispy] composited translucent mid-textures on 2S walls
 const byte **texturecomposite2;  // [crispy] composited opaque textures
 const byte **texturebrightmap;   // [crispy] brightmaps
+static byte *texturedirect;      // composites read straight from the patch lumps
+
+// The two composites of a texture, also used as texturedirect bits.
+#define COMPOSITE_OPAQUE        0   // texturecomposite2, for R_GetColumn
+#define COMPOSITE_MASKED        1   // texturecomposite, for R_GetColumnMod
+#define COMPOSITE_DIRECT(kind)  (1 << (kind))
 
 // for global animation
 int        *flattranslation, *texturetranslation;
@@ -235,14 +243,19 @@ static void R_DrawColumnInCache (column_t *patch, byte *cache, int originy,
 // patches, and each column is cached.
 //
 // Rewritten by Lee Killough for performance and to fix Medusa bug
+//
+// Builds only the masked composite used by R_GetColumnMod, the opaque
+// one is built by R_GenerateOpaqueComposite. The composite block must be
+// allocated and the patches cached by the caller, so this can run on a
+// worker thread.
 // -----------------------------------------------------------------------------
 
-static void R_GenerateComposite (int texnum)
+static void R_GenerateComposite (int texnum, patch_t **realpatches)
 {
     int			x, x1, x2, i;
     short      *collump;
-    unsigned   *colofs, *colofs2; // killough 4/9/98: make 32-bit
-    byte       *block, *block2;
+    unsigned   *colofs; // killough 4/9/98: make 32-bit
+    byte       *block;
     byte       *marks;  // killough 4/9/98: transparency marks
     byte       *source; // killough 4/9/98: temporary column
     texture_t  *texture;
@@ -252,13 +265,10 @@ static void R_GenerateComposite (int texnum)
 
     texture = textures[texnum];
 
-    block = Z_Malloc (texturecompositesize[texnum], PU_STATIC, &texturecomposite[texnum]);	
-    // [crispy] memory block for opaque textures
-    block2 = Z_Malloc (texture->width * texture->height, PU_STATIC, &texturecomposite2[texnum]);
+    block = (byte *) texturecomposite[texnum];
 
     collump = texturecolumnlump[texnum];
     colofs = texturecolumnofs[texnum];
-    colofs2 = texturecolumnofs2[texnum];
 
     // killough 4/9/98: marks to identify transparent regions in merged textures
     marks = calloc(texture->width, texture->height);
@@ -269,7 +279,7 @@ static void R_GenerateComposite (int texnum)
     // Composite the columns together.
     for (i = 0, patch = texture->patches; i < texture->patchcount ; i++, patch++)
     {
-        realpatch = W_CacheLumpNum (patch->patch, PU_STATIC);
+        realpatch = realpatches[i];
         x1 = patch->originx;
         x2 = x1 + SHORT(realpatch->width);
 
@@ -318,8 +328,6 @@ static void R_GenerateComposite (int texnum)
 
             // save column in temporary so we can shuffle it around
             memcpy(source, (byte *) col + 3, texture->height);
-            // [crispy] copy composited columns to opaque texture
-            memcpy(block2 + colofs2[i], source, texture->height);
 
             for ( ; ; ) // reconstruct the column by scanning transparency marks
             {
@@ -365,6 +373,76 @@ static void R_GenerateComposite (int texnum)
     free(marks); // free transparency marks
 }
 
+// -----------------------------------------------------------------------------
+// R_GenerateOpaqueComposite
+// Builds the opaque composite used by R_GetColumn. Its columns are
+// plain runs of texture->height bytes, so the patches are drawn straight
+// into the block. Same rules for the caller as for R_GenerateComposite.
+// -----------------------------------------------------------------------------
+
+static void R_GenerateOpaqueComposite (int texnum, patch_t **realpatches)
+{
+    int			x, x1, x2, i;
+    short      *collump;
+    unsigned   *colofs2;
+    byte       *block2;
+    byte       *marks;
+    texture_t  *texture;
+    texpatch_t *patch;
+    patch_t    *realpatch;
+    column_t   *patchcol;
+
+    texture = textures[texnum];
+
+    // [crispy] memory block for opaque textures
+    block2 = (byte *) texturecomposite2[texnum];
+
+    collump = texturecolumnlump[texnum];
+    colofs2 = texturecolumnofs2[texnum];
+
+    // Transparency marks are not needed here, but R_DrawColumnInCache
+    // sets them, so give it one column to scribble on.
+    marks = I_Realloc(NULL, texture->height);
+
+    // [crispy] initialize composite background to palette index 0 (usually black)
+    memset(block2, 0, texture->width * texture->height);
+
+    for (i = 0, patch = texture->patches; i < texture->patchcount ; i++, patch++)
+    {
+        realpatch = realpatches[i];
+        x1 = patch->originx;
+        x2 = x1 + SHORT(realpatch->width);
+
+        if (x1<0)
+        {
+            x = 0;
+        }
+        else
+        {
+            x = x1;
+        }
+
+        if (x2 > texture->width)
+        {
+            x2 = texture->width;
+        }
+
+        for ( ; x < x2 ; x++)
+        {
+            patchcol = (column_t *)((byte *)realpatch + LONG(realpatch->columnofs[x-x1]));
+            R_DrawColumnInCache (patchcol,
+				                 block2 + colofs2[x],
+				                 // [crispy] single-patched columns are normally not composited
+				                 // but directly read from the patch lump ignoring their originy
+				                 collump[x] >= 0 ? 0 : patch->originy,
+				                 texture->height,
+				                 marks);
+        }
+    }
+
+    free(marks);
+}
+
 // -----------------------------------------------------------------------------
 // R_GenerateLookup
 //
@@ -381,10 +459,12 @@ static void R_GenerateLookup (int texnum)
     texture_t  *texture;
     byte       *patchcount;	// patchcount[texture->width]
     byte       *postcount;  // killough 4/9/98: keep count of posts in addition to patches.
+    byte        direct;     // composites that can use the patches directly
     texpatch_t *patch;	
     patch_t    *realpatch;
 
     texture = textures[texnum];
+    direct = COMPOSITE_DIRECT(COMPOSITE_OPAQUE) | COMPOSITE_DIRECT(COMPOSITE_MASKED);
 
     // Composited texture not created yet.
     texturecomposite[texnum] = 0;
@@ -462,9 +542,17 @@ static void R_GenerateLookup (int texnum)
                         "\nR_GenerateLookup: Texture %.8s patch num %d (%.8s) is not valid" :
                         "\nR_GenerateLookup: некорректная текстура %.8s с номером патча %d (%.8s)",
                         texture->name, i, lumpinfo[pat]->name);
+                direct = 0;
                 continue;
             }
 
+            // A masked column is the patch column itself if the patch
+            // fits in the texture, and there are no tall patch posts.
+            if (SHORT(realpatch->height) > texture->height || texture->height > 254)
+            {
+                direct &= ~COMPOSITE_DIRECT(COMPOSITE_MASKED);
+            }
+
             if (x2 > texture->width)
             {
                 x2 = texture->width;
@@ -480,6 +568,13 @@ static void R_GenerateLookup (int texnum)
                 const column_t *col = (const column_t*)((const byte*) realpatch + LONG(cofs[x]));
                 const byte *base = (const byte *) col;
 
+                // An opaque column is the first post of the patch
+                // column if it covers the whole texture height.
+                if (col->topdelta != 0 || col->length < texture->height)
+                {
+                    direct &= ~COMPOSITE_DIRECT(COMPOSITE_OPAQUE);
+                }
+
                 // count posts
                 for ( ; col->topdelta != 0xff ; postcount[x]++)
                 {
@@ -496,6 +591,16 @@ static void R_GenerateLookup (int texnum)
         }
     }
 
+    // Only textures whose columns all come from a single patch
+    // can be read straight from the patches.
+    for (x=0 ; x<texture->width ; x++)
+    {
+        if (patchcount[x] != 1)
+        {
+            direct = 0;
+        }
+    }
+
     // Now count the number of columns
     //  that are covered by more than one patch.
     // Fill in the lump / offset, so columns
@@ -523,6 +628,23 @@ static void R_GenerateLookup (int texnum)
             collump[x] = -1;	
         }
 
+        if (direct & COMPOSITE_DIRECT(COMPOSITE_OPAQUE))
+        {
+            // point at the post data in the patch
+            colofs2[x] = colofs[x];
+        }
+        else
+        {
+            // [crispy] initialize opaque texture column offset
+            colofs2[x] = x * texture->height;
+        }
+
+        if (direct & COMPOSITE_DIRECT(COMPOSITE_MASKED))
+        {
+            // keep pointing at the patch column
+            continue;
+        }
+
         // killough 1/25/98, 4/9/98:
         //
         // Fix Medusa bug, by adding room for column header
@@ -536,16 +658,379 @@ static void R_GenerateLookup (int texnum)
         // killough 12/98: add room for one extra post
         csize += 4 * postcount[x] + 5; // 1 stop byte plus 4 bytes per post
         csize += texture->height; // height bytes of texture data
-        // [crispy] initialize opaque texture column offset
-        colofs2[x] = x * texture->height;
     }
 
     texturecompositesize[texnum] = csize;
+    texturedirect[texnum] = direct;
 
     Z_Free(patchcount);
     Z_Free(postcount);
 }
 
+// -----------------------------------------------------------------------------
+// Composite cache.
+//
+// Composites are built on first use, or for the whole level by
+// R_PrecacheLevel, and are locked in memory while they fit in
+// composite_budget. When there is no room left, the composites drawn the
+// longest ago are changed to PU_CACHE, so the zone memory can take them
+// back when it needs to. Textures that can be read straight from their
+// patches (see R_GenerateLookup) have no composites at all.
+//
+// Locked composites are kept in a list from the most to the least
+// recently drawn, so the ones to unlock are found at its end.
+// -----------------------------------------------------------------------------
+
+typedef struct
+{
+    int     lasttic;    // gametic when last drawn, -1 if purgable
+    boolean purgable;   // block is PU_CACHE and may be gone
+    int     newer;      // next more recently drawn locked composite, or -1
+    int     older;      // next less recently drawn locked composite, or -1
+} compositecache_t;
+
+static compositecache_t *compositecache[2];
+
+// Locked composites are identified by COMPOSITE_ID in the list.
+#define COMPOSITE_ID(texnum, kind)  ((texnum) * 2 + (kind))
+
+static int composite_newest = -1;
+static int composite_oldest = -1;
+
+#define DEFAULT_COMPOSITE_BUDGET 8 /* MiB */
+
+static int composite_budget;  // bytes of composites allowed to stay locked
+static int composite_locked;  // bytes of composites locked now
+
+// Statistics, shown at shutdown with -texstats.
+
+static unsigned int composite_hits, composite_misses, composite_purged;
+static unsigned long composite_bytes;
+static int composite_maxlocked;
+
+static const byte **R_CompositeSlot (int texnum, int kind)
+{
+    return kind == COMPOSITE_MASKED ? &texturecomposite[texnum]
+                                    : &texturecomposite2[texnum];
+}
+
+static int R_CompositeSize (int texnum, int kind)
+{
+    return kind == COMPOSITE_MASKED ? texturecompositesize[texnum]
+                                    : textures[texnum]->width * textures[texnum]->height;
+}
+
+static compositecache_t *R_CompositeEntry (int id)
+{
+    return &compositecache[id & 1][id >> 1];
+}
+
+//
+// Take a composite out of the list of locked composites.
+//
+
+static void R_UnlinkComposite (int id)
+{
+    compositecache_t *entry = R_CompositeEntry(id);
+
+    if (entry->newer >= 0)
+    {
+        R_CompositeEntry(entry->newer)->older = entry->older;
+    }
+    else
+    {
+        composite_newest = entry->older;
+    }
+
+    if (entry->older >= 0)
+    {
+        R_CompositeEntry(entry->older)->newer = entry->newer;
+    }
+    else
+    {
+        composite_oldest = entry->newer;
+    }
+
+    entry->newer = entry->older = -1;
+}
+
+//
+// Put a composite at the most recently drawn end of the list.
+//
+
+static void R_LinkComposite (int id)
+{
+    compositecache_t *entry = R_CompositeEntry(id);
+
+    entry->newer = -1;
+    entry->older = composite_newest;
+
+    if (composite_newest >= 0)
+    {
+        R_CompositeEntry(composite_newest)->newer = id;
+    }
+    else
+    {
+        composite_oldest = id;
+    }
+
+    composite_newest = id;
+}
+
+//
+// Make a composite purgable.
+//
+
+static void R_UnlockComposite (int texnum, int kind)
+{
+    compositecache_t *entry = &compositecache[kind][texnum];
+    const byte **slot = R_CompositeSlot(texnum, kind);
+
+    if (*slot == NULL || entry->purgable)
+    {
+        return;
+    }
+
+    R_UnlinkComposite(COMPOSITE_ID(texnum, kind));
+    Z_ChangeTag((void *) *slot, PU_CACHE);
+    entry->purgable = true;
+    entry->lasttic = -1;
+    composite_locked -= R_CompositeSize(texnum, kind);
+}
+
+//
+// Unlock the least recently drawn composites until size more bytes fit
+// in the budget. Composites drawn during this tic are never unlocked, as
+// the renderer may still be using them.
+//
+
+static void R_MakeCompositeRoom (int size)
+{
+    while (composite_locked + size > composite_budget
+        && composite_oldest >= 0
+        && R_CompositeEntry(composite_oldest)->lasttic != gametic)
+    {
+        R_UnlockComposite(composite_oldest >> 1, composite_oldest & 1);
+    }
+}
+
+//
+// Lock a composite for drawing. Returns true if it is still in memory,
+// otherwise allocates its block and returns false; the caller must
+// generate it then.
+//
+
+static boolean R_LockComposite (int texnum, int kind)
+{
+    compositecache_t *entry = &compositecache[kind][texnum];
+    const byte **slot = R_CompositeSlot(texnum, kind);
+    const int size = R_CompositeSize(texnum, kind);
+
+    if (*slot != NULL && !entry->purgable)
+    {
+        entry->lasttic = gametic;
+        R_UnlinkComposite(COMPOSITE_ID(texnum, kind));
+        R_LinkComposite(COMPOSITE_ID(texnum, kind));
+        composite_hits++;
+        return true;
+    }
+
+    R_MakeCompositeRoom(size);
+
+    composite_locked += size;
+
+    if (composite_locked > composite_maxlocked)
+    {
+        composite_maxlocked = composite_locked;
+    }
+
+    entry->lasttic = gametic;
+    R_LinkComposite(COMPOSITE_ID(texnum, kind));
+
+    if (*slot != NULL)
+    {
+        // Still there, take it back.
+        Z_ChangeTag((void *) *slot, PU_STATIC);
+        entry->purgable = false;
+        composite_hits++;
+        return true;
+    }
+
+    if (entry->purgable)
+    {
+        composite_purged++;
+        entry->purgable = false;
+    }
+
+    composite_misses++;
+    composite_bytes += size;
+    Z_Malloc(size, PU_STATIC, slot);
+
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// R_GenerateComposites
+// Composite a list of textures on the worker threads. The textures are
+// done in batches: while the workers composite one batch, this thread loads
+// the patches of the next one. The composite blocks must be allocated by
+// R_LockComposite already.
+// -----------------------------------------------------------------------------
+
+#define COMPOSITE_BATCH 128
+
+typedef struct
+{
+    int texnum;
+    int kind;
+} compositejob_t;
+
+typedef struct
+{
+    const compositejob_t *jobs;
+    int       count;       // number of textures in the batch
+    patch_t **patches;     // cached patches of all the textures, in order
+    int      *patchstart;  // index in patches of each texture's first patch
+    int       patchesalloced;
+} compositebatch_t;
+
+static compositebatch_t cachebatch;  // for composites built while drawing
+
+static void R_CompositeJob (void *data, int index)
+{
+    const compositebatch_t *batch = data;
+    const compositejob_t *job = &batch->jobs[index];
+    patch_t **realpatches = batch->patches + batch->patchstart[index];
+
+    if (job->kind == COMPOSITE_MASKED)
+    {
+        R_GenerateComposite(job->texnum, realpatches);
+    }
+    else
+    {
+        R_GenerateOpaqueComposite(job->texnum, realpatches);
+    }
+}
+
+static void R_PrepareCompositeBatch (compositebatch_t *batch,
+                                     const compositejob_t *jobs, int count)
+{
+    int i, j, numpatches;
+    texture_t *texture;
+
+    batch->jobs = jobs;
+    batch->count = count > COMPOSITE_BATCH ? COMPOSITE_BATCH : count;
+
+    if (batch->patchstart == NULL)
+    {
+        batch->patchstart = I_Realloc(NULL, COMPOSITE_BATCH * sizeof(*batch->patchstart));
+    }
+
+    numpatches = 0;
+
+    for (i = 0 ; i < batch->count ; i++)
+    {
+        numpatches += textures[jobs[i].texnum]->patchcount;
+    }
+
+    if (numpatches > batch->patchesalloced)
+    {
+        batch->patchesalloced = numpatches;
+        batch->patches = I_Realloc(batch->patches, numpatches * sizeof(*batch->patches));
+    }
+
+    numpatches = 0;
+
+    for (i = 0 ; i < batch->count ; i++)
+    {
+        texture = textures[jobs[i].texnum];
+        batch->patchstart[i] = numpatches;
+
+        for (j = 0 ; j < texture->patchcount ; j++)
+        {
+            batch->patches[numpatches++] = W_CacheLumpNum(texture->patches[j].patch, PU_STATIC);
+        }
+    }
+}
+
+//
+// Release the patches once no batch uses them any more. Patches are shared
+// between textures, so this can't be done batch by batch.
+//
+
+static void R_ReleaseCompositePatches (const compositejob_t *jobs, int count)
+{
+    int i, j;
+    texture_t *texture;
+
+    for (i = 0 ; i < count ; i++)
+    {
+        texture = textures[jobs[i].texnum];
+
+        for (j = 0 ; j < texture->patchcount ; j++)
+        {
+            W_ReleaseLumpNum(texture->patches[j].patch);
+        }
+    }
+}
+
+static void R_GenerateComposites (const compositejob_t *jobs, int count)
+{
+    compositebatch_t batches[2];
+    int i, cur, done;
+
+    memset(batches, 0, sizeof(batches));
+
+    R_PrepareCompositeBatch(&batches[0], jobs, count);
+    done = batches[0].count;
+
+    for (cur = 0 ; batches[cur].count > 0 ; cur ^= 1)
+    {
+        I_StartJob(R_CompositeJob, &batches[cur], batches[cur].count);
+        R_PrepareCompositeBatch(&batches[cur ^ 1], jobs + done, count - done);
+        done += batches[cur ^ 1].count;
+        I_FinishJob();
+    }
+
+    for (i = 0 ; i < 2 ; i++)
+    {
+        free(batches[i].patches);
+        free(batches[i].patchstart);
+    }
+
+    R_ReleaseCompositePatches(jobs, count);
+}
+
+//
+// Get a composite ready for drawing, building it if needed.
+//
+
+static void R_CacheComposite (int texnum, int kind)
+{
+    compositejob_t job;
+
+    if (R_LockComposite(texnum, kind))
+    {
+        return;
+    }
+
+    job.texnum = texnum;
+    job.kind = kind;
+
+    R_PrepareCompositeBatch(&cachebatch, &job, 1);
+    R_CompositeJob(&cachebatch, 0);
+    R_ReleaseCompositePatches(&job, 1);
+}
+
+static void R_PrintCompositeStats (void)
+{
+    printf(english_language ?
+           "R_PrintCompositeStats: %u hits, %u misses, %u purged; %lu KiB composited, at most %i KiB locked.\n" :
+           "R_PrintCompositeStats: %u попаданий, %u промахов, %u вытеснено; %lu КБ составлено, не более %i КБ закреплено.\n",
+           composite_hits, composite_misses, composite_purged,
+           composite_bytes / 1024, composite_maxlocked / 1024);
+}
+
 // -----------------------------------------------------------------------------
 // R_GetColumn
 // Retrieve column data for span blitting.
@@ -558,6 +1043,17 @@ const byte *R_GetColumn (const int tex, int col)
     col &= texturewidthmask[tex];
     ofs = texturecolumnofs2[tex][col];
 
+    // Read straight from the patch.
+    if (texturedirect[tex] & COMPOSITE_DIRECT(COMPOSITE_OPAQUE))
+    {
+        return (const byte *) W_CacheLumpNum(texturecolumnlump[tex][col], PU_CACHE) + ofs;
+    }
+
+    if (compositecache[COMPOSITE_OPAQUE][tex].lasttic != gametic)
+    {
+        R_CacheComposite(tex, COMPOSITE_OPAQUE);
+    }
+
     return texturecomposite2[tex] + ofs;
 }
 
@@ -578,6 +1074,17 @@ const byte *R_GetColumnMod (const int tex, int col)
     col %= texturewidth[tex];
     ofs = texturecolumnofs[tex][col];
 
+    // Read straight from the patch.
+    if (texturedirect[tex] & COMPOSITE_DIRECT(COMPOSITE_MASKED))
+    {
+        return (const byte *) W_CacheLumpNum(texturecolumnlump[tex][col], PU_CACHE) + ofs;
+    }
+
+    if (compositecache[COMPOSITE_MASKED][tex].lasttic != gametic)
+    {
+        R_CacheComposite(tex, COMPOSITE_MASKED);
+    }
+
     return texturecomposite[tex] + ofs;
 }
 
@@ -820,6 +1327,9 @@ static void R_InitTextures (void)
     texturewidth = Z_Malloc (numtextures * sizeof(*texturewidth), PU_STATIC, 0);
     textureheight = Z_Malloc (numtextures * sizeof(*textureheight), PU_STATIC, 0);
     texturebrightmap = Z_Malloc (numtextures * sizeof(*texturebrightmap), PU_STATIC, 0);
+    texturedirect = Z_Malloc (numtextures * sizeof(*texturedirect), PU_STATIC, 0);
+    compositecache[COMPOSITE_OPAQUE] = Z_Malloc (numtextures * sizeof(**compositecache), PU_STATIC, 0);
+    compositecache[COMPOSITE_MASKED] = Z_Malloc (numtextures * sizeof(**compositecache), PU_STATIC, 0);
 
     //	Really complex printing shit...
 
@@ -926,10 +1436,37 @@ static void R_InitTextures (void)
     for (i=0 ; i<numtextures ; i++)
     {
         R_GenerateLookup (i);
-        // [JN] Generate composite textures at startup.
-        R_GenerateComposite (i);
         // [JN] Create animation table.
         texturetranslation[i] = i;
+        // Composites are generated when first drawn.
+        compositecache[COMPOSITE_OPAQUE][i].lasttic = -1;
+        compositecache[COMPOSITE_OPAQUE][i].purgable = false;
+        compositecache[COMPOSITE_OPAQUE][i].newer = -1;
+        compositecache[COMPOSITE_OPAQUE][i].older = -1;
+        compositecache[COMPOSITE_MASKED][i] = compositecache[COMPOSITE_OPAQUE][i];
+    }
+
+    //!
+    // @arg <mb>
+    // @category video
+    //
+    // Keep up to <mb> MiB of composited wall textures locked in memory
+    // (default 8). Composites drawn the longest ago beyond that are
+    // left to the zone memory cache.
+    //
+
+    i = M_CheckParmWithArgs("-texcache", 1);
+    composite_budget = (i > 0 ? atoi(myargv[i + 1]) : DEFAULT_COMPOSITE_BUDGET) * 1024 * 1024;
+
+    //!
+    // @category video
+    //
+    // Show wall texture composite cache statistics when quitting.
+    //
+
+    if (M_ParmExists("-texstats"))
+    {
+        I_AtExit(R_PrintCompositeStats, true);
     }
 
     GenerateTextureHashTable();
@@ -1058,11 +1595,6 @@ static void R_InitColormaps (void)
 // based in parts on the implementation from boom202s/R_DATA.C:676-787
 // -----------------------------------------------------------------------------
 
-enum {
-    r, g, b
-} rgb_t;
-
-
 static void R_InitTransMaps (void)
 {
     // [JN] Check if we have a modified PLAYPAL palette to decide
@@ -1083,99 +1615,7 @@ static void R_InitTransMaps (void)
     else
     {
         // [JN] We do. Generate tables dynamically.
-
-        // Compose a default transparent filter map based on PLAYPAL.
-        unsigned char *playpal = W_CacheLumpName("PLAYPAL", PU_STATIC);
-
-        transtable90 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable80 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable70 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable60 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable50 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable40 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable30 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable20 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable10 = Z_Malloc(256*256, PU_STATIC, 0);
-
-        {
-            byte *fg, *bg, blend[3];
-            byte *tp90 = transtable90;
-            byte *tp80 = transtable80;
-            byte *tp70 = transtable70;
-            byte *tp60 = transtable60;
-            byte *tp50 = transtable50;
-            byte *tp40 = transtable40;
-            byte *tp30 = transtable30;
-            byte *tp20 = transtable20;
-            byte *tp10 = transtable10;
-            int i, j;
-
-            // [crispy] background color
-            for (i = 0; i < 256; i++)
-            {
-                // [crispy] foreground color
-                for (j = 0; j < 256; j++)
-                {
-                    // [crispy] shortcut: identical foreground and background
-                    if (i == j)
-                    {
-                        *tp90++ = i; *tp80++ = i; *tp70++ = i;
-                        *tp60++ = i; *tp50++ = i; *tp40++ = i;
-                        *tp30++ = i; *tp20++ = i; *tp10++ = i;
-                        continue;
-                    }
-
-                    bg = playpal + 3*i;
-                    fg = playpal + 3*j;
-
-                    blend[r] = (90 * fg[r] + (100 - 90) * bg[r]) / 100;
-                    blend[g] = (90 * fg[g] + (100 - 90) * bg[g]) / 100;
-                    blend[b] = (90 * fg[b] + (100 - 90) * bg[b]) / 100;
-                    *tp90++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (80 * fg[r] + (100 - 80) * bg[r]) / 100;
-                    blend[g] = (80 * fg[g] + (100 - 80) * bg[g]) / 100;
-                    blend[b] = (80 * fg[b] + (100 - 80) * bg[b]) / 100;
-                    *tp80++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (70 * fg[r] + (100 - 70) * bg[r]) / 100;
-                    blend[g] = (70 * fg[g] + (100 - 70) * bg[g]) / 100;
-                    blend[b] = (70 * fg[b] + (100 - 70) * bg[b]) / 100;
-                    *tp70++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (60 * fg[r] + (100 - 60) * bg[r]) / 100;
-                    blend[g] = (60 * fg[g] + (100 - 60) * bg[g]) / 100;
-                    blend[b] = (60 * fg[b] + (100 - 60) * bg[b]) / 100;
-                    *tp60++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (50 * fg[r] + (100 - 50) * bg[r]) / 100;
-                    blend[g] = (50 * fg[g] + (100 - 50) * bg[g]) / 100;
-                    blend[b] = (50 * fg[b] + (100 - 50) * bg[b]) / 100;
-                    *tp50++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (40 * fg[r] + (100 - 40) * bg[r]) / 100;
-                    blend[g] = (40 * fg[g] + (100 - 40) * bg[g]) / 100;
-                    blend[b] = (40 * fg[b] + (100 - 40) * bg[b]) / 100;
-                    *tp40++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (30 * fg[r] + (100 - 30) * bg[r]) / 100;
-                    blend[g] = (30 * fg[g] + (100 - 30) * bg[g]) / 100;
-                    blend[b] = (30 * fg[b] + (100 - 30) * bg[b]) / 100;
-                    *tp30++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (20 * fg[r] + (100 - 20) * bg[r]) / 100;
-                    blend[g] = (20 * fg[g] + (100 - 20) * bg[g]) / 100;
-                    blend[b] = (20 * fg[b] + (100 - 20) * bg[b]) / 100;
-                    *tp20++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (10 * fg[r] + (100 - 10) * bg[r]) / 100;
-                    blend[g] = (10 * fg[g] + (100 - 10) * bg[g]) / 100;
-                    blend[b] = (10 * fg[b] + (100 - 10) * bg[b]) / 100;
-                    *tp10++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-                }
-            }
-        }
-
+        V_InitTransTables(W_CacheLumpName("PLAYPAL", PU_STATIC));
         W_ReleaseLumpName("PLAYPAL");
     }
 }
@@ -1289,19 +1729,26 @@ int	R_TextureNumForName (char *name)
 
 void R_PrecacheLevel (void)
 {
-    int   i;
+    int   i, j, kind;
     byte *hitlist;
+    byte *texturehit[2];  // composites of each kind drawn in the level
+    compositejob_t *jobs;
+    int   numjobs;
 
-    if (demoplayback)
+    // Let the composites of the previous level go,
+    // the ones still drawn are locked again when drawn.
+    while (composite_oldest >= 0)
     {
-        return;
+        R_UnlockComposite(composite_oldest >> 1, composite_oldest & 1);
     }
 
+    if (demoplayback)
     {
-        size_t size = numflats > numsprites  ? numflats : numsprites;
-        hitlist = malloc(numtextures > size ? numtextures : size);
+        return;
     }
 
+    hitlist = malloc(numflats > numsprites ? numflats : numsprites);
+
     // Precache flats.
 
     memset(hitlist, 0, numflats);
@@ -1314,13 +1761,28 @@ void R_PrecacheLevel (void)
             W_CacheLumpNum(firstflat + i, PU_CACHE);
 
     // Precache textures.
+    // Mark which composites each texture is drawn with: mid textures
+    // of two-sided lines are masked, all the others are opaque.
+
+    texturehit[COMPOSITE_OPAQUE] = calloc(numtextures, 1);
+    texturehit[COMPOSITE_MASKED] = calloc(numtextures, 1);
+
+    for (i = numlines ; --i >= 0 ; )
+    {
+        kind = lines[i].backsector ? COMPOSITE_MASKED : COMPOSITE_OPAQUE;
 
-    memset(hitlist, 0, numtextures);
+        for (j = 0 ; j < 2 ; j++)
+        {
+            if (lines[i].sidenum[j] != NO_INDEX)
+            {
+                const side_t *side = &sides[lines[i].sidenum[j]];
 
-    for (i = numsides ; --i >= 0 ; )
-    hitlist[sides[i].bottomtexture] =
-    hitlist[sides[i].toptexture] =
-    hitlist[sides[i].midtexture] = 1;
+                texturehit[COMPOSITE_OPAQUE][side->toptexture] = 1;
+                texturehit[COMPOSITE_OPAQUE][side->bottomtexture] = 1;
+                texturehit[kind][side->midtexture] = 1;
+            }
+        }
+    }
 
     // Sky texture is always present.
     // Note that F_SKY1 is the name used to
@@ -1329,17 +1791,47 @@ void R_PrecacheLevel (void)
     //  a wall texture, with an episode dependend
     //  name.
 
-    hitlist[skytexture] = 1;
+    texturehit[COMPOSITE_OPAQUE][skytexture] = 1;
 
-    for (i = numtextures ; --i >= 0 ; )
-        if (hitlist[i])
+    // Build the composites that fit in the budget on the worker
+    // threads, the rest are built when drawn. Textures drawn straight
+    // from their patches only need the patches loaded.
+
+    jobs = malloc(numtextures * 2 * sizeof(*jobs));
+    numjobs = 0;
+
+    for (i = 0 ; i < numtextures ; i++)
+    {
+        for (kind = 0 ; kind < 2 ; kind++)
         {
-            texture_t *texture = textures[i];
-            int j = texture->patchcount;
+            if (!texturehit[kind][i])
+            {
+                continue;
+            }
 
-            while (--j >= 0)
-            W_CacheLumpNum(texture->patches[j].patch, PU_CACHE);
+            if (texturedirect[i] & COMPOSITE_DIRECT(kind))
+            {
+                texture_t *texture = textures[i];
+
+                j = texture->patchcount;
+
+                while (--j >= 0)
+                W_CacheLumpNum(texture->patches[j].patch, PU_CACHE);
+            }
+            else if (composite_locked + R_CompositeSize(i, kind) <= composite_budget
+                  && !R_LockComposite(i, kind))
+            {
+                jobs[numjobs].texnum = i;
+                jobs[numjobs].kind = kind;
+                numjobs++;
+            }
         }
+    }
+
+    R_GenerateComposites(jobs, numjobs);
+    free(jobs);
+    free(texturehit[COMPOSITE_OPAQUE]);
+    free(texturehit[COMPOSITE_MASKED]);
 
     // Precache sprites.
     memset(hitlist, 0, numsprites);
@@ -1370,6 +1862,63 @@ void R_PrecacheLevel (void)
     free(hitlist);
 }
 
+// -----------------------------------------------------------------------------
+// R_PrefetchFlat, R_PrefetchTexture, R_PrefetchSprite
+// Warm the caches for a level that is not loaded yet, see
+// P_PrefetchTicker. Everything is left purgable: once the level is
+// loaded, R_PrecacheLevel takes back what it really uses.
+// -----------------------------------------------------------------------------
+
+void R_PrefetchFlat (char *name)
+{
+    const int i = W_CheckNumForNameFromTo(name, lastflat, firstflat);
+
+    if (i != -1)
+    {
+        W_CacheLumpNum(i, PU_CACHE);
+    }
+}
+
+void R_PrefetchTexture (char *name, const boolean masked)
+{
+    const int texnum = R_CheckTextureNumForName(name);
+    const int kind = masked ? COMPOSITE_MASKED : COMPOSITE_OPAQUE;
+
+    // Missing, or the "NoTexture" marker.
+    if (texnum <= 0)
+    {
+        return;
+    }
+
+    if (texturedirect[texnum] & COMPOSITE_DIRECT(kind))
+    {
+        const texture_t *texture = textures[texnum];
+
+        for (int j = 0 ; j < texture->patchcount ; j++)
+        {
+            W_CacheLumpNum(texture->patches[j].patch, PU_CACHE);
+        }
+    }
+    else if (*R_CompositeSlot(texnum, kind) == NULL)
+    {
+        R_CacheComposite(texnum, kind);
+        R_UnlockComposite(texnum, kind);
+    }
+}
+
+void R_PrefetchSprite (const int sprite)
+{
+    for (int j = 0 ; j < sprites[sprite].numframes ; j++)
+    {
+        const short *sflump = sprites[sprite].spriteframes[j].lump;
+
+        for (int k = 0 ; k < 8 ; k++)
+        {
+            W_CacheLumpNum(firstspritelump + sflump[k], PU_CACHE);
+        }
+    }
+}
+
 // -----------------------------------------------------------------------------
 // [FG] check if the lump can be a Doom patch
 // taken from PrBoom+ prboom2/src/r_patch.c:L350-L390
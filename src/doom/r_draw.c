@@ -1610,6 +1610,52 @@ void R_InitBuffer (const int width, const int height)
     }
 }
 
+// -----------------------------------------------------------------------------
+// R_ScaleView
+// With a render scale below 100%, the 3D view is rendered into the top
+// left corner of the view window. Scale it up to the whole window. This is
+// done in place, from the bottom right, as every source pixel lies above
+// and to the left of the pixels it is copied to.
+// -----------------------------------------------------------------------------
+
+void R_ScaleView (void)
+{
+    static int *srccolumn = NULL;
+    static int  srccolumns = 0;
+    const int   srcwidth = viewwidth << detailshift;
+    const int   srcheight = viewheight << (detailshift && hires);
+    int         x, y;
+    byte       *dest;
+    const byte *source;
+
+    if (srcwidth == scaledviewwidth && srcheight == scaledviewheight)
+    {
+        return;
+    }
+
+    if (srccolumns < scaledviewwidth)
+    {
+        srccolumns = scaledviewwidth;
+        srccolumn = I_Realloc(srccolumn, srccolumns * sizeof(*srccolumn));
+    }
+
+    for (x = 0 ; x < scaledviewwidth ; x++)
+    {
+        srccolumn[x] = x * srcwidth / scaledviewwidth;
+    }
+
+    for (y = scaledviewheight ; --y >= 0 ; )
+    {
+        dest = ylookup[y] + viewwindowx;
+        source = ylookup[y * srcheight / scaledviewheight] + viewwindowx;
+
+        for (x = scaledviewwidth ; --x >= 0 ; )
+        {
+            dest[x] = source[srccolumn[x]];
+        }
+    }
+}
+
 // -----------------------------------------------------------------------------
 // R_FillBackScreen
 // Fills the back screen with a pattern for variable screen sizes.
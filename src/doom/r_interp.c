@@ -0,0 +1,150 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+// Copyright(C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Frame interpolation for uncapped framerate.
+//	Once per game tic, the sectors that moved during the tic are copied
+//	with their old and new heights into a compact snapshot. Every frame,
+//	only the snapshot is interpolated, instead of checking each sector
+//	every time the BSP walk reaches it.
+//
+
+
+#include "doomstat.h" // [AM] leveltime
+#include "i_system.h"
+#include "r_local.h"
+#include "jn.h"
+
+
+// Fraction of a tic to interpolate by in this frame.
+// FRACUNIT when not interpolating, which gives current positions.
+fixed_t interpfrac = FRACUNIT;
+
+typedef struct
+{
+    sector_t *sector;
+    fixed_t   oldfloorheight, floorheight;
+    fixed_t   oldceilingheight, ceilingheight;
+} interpsector_t;
+
+static interpsector_t *interpsectors;
+static int numinterpsectors;
+static int interpsectorsalloced;
+
+// Gametic the snapshot was taken at.
+static int snapshottic = -1;
+
+// -----------------------------------------------------------------------------
+// R_ClearInterpolation
+// Drops the snapshot. Called when a new level is loaded.
+// -----------------------------------------------------------------------------
+
+void R_ClearInterpolation (void)
+{
+    numinterpsectors = 0;
+    snapshottic = -1;
+}
+
+// -----------------------------------------------------------------------------
+// R_SnapshotSectors
+// [AM] Only interpolate sectors moved by a thinker during the last tic.
+// Every other sector is drawn at its real heights until the next tic.
+// -----------------------------------------------------------------------------
+
+static void R_SnapshotSectors (void)
+{
+    if (interpsectorsalloced < numsectors)
+    {
+        interpsectorsalloced = numsectors;
+        interpsectors = I_Realloc(interpsectors, numsectors * sizeof(*interpsectors));
+    }
+
+    numinterpsectors = 0;
+
+    for (int i = 0 ; i < numsectors ; i++)
+    {
+        sector_t *const sector = &sectors[i];
+
+        if (sector->oldgametic == gametic - 1 && sector->specialdata
+        && (sector->floorheight != sector->oldfloorheight
+        ||  sector->ceilingheight != sector->oldceilingheight))
+        {
+            interpsector_t *const is = &interpsectors[numinterpsectors++];
+
+            is->sector = sector;
+            is->oldfloorheight = sector->oldfloorheight;
+            is->floorheight = sector->floorheight;
+            is->oldceilingheight = sector->oldceilingheight;
+            is->ceilingheight = sector->ceilingheight;
+        }
+        else
+        {
+            sector->interpfloorheight = sector->floorheight;
+            sector->interpceilingheight = sector->ceilingheight;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// R_InterpolateFrame
+// Sets up interpolated state for the frame about to be rendered.
+// Takes a new snapshot if a game tic has run since the last one.
+// -----------------------------------------------------------------------------
+
+void R_InterpolateFrame (void)
+{
+    // Don't interpolate during a paused state.
+    interpfrac = uncapped_fps && leveltime > oldleveltime ? fractionaltic : FRACUNIT;
+
+    if (snapshottic != gametic)
+    {
+        R_SnapshotSectors();
+        snapshottic = gametic;
+    }
+
+    for (int i = 0 ; i < numinterpsectors ; i++)
+    {
+        const interpsector_t *const is = &interpsectors[i];
+
+        is->sector->interpfloorheight = is->oldfloorheight
+                                      + FixedMul(is->floorheight - is->oldfloorheight, interpfrac);
+        is->sector->interpceilingheight = is->oldceilingheight
+                                        + FixedMul(is->ceilingheight - is->oldceilingheight, interpfrac);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// R_InterpolateMobj
+// [AM] Interpolate between current and last position, if prudent.
+// -----------------------------------------------------------------------------
+
+void R_InterpolateMobj (const mobj_t *thing, fixed_t *x, fixed_t *y, fixed_t *z, angle_t *angle)
+{
+    // Don't interpolate if the mobj did something
+    // that would necessitate turning it off for a tic.
+    if (thing->interp == true && interpfrac != FRACUNIT)
+    {
+        *x = thing->oldx + FixedMul(thing->x - thing->oldx, interpfrac);
+        *y = thing->oldy + FixedMul(thing->y - thing->oldy, interpfrac);
+        *z = thing->oldz + FixedMul(thing->z - thing->oldz, interpfrac);
+        *angle = R_InterpolateAngle(thing->oldangle, thing->angle, interpfrac);
+    }
+    else
+    {
+        *x = thing->x;
+        *y = thing->y;
+        *z = thing->z;
+        *angle = thing->angle;
+    }
+}
@@ -301,6 +301,33 @@ typedef struct
 
 } node_t;
 
+//
+// Copy of the BSP made for walking it, by P_InitBSPTree.
+// Every node visited needs its partition line and children, but only
+// one of its bounding boxes, and only if the back side is checked.
+// Seg endpoints are all that's needed to drop segs facing away.
+//
+
+typedef struct
+{
+    // Partition line, laid out as divline_t.
+    fixed_t x;
+    fixed_t y;
+    fixed_t dx;
+    fixed_t dy;
+
+    int children[2];
+
+} bspnode_t;
+
+typedef struct
+{
+    // [crispy] pseudovertexes, see P_RemoveSlimeTrails
+    fixed_t x1, y1;
+    fixed_t x2, y2;
+
+} bspseg_t;
+
 // This could be wider for >8 bit display. 
 // Indeed, true color support is posibble precalculating 24bpp 
 // lightmap/colormap LUT. From darkening PLAYPAL to all black.
@@ -499,6 +526,9 @@ int R_FlatNumForName (char *name);
 int R_TextureNumForName (char *name);
 void R_InitData (void);
 void R_PrecacheLevel (void);
+void R_PrefetchFlat (char *name);
+void R_PrefetchTexture (char *name, const boolean masked);
+void R_PrefetchSprite (const int sprite);
 boolean R_IsPatchLump (const int lump);
 extern byte *blue_blood_set;
 extern byte *green_blood_set;
@@ -550,10 +580,21 @@ void R_DrawTranslatedTLColumnLow (void);
 void R_DrawViewBorder (void);
 void R_FillBackScreen (void);
 void R_InitBuffer (int width, int height);
+void R_ScaleView (void);
 void R_SetFuzzPosDraw (void);
 void R_SetFuzzPosTic (void);
 void R_VideoErase (unsigned ofs, const int count);
 
+// -----------------------------------------------------------------------------
+// R_INTERP
+// -----------------------------------------------------------------------------
+
+extern fixed_t interpfrac;
+
+void R_ClearInterpolation (void);
+void R_InterpolateFrame (void);
+void R_InterpolateMobj (const mobj_t *thing, fixed_t *x, fixed_t *y, fixed_t *z, angle_t *angle);
+
 // -----------------------------------------------------------------------------
 // R_MAIN
 // -----------------------------------------------------------------------------
@@ -586,6 +627,8 @@ extern int centerx, centery;
 extern int extralight;
 extern int maxlightz, lightzshift;
 extern int rendered_segs, rendered_visplanes, rendered_vissprites;
+extern unsigned int newvisplanes;
+extern int rendered_clipsegs;
 extern int skyflatnum, skytexture, skytexturemid;
 extern int validcount;
 extern int viewwindowx, viewwindowy;
@@ -611,9 +654,15 @@ angle_t R_PointToAngle (fixed_t x, fixed_t y);
 angle_t R_PointToAngle2 (fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2);
 angle_t R_PointToAngleCrispy (fixed_t x, fixed_t y);
 int R_PointOnSegSide (fixed_t x, fixed_t y, const seg_t *line);
-int R_PointOnSide (fixed_t x, fixed_t y, const node_t *node);
+int R_PointOnSide (fixed_t x, fixed_t y, const bspnode_t *node);
 subsector_t *R_PointInSubsector (fixed_t x, fixed_t y);
 void R_ExecuteSetViewSize (void);
+
+// Render scale, percent of the view window size.
+#define RENDER_SCALE_MIN 25
+
+extern int render_scale;
+extern int dynamic_resolution;
 void R_Init (void);
 void R_RenderMaskedSegRange (drawseg_t *ds, int x1, int x2);
 void R_RenderPlayerView (player_t *player);
@@ -649,6 +698,7 @@ extern int  scaledviewwidth, scaledviewheight;
 extern int *flipscreenwidth;
 extern int *flipviewwidth;
 extern int  firstflat;
+extern int  numflats;
 extern int *flattranslation, *texturetranslation;
 extern int  firstspritelump, lastspritelump, numspritelumps;
 
@@ -665,6 +715,9 @@ extern int          numsubsectors;
 extern subsector_t *subsectors;
 extern int          numnodes;
 extern node_t      *nodes;
+extern bspnode_t   *bspnodes;
+extern fixed_t    (*bspbboxes)[2][4];
+extern bspseg_t    *bspsegs;
 extern int          numlines;
 extern line_t      *lines;
 extern int          numsides;
@@ -742,7 +795,7 @@ extern int      bmap_flick;   // [JN] Animated brightmaps.
 extern int      bmap_glow;
 
 void R_AddPSprites (void);
-void R_AddSprites (const sector_t *sec);
+int R_AddSprites (const sector_t *sec);
 void R_ClearSprites (void);
 void R_ClipVisSprite (vissprite_t *vis, int xl, int xh);
 void R_DrawMasked (void);
@@ -22,6 +22,7 @@
 
 
 #include "doomstat.h" // [AM] leveltime, paused, menuactive
+#include "i_timer.h"
 #include "p_local.h"
 #include "z_zone.h"
 #include "v_video.h"
@@ -38,6 +39,7 @@ boolean original_playpal = true;
 
 // [JN] Used by perfomance counter.
 int rendered_segs, rendered_visplanes, rendered_vissprites;
+int rendered_clipsegs;  // drawsegs looked at to clip sprites
 
 int           viewangleoffset;
 int           validcount = 1;   // increment every time a check is made
@@ -52,6 +54,19 @@ lighttable_t *fixedcolormap;
 
 int     setblocks;
 boolean setsizeneeded;
+
+// Render scale: the 3D view is rendered at this percentage of the view
+// window size, and scaled up to the window by R_ScaleView. With dynamic
+// resolution it is the upper limit, and the scale in use follows the time
+// it takes to render the view. It cannot exceed 100%: the view is drawn
+// straight into the framebuffer, so for more detail raise the rendering
+// resolution instead.
+int render_scale = 100;
+int dynamic_resolution = 0;
+
+static int viewscale = 100;  // scale in use
+
+#define VIEWSCALE(x) ((x) * viewscale / 100)
 // [crispy] lookup table for horizontal screen coordinates
 // [JN] Resolution limitation is removed.
 int *flipscreenwidth;
@@ -114,7 +129,7 @@ void (*spanfunc) (fixed_t x1, fixed_t x2, fixed_t const y,
 // [JN] killough 5/2/98: reformatted
 // -----------------------------------------------------------------------------
 
-int R_PointOnSide (fixed_t x, fixed_t y, const node_t *node)
+int R_PointOnSide (fixed_t x, fixed_t y, const bspnode_t *node)
 {
     if (!node->dx)
     {
@@ -371,7 +386,7 @@ static void R_InitTextureMapping (void)
     // [crispy] in widescreen mode, make sure the same number of horizontal
     // pixels shows the same part of the game scene as in regular rendering mode
     fixed_t focalwidth;
-    focalwidth = (((ORIGWIDTH << hires)>>detailshift)/2)<<FRACBITS;
+    focalwidth = VIEWSCALE(((ORIGWIDTH << hires)>>detailshift)/2)<<FRACBITS;
     focallength = FixedDiv (aspect_ratio >= 2 ? focalwidth : 
                             centerxfrac, finetangent[FINEANGLES/4+FIELDOFVIEW/2] );
 
@@ -603,8 +618,16 @@ void R_ExecuteSetViewSize (void)
         }
     }
 
-    viewwidth = scaledviewwidth >> detailshift;
-    viewheight = scaledviewheight >> (detailshift && hires);
+    // Apply render scale.
+    render_scale = BETWEEN(RENDER_SCALE_MIN, 100, render_scale);
+
+    if (!dynamic_resolution || viewscale > render_scale)
+    {
+        viewscale = render_scale;
+    }
+
+    viewwidth = VIEWSCALE(scaledviewwidth >> detailshift);
+    viewheight = VIEWSCALE(scaledviewheight >> (detailshift && hires));
 
     centery = viewheight/2;
     centerx = viewwidth/2;
@@ -613,7 +636,7 @@ void R_ExecuteSetViewSize (void)
 
     if (aspect_ratio >= 2)
     {
-        projection = MIN(centerxfrac, (((320 << hires) >> detailshift) / 2) << FRACBITS);
+        projection = MIN(centerxfrac, VIEWSCALE(((320 << hires) >> detailshift) / 2) << FRACBITS);
     }
     else
     {
@@ -666,21 +689,21 @@ void R_ExecuteSetViewSize (void)
     for (i = 0 ; i < viewheight ; i++)
     {
         const fixed_t num = (viewwidth << (detailshift && !hires)) / 2 * FRACUNIT;
-        const fixed_t num_wide = MIN(viewwidth << detailshift, ORIGWIDTH << !detailshift) / 2 * FRACUNIT;
+        const fixed_t num_wide = MIN(viewwidth << detailshift, VIEWSCALE(ORIGWIDTH << !detailshift)) / 2 * FRACUNIT;
 
         for (j = 0; j < lookdirs; j++)
         {
             if (aspect_ratio >= 2)
             {
-                dy = ((i-(viewheight/2 + ((j-lookdirmin) << (hires && !detailshift)) 
-                   * (screenblocks < 9 ? screenblocks : 9) / 10)) << FRACBITS) + FRACUNIT / 2;
+                dy = ((i-(viewheight/2 + VIEWSCALE(((j-lookdirmin) << (hires && !detailshift)) 
+                   * (screenblocks < 9 ? screenblocks : 9) / 10))) << FRACBITS) + FRACUNIT / 2;
 
                 dy = abs(dy / hires);
             }
             else
             {
-                dy = ((i-(viewheight/2 + ((j-lookdirmin) << (hires && !detailshift))
-                   * (screenblocks < 11 ? screenblocks : 11) / 10)) << FRACBITS) + FRACUNIT / 2;
+                dy = ((i-(viewheight/2 + VIEWSCALE(((j-lookdirmin) << (hires && !detailshift))
+                   * (screenblocks < 11 ? screenblocks : 11) / 10))) << FRACBITS) + FRACUNIT / 2;
             
                 dy = abs(dy);
             }
@@ -726,7 +749,7 @@ void R_ExecuteSetViewSize (void)
         flipscreenwidth[i] = flip_levels ? j : i;
     }
 
-    flipviewwidth = flipscreenwidth + (flip_levels ? (screenwidth - scaledviewwidth) : 0);
+    flipviewwidth = flipscreenwidth + (flip_levels ? (screenwidth - (viewwidth << detailshift)) : 0);
 
     // [JN] Skip weapon bobbing interpolation for next frame.
     skippsprinterp = true;
@@ -802,7 +825,7 @@ subsector_t *R_PointInSubsector (const fixed_t x, const fixed_t y)
 
     while (!(nodenum & NF_SUBSECTOR))
     {
-        nodenum = nodes[nodenum].children[R_PointOnSide(x, y, nodes+nodenum)];
+        nodenum = bspnodes[nodenum].children[R_PointOnSide(x, y, bspnodes+nodenum)];
     }
 
     return &subsectors[nodenum & ~NF_SUBSECTOR];
@@ -832,12 +855,12 @@ static void R_SetupFrame (player_t *player)
         leveltime > oldleveltime)
     {
         // Interpolate player camera from their old position to their current one.
-        viewx = player->mo->oldx + FixedMul(player->mo->x - player->mo->oldx, fractionaltic);
-        viewy = player->mo->oldy + FixedMul(player->mo->y - player->mo->oldy, fractionaltic);
-        viewz = player->oldviewz + FixedMul(player->viewz - player->oldviewz, fractionaltic);
-        viewangle = R_InterpolateAngle(player->mo->oldangle, player->mo->angle, fractionaltic) + viewangleoffset;
+        viewx = player->mo->oldx + FixedMul(player->mo->x - player->mo->oldx, interpfrac);
+        viewy = player->mo->oldy + FixedMul(player->mo->y - player->mo->oldy, interpfrac);
+        viewz = player->oldviewz + FixedMul(player->viewz - player->oldviewz, interpfrac);
+        viewangle = R_InterpolateAngle(player->mo->oldangle, player->mo->angle, interpfrac) + viewangleoffset;
 
-        pitch = (player->oldlookdir + (player->lookdir - player->oldlookdir) * FIXED2DOUBLE(fractionaltic)) / MLOOKUNIT;
+        pitch = (player->oldlookdir + (player->lookdir - player->oldlookdir) * FIXED2DOUBLE(interpfrac)) / MLOOKUNIT;
     }
     else
     {
@@ -872,13 +895,13 @@ static void R_SetupFrame (player_t *player)
 
     if (aspect_ratio >= 2)
     {
-        tempCentery = viewheight/2 + (pitch << (hires && !detailshift))
-                    * (screenblocks < 9 ? screenblocks : 9) / 10;
+        tempCentery = viewheight/2 + VIEWSCALE((pitch << (hires && !detailshift))
+                    * (screenblocks < 9 ? screenblocks : 9) / 10);
     }
     else
     {
-        tempCentery = viewheight/2 + (pitch << (hires && !detailshift))
-                    * (screenblocks < 11 ? screenblocks : 11) / 10;
+        tempCentery = viewheight/2 + VIEWSCALE((pitch << (hires && !detailshift))
+                    * (screenblocks < 11 ? screenblocks : 11) / 10);
     }
 
     if (centery != tempCentery)
@@ -945,6 +968,62 @@ void R_ClearStats (void)
     rendered_segs = 0;
     rendered_visplanes = 0;
     rendered_vissprites = 0;
+    rendered_clipsegs = 0;
+}
+
+// -----------------------------------------------------------------------------
+// R_AdjustViewScale
+// Dynamic resolution: lower the render scale when rendering the view
+// takes more than three quarters of a frame at max_fps, raise it back when
+// it takes less than half of one. Takes effect on the next frame.
+// -----------------------------------------------------------------------------
+
+static void R_AdjustViewScale (const int rendertime)
+{
+    static int slowframes, fastframes;
+    // Like I_FinishUpdate, only cap at max_fps when it is at least TICRATE.
+    const int frametime = 1000000 / (uncapped_fps && max_fps >= TICRATE ?
+                                     max_fps : TICRATE);
+    int scale = viewscale;
+
+    if (!dynamic_resolution)
+    {
+        return;
+    }
+
+    if (rendertime > frametime * 3 / 4)
+    {
+        // Back off quickly...
+        fastframes = 0;
+
+        if (++slowframes >= 4)
+        {
+            scale -= 5;
+        }
+    }
+    else if (rendertime < frametime / 2)
+    {
+        // ...and come back slowly, so the scale does not hunt.
+        slowframes = 0;
+
+        if (++fastframes >= TICRATE)
+        {
+            scale += 5;
+        }
+    }
+    else
+    {
+        slowframes = fastframes = 0;
+    }
+
+    scale = BETWEEN(RENDER_SCALE_MIN, render_scale, scale);
+
+    if (scale != viewscale)
+    {
+        viewscale = scale;
+        slowframes = fastframes = 0;
+        setsizeneeded = true;
+    }
 }
 
 // -----------------------------------------------------------------------------
@@ -953,6 +1032,10 @@ void R_ClearStats (void)
 
 void R_RenderPlayerView (player_t *player)
 {
+    const uint64_t starttime = dynamic_resolution ? I_GetTimeUS() : 0;
+    const uint64_t profilestart = levelprofile ? P_ProfileStartFrame() : 0;
+
+    R_InterpolateFrame ();
     R_SetupFrame (player);
 
     // Clear buffers.
@@ -1005,6 +1088,19 @@ void R_RenderPlayerView (player_t *player)
 
     R_DrawMasked ();
 
+    // Scale the view up to the view window.
+    R_ScaleView ();
+
     // Check for new console commands.
     NetUpdate ();				
+
+    if (dynamic_resolution)
+    {
+        R_AdjustViewScale((int) (I_GetTimeUS() - starttime));
+    }
+
+    if (levelprofile)
+    {
+        P_ProfileFrame(profilestart);
+    }
 }
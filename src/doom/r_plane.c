@@ -45,6 +45,7 @@ static visplane_t *visplanes[MAXVISPLANES];  // [JN] killough
 static visplane_t *freetail;                 // [JN] killough
 static visplane_t **freehead = &freetail;    // [JN] killough
 visplane_t *floorplane, *ceilingplane;
+unsigned int newvisplanes;                   // created so far, for -levelprofile
 
 // [JN] killough -- hash function for visplanes
 // Empirically verified to be fairly uniform:
@@ -254,6 +255,8 @@ static visplane_t *new_visplane (unsigned const int hash)
 {
     visplane_t *check = freetail;
 
+    newvisplanes++;
+
     if (!check)
     {
         check = calloc(1, sizeof(*check));
@@ -26,6 +26,7 @@
 #include "w_wad.h"
 #include "z_zone.h"
 #include "r_local.h"
+#include "jn.h"
 
 // swirl factors determine the number of waves per flat width
 
@@ -89,25 +90,48 @@ void R_InitDistortedFlats (void)
 	}
 }
 
+// Every flat warped in the current tic is kept, so a frame with
+// several swirling liquids does not warp them again for each visplane.
+// The buffers are kept for later tics too, only their contents expire.
+
+static char **distortedflats;
+static int   *distortedtics;
+static int    numdistortedflats;
+
 const char *R_DistortedFlat (const int flatnum)
 {
-	static int swirltic = -1;
-	static int swirlflat = -1;
-	static char distortedflat[FLATSIZE];
+	char *distortedflat;
 
-	if (swirltic != leveltime)
+	if (numdistortedflats <= flatnum)
 	{
-		offset = offsets + ((leveltime & (SEQUENCE - 1)) * FLATSIZE);
+		const int num = MAX(numflats, flatnum + 1);
+
+		distortedflats = I_Realloc(distortedflats, num * sizeof(*distortedflats));
+		distortedtics = I_Realloc(distortedtics, num * sizeof(*distortedtics));
+
+		for (int i = numdistortedflats; i < num; i++)
+		{
+			distortedflats[i] = NULL;
+			distortedtics[i] = -1;
+		}
 
-		swirltic = leveltime;
-		swirlflat = -1;
+		numdistortedflats = num;
 	}
 
-	if (swirlflat != flatnum)
+	if (!distortedflats[flatnum])
+	{
+		distortedflats[flatnum] = I_Realloc(NULL, FLATSIZE);
+	}
+
+	distortedflat = distortedflats[flatnum];
+
+	if (distortedtics[flatnum] != leveltime)
 	{
 		char *normalflat;
 		int i;
 
+		offset = offsets + ((leveltime & (SEQUENCE - 1)) * FLATSIZE);
+
         // [JN] Use defined flat
 		// normalflat = W_CacheLumpNum(flatnum, PU_STATIC);
         normalflat = W_CacheLumpNum(firstflat + flatnum, PU_LEVEL);
@@ -119,7 +143,7 @@ const char *R_DistortedFlat (const int flatnum)
 
 		Z_ChangeTag(normalflat, PU_CACHE);
 
-		swirlflat = flatnum;
+		distortedtics[flatnum] = leveltime;
 	}
 
 	return distortedflat;
@@ -76,19 +76,22 @@ typedef struct drawseg_xrange_item_s
     drawseg_t *user;
 } drawseg_xrange_item_t;
 
-typedef struct drawsegs_xrange_s
-{
-    drawseg_xrange_item_t *items;
-    int count;
-} drawsegs_xrange_t;
+// The drawsegs that can clip sprites, newest first, both all of them
+// and bucketed into tiles of screen columns. A drawseg is in every tile it
+// covers, so a sprite only has to look at the tiles it covers.
 
-#define DS_RANGES_COUNT 3
-static drawsegs_xrange_t drawsegs_xranges[DS_RANGES_COUNT];
+#define DS_TILE_SHIFT   5   // 32 columns per tile
+#define DS_MERGE_TILES  4   // sprites covering more tiles use the full list
 
 static drawseg_xrange_item_t *drawsegs_xrange;
 static unsigned int drawsegs_xrange_size = 0;
 static int drawsegs_xrange_count = 0;
 
+static drawseg_xrange_item_t *drawsegs_tiled;
+static unsigned int drawsegs_tiled_size = 0;
+static int *drawsegs_tilestart;  // [numtiles + 1] start of each tile in drawsegs_tiled
+static int numdrawsegtiles;
+
 
 // -----------------------------------------------------------------------------
 // R_InitSpritesRes
@@ -130,6 +133,13 @@ void R_InitSpritesRes(void)
 
     clipbot = calloc(1, 2 * screenwidth * sizeof(*clipbot));
     cliptop = clipbot + screenwidth;
+
+    if (drawsegs_tilestart)
+    {
+        free(drawsegs_tilestart);
+    }
+
+    drawsegs_tilestart = calloc(1, (((screenwidth - 1) >> DS_TILE_SHIFT) + 2) * sizeof(*drawsegs_tilestart));
 }
 
 // -----------------------------------------------------------------------------
@@ -549,29 +559,12 @@ static void R_ProjectSprite (const mobj_t *thing, const int lightnum)
     spriteframe_t *sprframe;
     boolean        flip;
     angle_t        ang;    
-    fixed_t        interpx, interpy, interpz, interpangle;
+    fixed_t        interpx, interpy, interpz;
+    angle_t        interpangle;
 
     // [AM] Interpolate between current and last position,
     //      if prudent.
-    if (uncapped_fps &&
-        // Don't interpolate if the mobj did something
-        // that would necessitate turning it off for a tic.
-        thing->interp == true &&
-        // Don't interpolate during a paused state.
-        leveltime > oldleveltime)
-    {
-        interpx = thing->oldx + FixedMul(thing->x - thing->oldx, fractionaltic);
-        interpy = thing->oldy + FixedMul(thing->y - thing->oldy, fractionaltic);
-        interpz = thing->oldz + FixedMul(thing->z - thing->oldz, fractionaltic);
-        interpangle = R_InterpolateAngle(thing->oldangle, thing->angle, fractionaltic);
-    }
-    else
-    {
-        interpx = thing->x;
-        interpy = thing->y;
-        interpz = thing->z;
-        interpangle = thing->angle;
-    }
+    R_InterpolateMobj(thing, &interpx, &interpy, &interpz, &interpangle);
 
     // [JN] Apply amplitude to floating powerups:
     if (floating_powerups && !vanillaparm
@@ -909,12 +902,14 @@ static void R_ProjectSprite (const mobj_t *thing, const int lightnum)
 // -----------------------------------------------------------------------------
 // R_AddSprites
 // During BSP traversal, this adds sprites by sector.
+// Returns the number of sprites added, for -levelprofile.
 // -----------------------------------------------------------------------------
 
-void R_AddSprites (const sector_t *sec)
+int R_AddSprites (const sector_t *sec)
 {
     const mobj_t *thing;
     const int lightnum = (sec->lightlevel >> LIGHTSEGSHIFT)+extralight;
+    const size_t first = num_vissprite;
 
     spritelights = scalelight[BETWEEN(0, LIGHTLEVELS-1, lightnum)];
 
@@ -923,6 +918,8 @@ void R_AddSprites (const sector_t *sec)
     {
         R_ProjectSprite (thing, lightnum);
     }
+
+    return (int) (num_vissprite - first);
 }
 
 // -----------------------------------------------------------------------------
@@ -1208,52 +1205,90 @@ static void R_DrawPlayerSprites (void)
 // linked lists, and to use faster sorting algorithm.
 // -----------------------------------------------------------------------------
 
-#define bcopyp(d, s, n) memcpy(d, s, (n) * sizeof(void *))
+// Sprites are sorted by scale, largest first. Ties keep the order the
+// sprites were projected in, which is roughly front to back thanks to BSP.
 
-// killough 9/2/98: merge sort
+// Few sprites are sorted faster by insertion.
+#define SORT_INSERTION_MAX 32
 
-static void msort(vissprite_t **s, vissprite_t **t, const int n)
+static void R_InsertionSortVisSprites (vissprite_t **s, const int n)
 {
-    if (n >= 16)
+    int i;
+
+    for (i = 1; i < n; i++)
     {
-        int n1 = n/2, n2 = n - n1;
-        vissprite_t **s1 = s, **s2 = s + n1, **d = t;
+        vissprite_t *temp = s[i];
 
-        msort(s1, t, n1);
-        msort(s2, t, n2);
+        if (s[i-1]->scale < temp->scale)
+        {
+            int j = i;
 
-        while ((*s1)->scale > (*s2)->scale ?
-              (*d++ = *s1++, --n1) : (*d++ = *s2++, --n2));
+            while ((s[j] = s[j-1])->scale < temp->scale && --j);
+            s[j] = temp;
+        }
+    }
+}
 
-        if (n2)
-        bcopyp(d, s2, n2);
-        else
-        bcopyp(d, s1, n1);
+// Key of a sprite for the radix sort: the sign bit of the scale is
+// flipped to sort it as unsigned, and the whole key inverted to get the
+// largest scales first.
+#define SORT_KEY(spr) (~((unsigned int) (spr)->scale ^ 0x80000000u))
 
-        bcopyp(s, t, n);
+// Stable LSD radix sort, one byte of the key per pass. Passes where
+// all the sprites have the same byte are skipped, which with the scales
+// of a typical scene is often the top one or two. t must have room for
+// n pointers.
+
+static void R_RadixSortVisSprites (vissprite_t **s, vissprite_t **t, const int n)
+{
+    static int count[4][256];
+    vissprite_t **src = s, **dst = t, **tmp;
+    unsigned int key;
+    int i, pass, shift, sum, c;
+
+    memset(count, 0, sizeof(count));
+
+    for (i = 0; i < n; i++)
+    {
+        key = SORT_KEY(s[i]);
+
+        count[0][key & 0xff]++;
+        count[1][(key >> 8) & 0xff]++;
+        count[2][(key >> 16) & 0xff]++;
+        count[3][key >> 24]++;
     }
-    else
+
+    for (pass = 0; pass < 4; pass++)
     {
-        int i;
+        shift = pass * 8;
 
-        for (i = 1; i < n; i++)
+        if (count[pass][(SORT_KEY(src[0]) >> shift) & 0xff] == n)
         {
-            vissprite_t *temp = s[i];
+            continue;
+        }
 
-            if (s[i-1]->scale < temp->scale)
-            {
-                int j = i;
+        for (i = 0, sum = 0; i < 256; i++)
+        {
+            c = count[pass][i];
+            count[pass][i] = sum;
+            sum += c;
+        }
 
-                while ((s[j] = s[j-1])->scale < temp->scale && --j);
-                s[j] = temp;
-            }
+        for (i = 0; i < n; i++)
+        {
+            dst[count[pass][(SORT_KEY(src[i]) >> shift) & 0xff]++] = src[i];
         }
+
+        tmp = src;
+        src = dst;
+        dst = tmp;
     }
-}
 
-// -----------------------------------------------------------------------------
-// R_SortVisSprites
-// -----------------------------------------------------------------------------
+    if (src != s)
+    {
+        memcpy(s, src, n * sizeof(*s));
+    }
+}
 
 static void R_SortVisSprites (void)
 {
@@ -1264,6 +1299,8 @@ static void R_SortVisSprites (void)
         // If we need to allocate more pointers for the vissprites,
         // allocate as many as were allocated for sprites -- killough
         // killough 9/22/98: allocate twice as many
+        // The second half is the radix sort buffer, so once grown to
+        // the peak sprite count nothing is allocated per frame.
 
         if (num_vissprite_ptrs < num_vissprite*2)
         {
@@ -1279,21 +1316,91 @@ static void R_SortVisSprites (void)
 
         // killough 9/22/98: replace qsort with merge sort, since the keys
         // are roughly in order to begin with, due to BSP rendering.
+        // Replace merge sort with radix sort, which does not depend
+        // on the order and has no recursion.
 
-        msort(vissprite_ptrs, vissprite_ptrs + num_vissprite, num_vissprite);
+        if (num_vissprite <= SORT_INSERTION_MAX)
+        {
+            R_InsertionSortVisSprites(vissprite_ptrs, num_vissprite);
+        }
+        else
+        {
+            R_RadixSortVisSprites(vissprite_ptrs, vissprite_ptrs + num_vissprite, num_vissprite);
+        }
     }
 }
 
 // -------------------------------------------------------------------------
-// R_DrawSprite
+// R_ClipSpriteBySeg
+// Clip a sprite by one drawseg, or draw the masked mid texture of a
+// drawseg behind it.
 // -------------------------------------------------------------------------
 
-static void R_DrawSprite (const vissprite_t *spr)
+static void R_ClipSpriteBySeg (const vissprite_t *spr, const drawseg_xrange_item_t *curr)
 {
     int x, r1, r2;
     drawseg_t *ds;
     fixed_t scale, lowscale;
 
+    rendered_clipsegs++;
+
+    // determine if the drawseg obscures the sprite
+    if (curr->x1 > spr->x2 || curr->x2 < spr->x1)
+    {
+        return;      // does not cover sprite
+    }
+
+    ds = curr->user;
+
+    if (ds->scale1 > ds->scale2)
+    {
+        lowscale = ds->scale2;
+        scale = ds->scale1;
+    }
+    else
+    {
+        lowscale = ds->scale1;
+        scale = ds->scale2;
+    }
+
+    if (scale < spr->scale || (lowscale < spr->scale
+    && !R_PointOnSegSide (spr->gx, spr->gy, ds->curline)))
+    {
+        if (ds->maskedtexturecol)       // masked mid texture?
+        {
+            r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
+            r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
+            R_RenderMaskedSegRange(ds, r1, r2);
+        }
+        return;               // seg is behind sprite
+    }
+
+    r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
+    r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
+
+    // clip this piece of the sprite
+    // killough 3/27/98: optimized and made much shorter
+
+    if (ds->silhouette&SIL_BOTTOM && spr->gz < ds->bsilheight) //bottom sil
+        for (x=r1 ; x<=r2 ; x++)
+            if (clipbot[x] == -2)
+                clipbot[x] = ds->sprbottomclip[x];
+
+    if (ds->silhouette&SIL_TOP && spr->gzt > ds->tsilheight)   // top sil
+        for (x=r1 ; x<=r2 ; x++)
+            if (cliptop[x] == -2)
+                cliptop[x] = ds->sprtopclip[x];
+}
+
+// -------------------------------------------------------------------------
+// R_DrawSprite
+// -------------------------------------------------------------------------
+
+static void R_DrawSprite (const vissprite_t *spr)
+{
+    int x, i;
+    int tile1, tile2;
+
     for (x = spr->x1 ; x<=spr->x2 ; x++)
     {
         clipbot[x] = cliptop[x] = -2;
@@ -1307,59 +1414,74 @@ static void R_DrawSprite (const vissprite_t *spr)
     // and buggy, by going past LEFT end of array):
 
     // [JN] Andrey Budko: optimization
+    // Only look at the drawsegs in the tiles covered by the sprite,
+    // still newest first, so the clipping is the same as with all of them.
+
+    tile1 = spr->x1 >> DS_TILE_SHIFT;
+    tile2 = spr->x2 >> DS_TILE_SHIFT;
 
-    if (drawsegs_xrange_size)
+    if (tile1 == tile2)
     {
-        const drawseg_xrange_item_t *last = &drawsegs_xrange[drawsegs_xrange_count - 1];
-        drawseg_xrange_item_t *curr = &drawsegs_xrange[-1];
-        while (++curr <= last)
-        {
-        // determine if the drawseg obscures the sprite
-        if (curr->x1 > spr->x2 || curr->x2 < spr->x1)
-        {
-            continue;      // does not cover sprite
-        }
-    
-        ds = curr->user;
-    
-        if (ds->scale1 > ds->scale2)
+        const drawseg_xrange_item_t *curr = &drawsegs_tiled[drawsegs_tilestart[tile1]];
+        const drawseg_xrange_item_t *last = &drawsegs_tiled[drawsegs_tilestart[tile1 + 1]];
+
+        for ( ; curr < last ; curr++)
         {
-            lowscale = ds->scale2;
-            scale = ds->scale1;
+            R_ClipSpriteBySeg(spr, curr);
         }
-        else
+    }
+    else if (tile2 - tile1 < DS_MERGE_TILES)
+    {
+        // Merge the tiles, which are in the same order, skipping the
+        // drawsegs that are in more than one of them.
+
+        const drawseg_xrange_item_t *curr[DS_MERGE_TILES];
+        const drawseg_xrange_item_t *last[DS_MERGE_TILES];
+        const drawseg_xrange_item_t *next;
+        const int numtiles = tile2 - tile1 + 1;
+
+        for (i = 0 ; i < numtiles ; i++)
         {
-            lowscale = ds->scale1;
-            scale = ds->scale2;
+            curr[i] = &drawsegs_tiled[drawsegs_tilestart[tile1 + i]];
+            last[i] = &drawsegs_tiled[drawsegs_tilestart[tile1 + i + 1]];
         }
-    
-        if (scale < spr->scale || (lowscale < spr->scale
-        && !R_PointOnSegSide (spr->gx, spr->gy, ds->curline)))
+
+        for (;;)
         {
-            if (ds->maskedtexturecol)       // masked mid texture?
+            next = NULL;
+
+            for (i = 0 ; i < numtiles ; i++)
+            {
+                if (curr[i] < last[i] && (next == NULL || curr[i]->user > next->user))
+                {
+                    next = curr[i];
+                }
+            }
+
+            if (next == NULL)
+            {
+                break;
+            }
+
+            R_ClipSpriteBySeg(spr, next);
+
+            for (i = numtiles ; --i >= 0 ; )
             {
-                r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
-                r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
-                R_RenderMaskedSegRange(ds, r1, r2);
+                if (curr[i] < last[i] && curr[i]->user == next->user)
+                {
+                    curr[i]++;
+                }
             }
-            continue;               // seg is behind sprite
         }
-    
-        r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
-        r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
-    
-        // clip this piece of the sprite
-        // killough 3/27/98: optimized and made much shorter
-    
-        if (ds->silhouette&SIL_BOTTOM && spr->gz < ds->bsilheight) //bottom sil
-            for (x=r1 ; x<=r2 ; x++)
-                if (clipbot[x] == -2)
-                    clipbot[x] = ds->sprbottomclip[x];
-    
-        if (ds->silhouette&SIL_TOP && spr->gzt > ds->tsilheight)   // top sil
-            for (x=r1 ; x<=r2 ; x++)
-                if (cliptop[x] == -2)
-                    cliptop[x] = ds->sprtopclip[x];
+    }
+    else
+    {
+        const drawseg_xrange_item_t *curr = drawsegs_xrange;
+        const drawseg_xrange_item_t *last = &drawsegs_xrange[drawsegs_xrange_count];
+
+        for ( ; curr < last ; curr++)
+        {
+            R_ClipSpriteBySeg(spr, curr);
         }
     }
 
@@ -1398,75 +1520,80 @@ void R_DrawMasked (void)
     // [JN] Andrey Budko
     // Makes sense for scenes with huge amount of drawsegs.
     // ~12% of speed improvement on epic.wad map05
-    for (i = 0 ; i < DS_RANGES_COUNT ; i++)
-    {
-        drawsegs_xranges[i].count = 0;
-    }
-
+    // Bucket the drawsegs into tiles of screen columns.
     if (num_vissprite > 0)
     {
+        int tile, total;
+
         if (drawsegs_xrange_size < maxdrawsegs)
         {
             drawsegs_xrange_size = 2 * maxdrawsegs;
-
-            for(i = 0; i < DS_RANGES_COUNT; i++)
-            {
-                drawsegs_xranges[i].items = I_Realloc(
-                drawsegs_xranges[i].items,
-                drawsegs_xrange_size * sizeof(drawsegs_xranges[i].items[0]));
-            }
+            drawsegs_xrange = I_Realloc(drawsegs_xrange,
+                                        drawsegs_xrange_size * sizeof(*drawsegs_xrange));
         }
 
+        numdrawsegtiles = ((viewwidth - 1) >> DS_TILE_SHIFT) + 1;
+        memset(drawsegs_tilestart, 0, (numdrawsegtiles + 1) * sizeof(*drawsegs_tilestart));
+        drawsegs_xrange_count = 0;
+
         for (ds = ds_p; ds-- > drawsegs;)
         {
             if (ds->silhouette || ds->maskedtexturecol)
             {
-                drawsegs_xranges[0].items[drawsegs_xranges[0].count].x1 = ds->x1;
-                drawsegs_xranges[0].items[drawsegs_xranges[0].count].x2 = ds->x2;
-                drawsegs_xranges[0].items[drawsegs_xranges[0].count].user = ds;
+                drawseg_xrange_item_t *item = &drawsegs_xrange[drawsegs_xrange_count++];
 
-                // [JN] Andrey Budko: ~13% of speed improvement on sunder.wad map10
-                if (ds->x1 < centerx)
-                {
-                    drawsegs_xranges[1].items[drawsegs_xranges[1].count] = 
-                    drawsegs_xranges[0].items[drawsegs_xranges[0].count];
-                    drawsegs_xranges[1].count++;
-                }
-                if (ds->x2 >= centerx)
+                item->x1 = ds->x1;
+                item->x2 = ds->x2;
+                item->user = ds;
+
+                // Count the drawsegs of each tile one slot up, so
+                // the running sum below gives the tile starts.
+                for (tile = ds->x1 >> DS_TILE_SHIFT ; tile <= ds->x2 >> DS_TILE_SHIFT ; tile++)
                 {
-                    drawsegs_xranges[2].items[drawsegs_xranges[2].count] = 
-                    drawsegs_xranges[0].items[drawsegs_xranges[0].count];
-                    drawsegs_xranges[2].count++;
+                    drawsegs_tilestart[tile + 1]++;
                 }
-
-                drawsegs_xranges[0].count++;
             }
         }
-    }
 
-    // draw all vissprites back to front
+        for (tile = 0 ; tile < numdrawsegtiles ; tile++)
+        {
+            drawsegs_tilestart[tile + 1] += drawsegs_tilestart[tile];
+        }
 
-    rendered_vissprites = num_vissprite;
-    for (i = num_vissprite ; --i>=0 ; )
-    {
-        vissprite_t* spr = vissprite_ptrs[i];
+        total = drawsegs_tilestart[numdrawsegtiles];
 
-        if (spr->x2 < centerx)
+        if (drawsegs_tiled_size < total)
         {
-            drawsegs_xrange = drawsegs_xranges[1].items;
-            drawsegs_xrange_count = drawsegs_xranges[1].count;
+            drawsegs_tiled_size = 2 * total;
+            drawsegs_tiled = I_Realloc(drawsegs_tiled,
+                                       drawsegs_tiled_size * sizeof(*drawsegs_tiled));
         }
-        else if (spr->x1 >= centerx)
+
+        // Fill the tiles in order, using the starts as cursors,
+        // which leaves each one at the start of the next tile.
+        for (i = 0 ; i < drawsegs_xrange_count ; i++)
         {
-            drawsegs_xrange = drawsegs_xranges[2].items;
-            drawsegs_xrange_count = drawsegs_xranges[2].count;
+            const drawseg_xrange_item_t *item = &drawsegs_xrange[i];
+
+            for (tile = item->x1 >> DS_TILE_SHIFT ; tile <= item->x2 >> DS_TILE_SHIFT ; tile++)
+            {
+                drawsegs_tiled[drawsegs_tilestart[tile]++] = *item;
+            }
         }
-        else
+
+        for (tile = numdrawsegtiles ; tile > 0 ; tile--)
         {
-            drawsegs_xrange = drawsegs_xranges[0].items;
-            drawsegs_xrange_count = drawsegs_xranges[0].count;
+            drawsegs_tilestart[tile] = drawsegs_tilestart[tile - 1];
         }
 
+        drawsegs_tilestart[0] = 0;
+    }
+
+    // draw all vissprites back to front
+
+    rendered_vissprites = num_vissprite;
+    for (i = num_vissprite ; --i>=0 ; )
+    {
         R_DrawSprite(vissprite_ptrs[i]);    // [JN] killough
     }
 
@@ -387,6 +387,59 @@ void S_Start (void)
     S_ChangeMusic(mnum, true);
 }
 
+// -----------------------------------------------------------------------------
+// S_AddMobjSounds
+// Adds the sounds made by a type of thing to the ones to precache.
+// -----------------------------------------------------------------------------
+
+static void S_AddMobjSounds (const mobjinfo_t *info)
+{
+    const int sfx[5] = { info->seesound, info->attacksound, info->painsound,
+                         info->deathsound, info->activesound };
+
+    for (int i = 0 ; i < 5 ; i++)
+    {
+        if (sfx[i] > sfx_None && sfx[i] < NUMSFX)
+        {
+            I_AddLevelSound(&S_sfx[sfx[i]]);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// S_PrecacheLevelSounds
+// Lets the sound module prepare the sounds made by the things in the level
+// and their pitch-shifted variants, so they are ready when first heard.
+// -----------------------------------------------------------------------------
+
+void S_PrecacheLevelSounds (void)
+{
+    boolean mobjtypes[NUMMOBJTYPES];
+    thinker_t *th;
+
+    memset(mobjtypes, 0, sizeof(mobjtypes));
+
+    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+    {
+        if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+        {
+            mobjtypes[((mobj_t *)th)->type] = true;
+        }
+    }
+
+    for (int i = 0 ; i < NUMMOBJTYPES ; i++)
+    {
+        if (mobjtypes[i])
+        {
+            S_AddMobjSounds(&mobjinfo[i]);
+        }
+    }
+
+    // Most sounds are shifted by up to 16 either way, saw sounds by up
+    // to 8 (see S_StartSound).
+    I_PrecacheLevelSounds(16);
+}
+
 // -----------------------------------------------------------------------------
 // S_StopSound
 // -----------------------------------------------------------------------------
@@ -48,6 +48,9 @@ void S_UpdateStereoSeparation(void);
 //  determines music if any, changes music.
 void S_Start(void);
 
+// Prepares the sounds used in the level, after it is loaded.
+void S_PrecacheLevelSounds(void);
+
 // Start sound for thing at <origin>
 //  using <sound_id> from sounds.h
 void S_StartSound(void *origin_p, int sfx_id);
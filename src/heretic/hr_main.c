@@ -1703,6 +1703,7 @@ void D_DoomMain(void)
                "S_Init: Setting up sound.\n" :
                "S_Init: Активация звуковой системы.\n");
     S_Init();
+    I_RenderAudio();
     //IO_StartupTimer();
     S_Start();
 
@@ -511,6 +511,7 @@ extern const fixed_t P_FindNextHighestFloor (const sector_t *sec, const int curr
 extern const int EV_DoDonut (const line_t *line);
 extern const int P_FindMinSurroundingLight (const sector_t *sector, const int max);
 extern const int P_FindSectorFromLineTag (const line_t *line, const int start);
+extern void P_InitTagIndex (void);
 extern const int twoSided (const int sector, const int line);
 
 extern const sector_t *getNextSector (const line_t *line, const sector_t *sec);
@@ -1648,6 +1648,9 @@ void P_UnArchiveWorld(void)
             si->midtexture = SV_ReadWord();
         }
     }
+
+    // Sector tags may have been changed
+    P_InitTagIndex();
 }
 
 //=============================================================================
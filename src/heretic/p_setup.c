@@ -2032,6 +2032,7 @@ void P_SetupLevel (int episode, int map, int playermask, skill_t skill)
     crispy_validblockmap = P_LoadBlockMap (lumpnum+ML_BLOCKMAP); // [crispy] (re-)create BLOCKMAP if necessary
     P_LoadVertexes (lumpnum+ML_VERTEXES);
     P_LoadSectors (lumpnum+ML_SECTORS);
+    P_InitTagIndex ();
     P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
 
     if (crispy_mapformat & HEXEN)
@@ -2129,6 +2130,7 @@ void P_SetupLevel (int episode, int map, int playermask, skill_t skill)
     if (precache)
     {
         R_PrecacheLevel();
+        S_PrecacheLevelSounds();
     }
 
     endtime = SDL_GetTicks() - starttime;
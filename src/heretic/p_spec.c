@@ -24,6 +24,7 @@
 #include "i_system.h"
 #include "i_swap.h"
 #include "i_timer.h"
+#include "m_tags.h"
 #include "s_sound.h"
 #include "w_wad.h"
 #include "jn.h"
@@ -597,6 +598,30 @@ const fixed_t P_FindHighestCeilingSurrounding (const sector_t *sec)
     return height;
 }
 
+/*
+================================================================================
+
+                         INDEX THE SECTORS BY TAG
+
+ So activating a special does not have to scan every sector.
+ Must be called when sectors or their tags are loaded, i.e. by
+ P_SetupLevel and when a saved game is loaded.
+
+================================================================================
+*/
+
+static tagindex_t sectortags;
+
+static int P_SectorTag (const int i)
+{
+    return sectors[i].tag;
+}
+
+void P_InitTagIndex (void)
+{
+    M_BuildTagIndex(&sectortags, numsectors, P_SectorTag);
+}
+
 /*
 ================================================================================
 
@@ -607,14 +632,7 @@ const fixed_t P_FindHighestCeilingSurrounding (const sector_t *sec)
 
 const int P_FindSectorFromLineTag (const line_t *line, const int start)
 {
-    for (int i = start + 1; i < numsectors; i++)
-    {
-        if (sectors[i].tag == line->tag)
-        {
-            return i;
-        }
-    }
-    return -1;
+    return M_NextTagged(&sectortags, line->tag, start);
 }
 
 /*
@@ -84,6 +84,53 @@ void S_Start(void)
     memset(channel, 0, 8 * sizeof(channel_t));
 }
 
+// Let the sound module prepare the sounds made by the things in the
+// level and their pitch-shifted variants, so they are ready when first
+// heard.
+
+void S_PrecacheLevelSounds(void)
+{
+    boolean mobjtypes[NUMMOBJTYPES];
+    int sfx[5];
+    int i, j;
+    thinker_t *th;
+
+    memset(mobjtypes, 0, sizeof(mobjtypes));
+
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+        if (th->function == P_MobjThinker)
+        {
+            mobjtypes[((mobj_t *) th)->type] = true;
+        }
+    }
+
+    for (i = 0; i < NUMMOBJTYPES; i++)
+    {
+        if (!mobjtypes[i])
+        {
+            continue;
+        }
+
+        sfx[0] = mobjinfo[i].seesound;
+        sfx[1] = mobjinfo[i].attacksound;
+        sfx[2] = mobjinfo[i].painsound;
+        sfx[3] = mobjinfo[i].deathsound;
+        sfx[4] = mobjinfo[i].activesound;
+
+        for (j = 0; j < 5; j++)
+        {
+            if (sfx[j] > sfx_None && sfx[j] < NUMSFX)
+            {
+                I_AddLevelSound(&S_sfx[sfx[j]]);
+            }
+        }
+    }
+
+    // Sounds are shifted by up to 7 either way (see S_StartSound).
+    I_PrecacheLevelSounds(7);
+}
+
 void S_StartSong(int song, boolean loop, boolean replay)
 {
     int mus_len;
@@ -33,6 +33,7 @@ extern int snd_Channels;
 extern int snd_Channels_RD;
 
 void S_Start(void);
+void S_PrecacheLevelSounds(void);
 void S_StartSound(void *origin, int sound_id);
 void S_StartSoundAtVolume(void *origin, int sound_id, int volume);
 void S_StartSoundAmbient(void *origin, int sound_id);
@@ -867,6 +867,7 @@ void D_DoomMain(void)
     D_ConnectNetGame();
 
     S_Init();
+    I_RenderAudio();
     S_Start();
 
     ST_Message(english_language ?
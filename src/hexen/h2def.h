@@ -869,6 +869,7 @@ void SV_UpdateRebornSlot(void);
 void SV_ClearRebornSlot(void);
 boolean SV_RebornSlotAvailable(void);
 int SV_GetRebornSlot(void);
+void SV_FinishSaving(void);
 
 //-----
 //PLAY
@@ -2132,6 +2132,9 @@ static boolean ReadDescriptionForSlot(int slot, char *description)
 
     M_snprintf(name, sizeof(name), "%shexen-save-%d.sav", SavePath, slot);
 
+    // The last save may still be being written
+    SV_FinishSaving();
+
     fp = M_fopen(name, "rb");
 
     if (fp == NULL)
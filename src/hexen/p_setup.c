@@ -1913,6 +1913,7 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
     }
 
 // set up world state
+    P_InitTagIndex();
     P_SpawnSpecials();
 
 // build subsector connect matrix
@@ -1932,7 +1933,10 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
 
 // preload graphics
     if (precache)
+    {
         R_PrecacheLevel();
+        S_PrecacheLevelSounds();
+    }
 
     // Check if the level is a lightning level
     P_InitLightning();
@@ -24,6 +24,7 @@
 #include "i_system.h"
 #include "jn.h"
 #include "m_misc.h"
+#include "m_tags.h"
 #include "p_local.h"
 #include "s_sound.h"
 
@@ -66,11 +67,9 @@ struct
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
-static struct
-{
-    line_t *line;
-    int lineTag;
-} TaggedLines[MAX_TAGGED_LINES];
+// Sectors by tag, and lines by their Line_SetIdentification tag
+static tagindex_t SectorTags;
+static tagindex_t LineTags;
 static int TaggedLineCount;
 
 mobj_t LavaInflictor;
@@ -331,6 +330,26 @@ int     P_FindSectorFromLineTag(line_t  *line,int start)
 }
 */
 
+//=========================================================================
+//
+// P_InitTagIndex
+//
+// Index the sectors by tag, so activating a special does not have
+// to scan every sector. Must be called when sectors or their tags are
+// loaded, i.e. by P_SetupLevel and when a saved map is loaded.
+//
+//=========================================================================
+
+static int SectorTag(int i)
+{
+    return sectors[i].tag;
+}
+
+void P_InitTagIndex(void)
+{
+    M_BuildTagIndex(&SectorTags, numsectors, SectorTag);
+}
+
 //=========================================================================
 //
 // P_FindSectorFromTag
@@ -339,16 +358,7 @@ int     P_FindSectorFromLineTag(line_t  *line,int start)
 
 int P_FindSectorFromTag(int tag, int start)
 {
-    int i;
-
-    for (i = start + 1; i < numsectors; i++)
-    {
-        if (sectors[i].tag == tag)
-        {
-            return i;
-        }
-    }
-    return -1;
+    return M_NextTagged(&SectorTags, tag, start);
 }
 
 //==================================================================
@@ -1109,6 +1119,14 @@ void P_UpdateSpecials(void)
 short numlinespecials;
 line_t *linespeciallist[MAXLINEANIMS];
 
+// Tag of a Line_SetIdentification line, for P_FindLine.
+// Line specials are cleared when spawned, so only index them once.
+
+static int LineIdentification(int i)
+{
+    return lines[i].special == 121 && lines[i].arg1 ? lines[i].arg1 : NOTAG;
+}
+
 void P_SpawnSpecials(void)
 {
     sector_t *sector;
@@ -1175,6 +1193,7 @@ void P_SpawnSpecials(void)
     //
     numlinespecials = 0;
     TaggedLineCount = 0;
+    M_BuildTagIndex(&LineTags, numlines, LineIdentification);
     for (i = 0; i < numlines; i++)
     {
         switch (lines[i].special)
@@ -1196,8 +1215,7 @@ void P_SpawnSpecials(void)
                                         "P_SpawnSpecials: превышен лимит MAX_TAGGED_LINES (%d).",
                                         MAX_TAGGED_LINES);
                     }
-                    TaggedLines[TaggedLineCount].line = &lines[i];
-                    TaggedLines[TaggedLineCount++].lineTag = lines[i].arg1;
+                    TaggedLineCount++;
                 }
                 lines[i].special = 0;
                 break;
@@ -1226,16 +1244,7 @@ void P_SpawnSpecials(void)
 
 line_t *P_FindLine(int lineTag, int *searchPosition)
 {
-    int i;
+    *searchPosition = M_NextTagged(&LineTags, lineTag, *searchPosition);
 
-    for (i = *searchPosition + 1; i < TaggedLineCount; i++)
-    {
-        if (TaggedLines[i].lineTag == lineTag)
-        {
-            *searchPosition = i;
-            return TaggedLines[i].line;
-        }
-    }
-    *searchPosition = -1;
-    return NULL;
+    return *searchPosition >= 0 ? &lines[*searchPosition] : NULL;
 }
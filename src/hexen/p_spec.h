@@ -66,6 +66,7 @@ fixed_t P_FindLowestCeilingSurrounding(sector_t * sec);
 fixed_t P_FindHighestCeilingSurrounding(sector_t * sec);
 //int P_FindSectorFromLineTag(line_t  *line,int start);
 int P_FindSectorFromTag(int tag, int start);
+void P_InitTagIndex(void);
 //int P_FindMinSurroundingLight(sector_t *sector,int max);
 sector_t *getNextSector(line_t * line, sector_t * sec);
 line_t *P_FindLine(int lineTag, int *searchPosition);
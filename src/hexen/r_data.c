@@ -936,11 +936,6 @@ static void R_InitColormaps (void)
 ================================================================================
 */
 
-enum {
-    r, g, b
-} rgb_t;
-
-
 static void R_InitTransMaps (void)
 {
     // [JN] Check if we have a modified PLAYPAL palette:
@@ -960,100 +955,7 @@ static void R_InitTransMaps (void)
     else
     {
         // [JN] We do. Generate tables dynamically.
-
-        // Compose a default transparent filter map based on PLAYPAL.
-        unsigned char *playpal = W_CacheLumpName("PLAYPAL", PU_STATIC);
-
-        // [JN] Fading effect for messages:
-        transtable90 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable80 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable70 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable60 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable50 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable40 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable30 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable20 = Z_Malloc(256*256, PU_STATIC, 0);
-        transtable10 = Z_Malloc(256*256, PU_STATIC, 0);
-
-        {
-            byte *fg, *bg, blend[3];
-            byte *tp90 = transtable90;
-            byte *tp80 = transtable80;
-            byte *tp70 = transtable70;
-            byte *tp60 = transtable60;
-            byte *tp50 = transtable50;
-            byte *tp40 = transtable40;
-            byte *tp30 = transtable30;
-            byte *tp20 = transtable20;
-            byte *tp10 = transtable10;
-            int i, j;
-
-            // [crispy] background color
-            for (i = 0; i < 256; i++)
-            {
-                // [crispy] foreground color
-                for (j = 0; j < 256; j++)
-                {
-                    // [crispy] shortcut: identical foreground and background
-                    if (i == j)
-                    {
-                        *tp90++ = i; *tp80++ = i; *tp70++ = i;
-                        *tp60++ = i; *tp50++ = i; *tp40++ = i;
-                        *tp30++ = i; *tp20++ = i; *tp10++ = i;
-                        continue;
-                    }
-
-                    bg = playpal + 3*i;
-                    fg = playpal + 3*j;
-
-                    blend[r] = (90 * fg[r] + (100 - 90) * bg[r]) / 100;
-                    blend[g] = (90 * fg[g] + (100 - 90) * bg[g]) / 100;
-                    blend[b] = (90 * fg[b] + (100 - 90) * bg[b]) / 100;
-                    *tp90++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (80 * fg[r] + (100 - 80) * bg[r]) / 100;
-                    blend[g] = (80 * fg[g] + (100 - 80) * bg[g]) / 100;
-                    blend[b] = (80 * fg[b] + (100 - 80) * bg[b]) / 100;
-                    *tp80++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (70 * fg[r] + (100 - 70) * bg[r]) / 100;
-                    blend[g] = (70 * fg[g] + (100 - 70) * bg[g]) / 100;
-                    blend[b] = (70 * fg[b] + (100 - 70) * bg[b]) / 100;
-                    *tp70++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (60 * fg[r] + (100 - 60) * bg[r]) / 100;
-                    blend[g] = (60 * fg[g] + (100 - 60) * bg[g]) / 100;
-                    blend[b] = (60 * fg[b] + (100 - 60) * bg[b]) / 100;
-                    *tp60++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (50 * fg[r] + (100 - 50) * bg[r]) / 100;
-                    blend[g] = (50 * fg[g] + (100 - 50) * bg[g]) / 100;
-                    blend[b] = (50 * fg[b] + (100 - 50) * bg[b]) / 100;
-                    *tp50++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (40 * fg[r] + (100 - 40) * bg[r]) / 100;
-                    blend[g] = (40 * fg[g] + (100 - 40) * bg[g]) / 100;
-                    blend[b] = (40 * fg[b] + (100 - 40) * bg[b]) / 100;
-                    *tp40++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (30 * fg[r] + (100 - 30) * bg[r]) / 100;
-                    blend[g] = (30 * fg[g] + (100 - 30) * bg[g]) / 100;
-                    blend[b] = (30 * fg[b] + (100 - 30) * bg[b]) / 100;
-                    *tp30++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (20 * fg[r] + (100 - 20) * bg[r]) / 100;
-                    blend[g] = (20 * fg[g] + (100 - 20) * bg[g]) / 100;
-                    blend[b] = (20 * fg[b] + (100 - 20) * bg[b]) / 100;
-                    *tp20++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-
-                    blend[r] = (10 * fg[r] + (100 - 10) * bg[r]) / 100;
-                    blend[g] = (10 * fg[g] + (100 - 10) * bg[g]) / 100;
-                    blend[b] = (10 * fg[b] + (100 - 10) * bg[b]) / 100;
-                    *tp10++ = V_GetPaletteIndex(playpal, blend[r], blend[g], blend[b]);
-                }
-            }
-        }
-
+        V_InitTransTables(W_CacheLumpName("PLAYPAL", PU_STATIC));
         W_ReleaseLumpName("PLAYPAL");
     }
 }
@@ -104,6 +104,60 @@ void S_Start(void)
     S_StartSong(gamemap, true);
 }
 
+//==========================================================================
+//
+// S_PrecacheLevelSounds
+//
+// Lets the sound module prepare the sounds made by the things in the
+// level and their pitch-shifted variants, so they are ready when first
+// heard.  Only sounds that can be pitch shifted are listed; the rest are
+// already cached by S_Init.
+//
+//==========================================================================
+
+void S_PrecacheLevelSounds(void)
+{
+    boolean mobjtypes[NUMMOBJTYPES];
+    int sfx[5];
+    int i, j;
+    thinker_t *th;
+
+    memset(mobjtypes, 0, sizeof(mobjtypes));
+
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+        if (th->function == P_MobjThinker)
+        {
+            mobjtypes[((mobj_t *) th)->type] = true;
+        }
+    }
+
+    for (i = 0; i < NUMMOBJTYPES; i++)
+    {
+        if (!mobjtypes[i])
+        {
+            continue;
+        }
+
+        sfx[0] = mobjinfo[i].seesound;
+        sfx[1] = mobjinfo[i].attacksound;
+        sfx[2] = mobjinfo[i].painsound;
+        sfx[3] = mobjinfo[i].deathsound;
+        sfx[4] = mobjinfo[i].activesound;
+
+        for (j = 0; j < 5; j++)
+        {
+            if (sfx[j] > SFX_NONE && sfx[j] < NUMSFX && S_sfx[sfx[j]].pitch)
+            {
+                I_AddLevelSound(&S_sfx[sfx[j]]);
+            }
+        }
+    }
+
+    // Sounds are shifted by up to 7 either way (see S_StartSoundAtVolume).
+    I_PrecacheLevelSounds(7);
+}
+
 //==========================================================================
 //
 // Returns true if we are playing a looping CD track and it is time to
@@ -81,6 +81,7 @@ extern int snd_Channels_Vanilla;
 extern boolean cdmusic;
 
 void S_Start(void);
+void S_PrecacheLevelSounds(void);
 void S_StartSound(mobj_t * origin, int sound_id);
 int S_GetSoundID(char *name);
 void S_StartSoundAtVolume(mobj_t * origin, int sound_id, int volume);
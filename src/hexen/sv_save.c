@@ -20,6 +20,7 @@
 
 // HEADER FILES ------------------------------------------------------------
 
+#include "SDL.h"
 #include "h2def.h"
 #include "i_system.h"
 #include "m_misc.h"
@@ -27,6 +28,8 @@
 #include "p_local.h"
 #include "am_map.h"
 
+#include "miniz.h"
+
 // MACROS ------------------------------------------------------------------
 
 #define MAX_TARGET_PLAYERS 512
@@ -37,6 +40,7 @@
 #define REBORN_SLOT 8
 #define REBORN_DESCRIPTION "TEMP GAME"
 #define MAX_THINKER_SIZE 256
+#define PACKED_SLOT_MAGIC "HXPK"
 
 // TYPES -------------------------------------------------------------------
 
@@ -88,6 +92,22 @@ typedef struct
     sector_t *sector;
 } ssthinker_t;
 
+// One archive of a save slot: the game file or a map
+
+typedef struct
+{
+    byte *data;                 // NULL if there is no such archive
+    unsigned int length;        // Length of data
+    unsigned int size;          // Length once unpacked
+    boolean compressed;         // Deflated with miniz
+} savefile_t;
+
+typedef struct
+{
+    savefile_t game;
+    savefile_t maps[MAX_MAPS + 1];
+} saveslot_t;
+
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
 
 void P_SpawnPlayer(mapthing_t * mthing);
@@ -124,11 +144,14 @@ static void RestorePlatRaise(thinker_t *thinker);
 static void RestoreMoveCeiling(thinker_t *thinker);
 static void AssertSegment(gameArchiveSegment_t segType);
 static void CopySaveSlot(int sourceSlot, int destSlot);
-static void CopyFile(char *sourceName, char *destName);
+static void ReadSlotFile(int slot, saveslot_t *dest);
+static void WriteSlotFile(int slot, saveslot_t *source);
 static boolean ExistingFile(char *name);
-static void SV_OpenRead(char *fileName);
-static void SV_OpenWrite(char *fileName);
-static void SV_Close(void);
+static saveslot_t *MemorySlot(int slot);
+static boolean SV_OpenRead(savefile_t *file);
+static void SV_OpenWrite(void);
+static void SV_CloseWrite(savefile_t *file, boolean compress);
+static void SaveBufferGrow(unsigned int size);
 static void SV_Read(void *buffer, int size);
 static byte SV_ReadByte(void);
 static uint16_t SV_ReadWord(void);
@@ -157,7 +180,22 @@ static mobj_t **MobjList;
 static mobj_t ***TargetPlayerAddrs;
 static int TargetPlayerCount;
 static boolean SavingPlayers;
-static FILE *SavingFP;
+
+// The archive being read or written
+static byte *SaveBuffer;
+static unsigned int SaveBufferSize;
+static unsigned int SaveLength;
+static unsigned int SavePos;
+
+// The base and reborn slots, which are never written to disk
+static saveslot_t MemorySlots[2];
+
+// The slot being written to disk by WriteSlotThread
+static saveslot_t WritingSlot;
+static char WritingFileName[RD_MAX_PATH];
+static SDL_Thread *WritingThread;
+static SDL_atomic_t WritingFailed;
+static boolean WritingExitHook;
 
 // CODE --------------------------------------------------------------------
 
@@ -1981,13 +2019,11 @@ static void StreamOut_floorWaggle_t(thinker_t *thinker)
 
 void SV_SaveGame(int slot, char *description)
 {
-    char fileName[RD_MAX_PATH];
     char versionText[HXS_VERSION_TEXT_LENGTH];
     unsigned int i;
 
     // Open the output file
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-7.sav", SavePath);
-    SV_OpenWrite(fileName);
+    SV_OpenWrite();
 
     // Write game save description
     SV_Write(description, HXS_DESCRIPTION_LENGTH);
@@ -2021,7 +2057,7 @@ void SV_SaveGame(int slot, char *description)
     SV_WriteLong(ASEG_END);
 
     // Close the output file
-    SV_Close();
+    SV_CloseWrite(&MemorySlot(BASE_SLOT)->game, false);
 
     // Save out the current map
     SV_SaveMap(true);           // true = save player info
@@ -2041,13 +2077,10 @@ void SV_SaveGame(int slot, char *description)
 
 void SV_SaveMap(boolean savePlayers)
 {
-    char fileName[RD_MAX_PATH];
-
     SavingPlayers = savePlayers;
 
     // Open the output file
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-7%02d.sav", SavePath, gamemap);
-    SV_OpenWrite(fileName);
+    SV_OpenWrite();
 
     // Place a header marker
     SV_WriteLong(ASEG_MAP_HEADER);
@@ -2071,7 +2104,7 @@ void SV_SaveMap(boolean savePlayers)
     SV_WriteLong(ASEG_END);
 
     // Close the output file
-    SV_Close();
+    SV_CloseWrite(&MemorySlot(BASE_SLOT)->maps[gamemap], true);
 }
 
 //==========================================================================
@@ -2083,7 +2116,6 @@ void SV_SaveMap(boolean savePlayers)
 void SV_LoadGame(int slot)
 {
     int i;
-    char fileName[RD_MAX_PATH];
     char version_text[HXS_VERSION_TEXT_LENGTH];
     player_t playerBackup[MAXPLAYERS];
     mobj_t *mobj;
@@ -2095,14 +2127,14 @@ void SV_LoadGame(int slot)
         CopySaveSlot(slot, BASE_SLOT);
     }
 
-    // Create the name
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-7.sav", SavePath);
-
     // Load the file
-    SV_OpenRead(fileName);
+    if (!SV_OpenRead(&MemorySlot(BASE_SLOT)->game))
+    {
+        return;
+    }
 
     // Set the save pointer and skip the description field
-    fseek(SavingFP, HXS_DESCRIPTION_LENGTH, SEEK_CUR);
+    SavePos += HXS_DESCRIPTION_LENGTH;
 
     // Check the version text
 
@@ -2144,8 +2176,6 @@ void SV_LoadGame(int slot)
         playerBackup[i] = players[i];
     }
 
-    SV_Close();
-
     // Load the current map
     SV_LoadMap();
 
@@ -2211,7 +2241,6 @@ void SV_MapTeleport(int map, int position)
 {
     int i;
     int j;
-    char fileName[RD_MAX_PATH];
     player_t playerBackup[MAXPLAYERS];
     mobj_t *targetPlayerMobj;
     mobj_t *mobj;
@@ -2253,8 +2282,7 @@ void SV_MapTeleport(int map, int position)
     TargetPlayerAddrs = NULL;
 
     gamemap = map;
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-7%02d.sav", SavePath, gamemap);
-    if (!deathmatch && ExistingFile(fileName))
+    if (!deathmatch && MemorySlot(BASE_SLOT)->maps[gamemap].data != NULL)
     {                           // Unarchive map
         SV_LoadMap();
     }
@@ -2401,10 +2429,7 @@ int SV_GetRebornSlot(void)
 
 boolean SV_RebornSlotAvailable(void)
 {
-    char fileName[RD_MAX_PATH];
-
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-%d.sav", SavePath, REBORN_SLOT);
-    return ExistingFile(fileName);
+    return MemorySlot(REBORN_SLOT)->game.data != NULL;
 }
 
 //==========================================================================
@@ -2415,19 +2440,14 @@ boolean SV_RebornSlotAvailable(void)
 
 void SV_LoadMap(void)
 {
-    char fileName[RD_MAX_PATH];
-
     // Load a base level
     G_InitNew(gameskill, gameepisode, gamemap);
 
     // Remove all thinkers
     RemoveAllThinkers();
 
-    // Create the name
-    M_snprintf(fileName, sizeof(fileName), "%shexen-save-7%02d.sav", SavePath, gamemap);
-
     // Load the file
-    SV_OpenRead(fileName);
+    SV_OpenRead(&MemorySlot(BASE_SLOT)->maps[gamemap]);
 
     AssertSegment(ASEG_MAP_HEADER);
 
@@ -2447,9 +2467,8 @@ void SV_LoadMap(void)
 
     AssertSegment(ASEG_END);
 
-    // Free mobj list and save buffer
+    // Free mobj list
     Z_Free(MobjList);
-    SV_Close();
 }
 
 //==========================================================================
@@ -2618,6 +2637,9 @@ static void UnarchiveWorld(void)
             si->midtexture = SV_ReadWord();
         }
     }
+
+    // Sector tags may have been changed
+    P_InitTagIndex();
 }
 
 //==========================================================================
@@ -3325,6 +3347,97 @@ static void AssertSegment(gameArchiveSegment_t segType)
     }
 }
 
+//==========================================================================
+//
+// MemorySlot
+//
+// Returns the in-memory store of a slot, or NULL if the slot is kept on
+// disk.
+//
+//==========================================================================
+
+static saveslot_t *MemorySlot(int slot)
+{
+    if (slot == BASE_SLOT)
+    {
+        return &MemorySlots[0];
+    }
+    if (slot == REBORN_SLOT)
+    {
+        return &MemorySlots[1];
+    }
+    return NULL;
+}
+
+//==========================================================================
+//
+// FreeSaveSlot
+//
+//==========================================================================
+
+static void FreeSaveFile(savefile_t *file)
+{
+    free(file->data);
+    memset(file, 0, sizeof(savefile_t));
+}
+
+static void FreeSaveSlot(saveslot_t *slot)
+{
+    int i;
+
+    for (i = 0; i < MAX_MAPS + 1; i++)
+    {
+        FreeSaveFile(&slot->maps[i]);
+    }
+    FreeSaveFile(&slot->game);
+}
+
+//==========================================================================
+//
+// SetSaveFile
+//
+// Replaces the contents of a save file with a copy of the given data.
+//
+//==========================================================================
+
+static void SetSaveFile(savefile_t *file, const byte *data,
+                        unsigned int length, unsigned int size,
+                        boolean compressed)
+{
+    FreeSaveFile(file);
+    file->data = I_Realloc(NULL, length > 0 ? length : 1);
+    memcpy(file->data, data, length);
+    file->length = length;
+    file->size = size;
+    file->compressed = compressed;
+}
+
+//==========================================================================
+//
+// CopyMemorySlot
+//
+//==========================================================================
+
+static void CopyMemorySlot(saveslot_t *source, saveslot_t *dest)
+{
+    int i;
+
+    for (i = 0; i < MAX_MAPS + 1; i++)
+    {
+        if (source->maps[i].data != NULL)
+        {
+            SetSaveFile(&dest->maps[i], source->maps[i].data,
+                        source->maps[i].length, source->maps[i].size,
+                        source->maps[i].compressed);
+        }
+    }
+    if (source->game.data != NULL)
+    {
+        SetSaveFile(&dest->game, source->game.data, source->game.length,
+                    source->game.size, source->game.compressed);
+    }
+}
+
 //==========================================================================
 //
 // SV_ClearSaveSlot
@@ -3337,7 +3450,18 @@ void SV_ClearSaveSlot(int slot)
 {
     int i;
     char fileName[RD_MAX_PATH];
+    saveslot_t *memslot;
+
+    memslot = MemorySlot(slot);
+    if (memslot != NULL)
+    {
+        FreeSaveSlot(memslot);
+        return;
+    }
 
+    SV_FinishSaving();
+
+    // Saves from older versions keep every map in a file of its own
     for (i = 0; i < MAX_MAPS + 1; i++)
     {
         M_snprintf(fileName, sizeof(fileName),
@@ -3358,123 +3482,268 @@ void SV_ClearSaveSlot(int slot)
 //
 // CopySaveSlot
 //
-// Copies all the save game files from one slot to another.
+// Copies all the save game files from one slot to another.  The base
+// and reborn slots are kept in memory; the others are read from and
+// written to one packed file each.
 //
 //==========================================================================
 
 static void CopySaveSlot(int sourceSlot, int destSlot)
 {
-    int i;
-    char sourceName[RD_MAX_PATH];
-    char destName[RD_MAX_PATH];
+    saveslot_t *source;
+    saveslot_t *dest;
+    saveslot_t diskslot;
 
-    for (i = 0; i < MAX_MAPS; i++)
+    memset(&diskslot, 0, sizeof(diskslot));
+
+    source = MemorySlot(sourceSlot);
+    if (source == NULL)
     {
-        M_snprintf(sourceName, sizeof(sourceName),
-                   "%shexen-save-%d%02d.sav", SavePath, sourceSlot, i);
-        if (ExistingFile(sourceName))
-        {
-            M_snprintf(destName, sizeof(destName),
-                       "%shexen-save-%d%02d.sav", SavePath, destSlot, i);
-            CopyFile(sourceName, destName);
-        }
+        ReadSlotFile(sourceSlot, &diskslot);
+        source = &diskslot;
+    }
+
+    dest = MemorySlot(destSlot);
+    if (dest != NULL)
+    {
+        CopyMemorySlot(source, dest);
     }
-    M_snprintf(sourceName, sizeof(sourceName),
-               "%shexen-save-%d.sav", SavePath, sourceSlot);
-    if (ExistingFile(sourceName))
+    else
     {
-        M_snprintf(destName, sizeof(destName),
-                   "%shexen-save-%d.sav", SavePath, destSlot);
-        CopyFile(sourceName, destName);
+        WriteSlotFile(destSlot, source);
     }
+
+    FreeSaveSlot(&diskslot);
 }
 
 //==========================================================================
 //
-// CopyFile
+// ReadSlotFile
+//
+// Loads a save slot from disk.  A packed slot file is the game file
+// followed by the deflated map archives and a trailer pointing to them;
+// older saves have a separate file for each map instead.
 //
-// This function was rewritten to copy files with minimal strain on zone
-// allocation and allow for big maps that technically work in vanilla to
-// save without error.
 //==========================================================================
 
-static void CopyFile(char *source_name, char *dest_name)
+static unsigned int ReadPackedLong(const byte *p)
 {
-    const int BUFFER_CHUNK_SIZE = 0x10000;
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
 
+static void ReadSlotFile(int slot, saveslot_t *dest)
+{
+    int i;
+    char fileName[RD_MAX_PATH];
     byte *buffer;
-    int /*file_length,*/ file_remaining;
-    FILE *read_handle, *write_handle;
-    int buf_count, read_count, write_count;
+    byte *mapData;
+    unsigned int length;
+    unsigned int offset;
+    unsigned int pos;
+    unsigned int count;
+    unsigned int map, size, mapLength;
+
+    SV_FinishSaving();
 
-    read_handle = M_fopen(source_name, "rb");
-    if (read_handle == NULL)
+    M_snprintf(fileName, sizeof(fileName), "%shexen-save-%d.sav", SavePath, slot);
+    if (!ExistingFile(fileName))
     {
-        I_QuitWithError(english_language ?
-                        "Could not load savegame %s" :
-                        "Невозможно прочитать файл %s",
-                        source_name);
+        return;
     }
-    /*file_length = */file_remaining = M_FileLength(read_handle);
 
-    // Vanilla savegame emulation.
-    //
-    // CopyFile() typically calls M_ReadFile() which stores the entire file
-    // in memory: Chocolate Hexen should force an allocation error here
-    // whenever it's appropriate.
+    length = M_ReadFile(fileName, &buffer);
+    offset = length;
+
+    if (length >= 8 && memcmp(buffer + length - 4, PACKED_SLOT_MAGIC, 4) == 0)
+    {
+        offset = ReadPackedLong(buffer + length - 8);
+        if (offset + 4 > length - 8)
+        {
+            I_QuitWithError(english_language ?
+                            "Corrupt save game: %s" :
+                            "Поврежденный файл сохранения: %s",
+                            fileName);
+        }
+
+        count = ReadPackedLong(buffer + offset);
+        length -= 8;
+
+        for (pos = offset + 4; count > 0; count--)
+        {
+            if (pos + 12 > length)
+            {
+                break;
+            }
+            map = ReadPackedLong(buffer + pos);
+            size = ReadPackedLong(buffer + pos + 4);
+            mapLength = ReadPackedLong(buffer + pos + 8);
+            pos += 12;
+            if (map > MAX_MAPS || mapLength > length - pos)
+            {
+                break;
+            }
+            SetSaveFile(&dest->maps[map], buffer + pos, mapLength, size, true);
+            pos += mapLength;
+        }
 
-    // [JN] Лимит сохранения отключен
-    /*
-    if (vanilla_savegame_limit)
+        if (count > 0)
+        {
+            I_QuitWithError(english_language ?
+                            "Corrupt save game: %s" :
+                            "Поврежденный файл сохранения: %s",
+                            fileName);
+        }
+    }
+    else
     {
-        buffer = Z_Malloc(file_length, PU_STATIC, NULL);
-        Z_Free(buffer);
+        for (i = 0; i < MAX_MAPS; i++)
+        {
+            M_snprintf(fileName, sizeof(fileName),
+                       "%shexen-save-%d%02d.sav", SavePath, slot, i);
+            if (!ExistingFile(fileName))
+            {
+                continue;
+            }
+
+            size = M_ReadFile(fileName, &mapData);
+            SV_OpenWrite();
+            SV_Write(mapData, size);
+            SV_CloseWrite(&dest->maps[i], true);
+            Z_Free(mapData);
+        }
     }
-    */
 
-    write_handle = M_fopen(dest_name, "wb");
-    if (write_handle == NULL)
+    SetSaveFile(&dest->game, buffer, offset, offset, false);
+    Z_Free(buffer);
+}
+
+//==========================================================================
+//
+// WriteSlotFile
+//
+// Packs a save slot into one file.  The file is written by a thread of
+// its own; SV_FinishSaving waits for it.
+//
+//==========================================================================
+
+static void WritePackedLong(FILE *fp, unsigned int val)
+{
+    byte buffer[4];
+
+    buffer[0] = val & 0xff;
+    buffer[1] = (val >> 8) & 0xff;
+    buffer[2] = (val >> 16) & 0xff;
+    buffer[3] = (val >> 24) & 0xff;
+    fwrite(buffer, 1, 4, fp);
+}
+
+static int WriteSlotThread(void *unused)
+{
+    FILE *fp;
+    saveslot_t *slot = &WritingSlot;
+    unsigned int count;
+    int i;
+
+    fp = M_fopen(WritingFileName, "wb");
+    if (fp == NULL)
     {
-        I_QuitWithError(english_language ?
-                        "Couldn't read file %s" :
-                        "Невозможно прочитать файл %s",
-                        dest_name);
+        SDL_AtomicSet(&WritingFailed, 1);
+        return 0;
     }
 
-    buffer = Z_Malloc (BUFFER_CHUNK_SIZE, PU_STATIC, NULL);
+    fwrite(slot->game.data, 1, slot->game.length, fp);
 
-    do
+    count = 0;
+    for (i = 0; i < MAX_MAPS + 1; i++)
     {
-        buf_count = BUFFER_CHUNK_SIZE;
-        if( file_remaining < BUFFER_CHUNK_SIZE)
+        if (slot->maps[i].data != NULL)
         {
-            buf_count = file_remaining;
+            count++;
         }
+    }
 
-        read_count = fread(buffer, 1, buf_count, read_handle);
-        if (read_count < buf_count)
+    WritePackedLong(fp, count);
+    for (i = 0; i < MAX_MAPS + 1; i++)
+    {
+        if (slot->maps[i].data == NULL)
         {
-            I_QuitWithError(english_language ?
-                            "Couldn't read file %s" :
-                            "Невозможно прочитать файл %s",
-                            source_name);
+            continue;
         }
+        WritePackedLong(fp, i);
+        WritePackedLong(fp, slot->maps[i].size);
+        WritePackedLong(fp, slot->maps[i].length);
+        fwrite(slot->maps[i].data, 1, slot->maps[i].length, fp);
+    }
 
-        write_count = fwrite(buffer, 1, buf_count, write_handle);
-        if (write_count < buf_count)
-        {
-            I_QuitWithError(english_language ?
-                            "Couldn't write to file %s" :
-                            "Невозможно записать файл %s",
-                            dest_name);
-        }
+    WritePackedLong(fp, slot->game.length);
+    fwrite(PACKED_SLOT_MAGIC, 1, 4, fp);
 
-        file_remaining -= buf_count;
-    } while (file_remaining > 0);
+    if (ferror(fp))
+    {
+        SDL_AtomicSet(&WritingFailed, 1);
+    }
+    fclose(fp);
 
-    Z_Free(buffer);
-    fclose(read_handle);
-    fclose(write_handle);
+    return 0;
+}
+
+static void WriteSlotFile(int slot, saveslot_t *source)
+{
+    SV_FinishSaving();
+
+    if (source->game.data == NULL)
+    {
+        return;
+    }
+
+    // The thread works on a copy, so the game can go on changing the
+    // memory slots while the file is written.
+    CopyMemorySlot(source, &WritingSlot);
+    M_snprintf(WritingFileName, sizeof(WritingFileName),
+               "%shexen-save-%d.sav", SavePath, slot);
+    SDL_AtomicSet(&WritingFailed, 0);
+
+    if (!WritingExitHook)
+    {
+        I_AtExit(SV_FinishSaving, true);
+        WritingExitHook = true;
+    }
+
+    WritingThread = SDL_CreateThread(WriteSlotThread, "Save game", NULL);
+    if (WritingThread == NULL)
+    {
+        WriteSlotThread(NULL);
+        SV_FinishSaving();
+    }
+}
+
+//==========================================================================
+//
+// SV_FinishSaving
+//
+// Waits until the last save game has been written to disk.
+//
+//==========================================================================
+
+void SV_FinishSaving(void)
+{
+    if (WritingThread != NULL)
+    {
+        SDL_WaitThread(WritingThread, NULL);
+        WritingThread = NULL;
+    }
+
+    if (WritingSlot.game.data != NULL)
+    {
+        if (SDL_AtomicGet(&WritingFailed))
+        {
+            printf(english_language ?
+                   "Couldn't write to file %s\n" :
+                   "Невозможно записать файл %s\n",
+                   WritingFileName);
+        }
+        FreeSaveSlot(&WritingSlot);
+    }
 }
 
 //==========================================================================
@@ -3502,16 +3771,49 @@ static boolean ExistingFile(char *name)
 //
 // SV_Open
 //
+// Archives are built in and read from a memory buffer; SV_CloseWrite
+// deflates the result into a save file.
+//
 //==========================================================================
 
-static void SV_OpenRead(char *fileName)
+static boolean SV_OpenRead(savefile_t *file)
 {
-    SavingFP = M_fopen(fileName, "rb");
+    uLongf size;
+
+    SaveLength = 0;
+    SavePos = 0;
+
+    if (file->data == NULL)
+    {
+        return false;
+    }
+
+    SaveBufferGrow(file->size);
+    if (file->compressed)
+    {
+        size = file->size;
+        if (uncompress(SaveBuffer, &size, file->data, file->length) != Z_OK
+         || size != file->size)
+        {
+            I_QuitWithError(english_language ?
+                            "Corrupt save game: archive could not be unpacked" :
+                            "Поврежденный файл сохранения: архив не может быть распакован");
+        }
+    }
+    else
+    {
+        memcpy(SaveBuffer, file->data, file->size);
+    }
+
+    SaveLength = file->size;
+    SavePos = 0;
+    return true;
 }
 
-static void SV_OpenWrite(char *fileName)
+static void SV_OpenWrite(void)
 {
-    SavingFP = M_fopen(fileName, "wb");
+    SaveLength = 0;
+    SavePos = 0;
 }
 
 //==========================================================================
@@ -3520,11 +3822,49 @@ static void SV_OpenWrite(char *fileName)
 //
 //==========================================================================
 
-static void SV_Close(void)
+static void SV_CloseWrite(savefile_t *file, boolean compress)
+{
+    uLongf length;
+    byte *packed;
+
+    if (!compress)
+    {
+        SetSaveFile(file, SaveBuffer, SavePos, SavePos, false);
+        return;
+    }
+
+    // Hub transitions should be quick, so favour speed over size.
+    length = compressBound(SavePos);
+    packed = I_Realloc(NULL, length);
+    if (compress2(packed, &length, SaveBuffer, SavePos, Z_BEST_SPEED) != Z_OK)
+    {
+        I_QuitWithError(english_language ?
+                        "SV_CloseWrite: could not pack archive" :
+                        "SV_CloseWrite: невозможно упаковать архив");
+    }
+
+    FreeSaveFile(file);
+    file->data = packed;
+    file->length = length;
+    file->size = SavePos;
+    file->compressed = true;
+}
+
+//==========================================================================
+//
+// SaveBufferGrow
+//
+//==========================================================================
+
+static void SaveBufferGrow(unsigned int size)
 {
-    if (SavingFP)
+    if (size > SaveBufferSize)
     {
-        fclose(SavingFP);
+        while (size > SaveBufferSize)
+        {
+            SaveBufferSize = SaveBufferSize > 0 ? SaveBufferSize * 2 : 0x10000;
+        }
+        SaveBuffer = I_Realloc(SaveBuffer, SaveBufferSize);
     }
 }
 
@@ -3536,14 +3876,15 @@ static void SV_Close(void)
 
 static void SV_Read(void *buffer, int size)
 {
-    int retval = fread(buffer, 1, size, SavingFP);
-    if (retval != size)
+    if (size > SaveLength - SavePos)
     {
         I_QuitWithError(english_language ?
                         "Incomplete read in SV_Read: Expected %d, got %d bytes" :
                         "Ошибка чтения в SV_Read: ожидаемо '%d', получено '%d' байт",
-                        size, retval);
+                        size, SaveLength - SavePos);
     }
+    memcpy(buffer, SaveBuffer + SavePos, size);
+    SavePos += size;
 }
 
 static byte SV_ReadByte(void)
@@ -3587,24 +3928,26 @@ static void *SV_ReadPtr(void)
 
 static void SV_Write(void *buffer, int size)
 {
-    fwrite(buffer, size, 1, SavingFP);
+    SaveBufferGrow(SavePos + size);
+    memcpy(SaveBuffer + SavePos, buffer, size);
+    SavePos += size;
 }
 
 static void SV_WriteByte(byte val)
 {
-    fwrite(&val, sizeof(byte), 1, SavingFP);
+    SV_Write(&val, sizeof(byte));
 }
 
 static void SV_WriteWord(unsigned short val)
 {
     val = SHORT(val);
-    fwrite(&val, sizeof(unsigned short), 1, SavingFP);
+    SV_Write(&val, sizeof(unsigned short));
 }
 
 static void SV_WriteLong(unsigned int val)
 {
     val = LONG(val);
-    fwrite(&val, sizeof(int), 1, SavingFP);
+    SV_Write(&val, sizeof(int));
 }
 
 static void SV_WriteLongLong(int64_t val)
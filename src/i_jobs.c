@@ -0,0 +1,226 @@
+//
+// Copyright(C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Pool of worker threads for running a job over many items.
+//
+
+
+#include "SDL.h"
+
+#include "doomtype.h"
+#include "i_jobs.h"
+
+
+#define MAX_WORKERS 7
+
+static boolean jobs_initialized = false;
+static int num_workers = 0;
+
+// The running job.  Only changed while no worker is taking items from
+// it (active_workers is zero).
+
+static job_func_t job_func;
+static void *job_data;
+static int job_count;
+static int job_generation;
+
+static SDL_atomic_t job_next;       // Next item to take
+static SDL_atomic_t job_done;       // Items finished
+
+static SDL_mutex *job_mutex;
+static SDL_cond *job_start_cond;
+static SDL_cond *job_finish_cond;
+static int active_workers;
+static boolean job_running;
+
+// Take items of the job until there are none left.
+
+static void RunItems(job_func_t func, void *data, int count)
+{
+    int i;
+
+    for (;;)
+    {
+        i = SDL_AtomicAdd(&job_next, 1);
+
+        if (i >= count)
+        {
+            break;
+        }
+
+        func(data, i);
+        SDL_AtomicAdd(&job_done, 1);
+    }
+}
+
+static int WorkerThread(void *unused)
+{
+    int generation = 0;
+    job_func_t func;
+    void *data;
+    int count;
+
+    for (;;)
+    {
+        SDL_LockMutex(job_mutex);
+
+        while (job_generation == generation)
+        {
+            SDL_CondWait(job_start_cond, job_mutex);
+        }
+
+        generation = job_generation;
+        func = job_func;
+        data = job_data;
+        count = job_count;
+        ++active_workers;
+
+        SDL_UnlockMutex(job_mutex);
+
+        RunItems(func, data, count);
+
+        SDL_LockMutex(job_mutex);
+        --active_workers;
+        SDL_CondBroadcast(job_finish_cond);
+        SDL_UnlockMutex(job_mutex);
+    }
+
+    return 0;
+}
+
+static void InitJobs(void)
+{
+    SDL_Thread *thread;
+    int count;
+
+    jobs_initialized = true;
+
+    // Leave the main thread its own processor.
+
+    count = SDL_GetCPUCount() - 1;
+
+    if (count > MAX_WORKERS)
+    {
+        count = MAX_WORKERS;
+    }
+
+    if (count <= 0)
+    {
+        return;
+    }
+
+    job_mutex = SDL_CreateMutex();
+    job_start_cond = SDL_CreateCond();
+    job_finish_cond = SDL_CreateCond();
+
+    if (job_mutex == NULL || job_start_cond == NULL || job_finish_cond == NULL)
+    {
+        return;
+    }
+
+    while (num_workers < count)
+    {
+        thread = SDL_CreateThread(WorkerThread, "Worker", NULL);
+
+        if (thread == NULL)
+        {
+            break;
+        }
+
+        SDL_DetachThread(thread);
+        ++num_workers;
+    }
+}
+
+int I_JobThreads(void)
+{
+    if (!jobs_initialized)
+    {
+        InitJobs();
+    }
+
+    return num_workers + 1;
+}
+
+void I_StartJob(job_func_t func, void *data, int count)
+{
+    if (!jobs_initialized)
+    {
+        InitJobs();
+    }
+
+    I_FinishJob();
+
+    if (num_workers == 0)
+    {
+        job_func = func;
+        job_data = data;
+        job_count = count;
+        job_running = true;
+        SDL_AtomicSet(&job_next, 0);
+        SDL_AtomicSet(&job_done, 0);
+        return;
+    }
+
+    SDL_LockMutex(job_mutex);
+
+    // A worker that woke up late for the last job may still be looking
+    // at it; it must be gone before the item counters are reset.
+
+    while (active_workers > 0)
+    {
+        SDL_CondWait(job_finish_cond, job_mutex);
+    }
+
+    job_func = func;
+    job_data = data;
+    job_count = count;
+    job_running = true;
+    SDL_AtomicSet(&job_next, 0);
+    SDL_AtomicSet(&job_done, 0);
+
+    ++job_generation;
+    SDL_CondBroadcast(job_start_cond);
+    SDL_UnlockMutex(job_mutex);
+}
+
+void I_FinishJob(void)
+{
+    if (!job_running)
+    {
+        return;
+    }
+
+    RunItems(job_func, job_data, job_count);
+
+    if (num_workers > 0)
+    {
+        SDL_LockMutex(job_mutex);
+
+        while (SDL_AtomicGet(&job_done) < job_count || active_workers > 0)
+        {
+            SDL_CondWait(job_finish_cond, job_mutex);
+        }
+
+        SDL_UnlockMutex(job_mutex);
+    }
+
+    job_running = false;
+}
+
+void I_RunJob(job_func_t func, void *data, int count)
+{
+    I_StartJob(func, data, count);
+    I_FinishJob();
+}
@@ -0,0 +1,40 @@
+//
+// Copyright(C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Pool of worker threads for running a job over many items.
+//
+
+
+#pragma once
+
+// Called once for each item of a job.  Runs on the worker threads as
+// well as the main thread, so it must not use the zone memory
+// allocator, the WAD cache or other global state that is not safe to
+// share between threads.
+
+typedef void (*job_func_t)(void *data, int index);
+
+// Start calling func(data, i) for every i from 0 to count-1 on the
+// worker threads, and return at once.  Only one job runs at a time:
+// a job that is still running is finished first.
+void I_StartJob(job_func_t func, void *data, int count);
+
+// Help with the running job on this thread until it is done.
+void I_FinishJob(void);
+
+// Run a job and wait for it.
+void I_RunJob(job_func_t func, void *data, int count);
+
+// Number of threads working on a job, including the main thread.
+int I_JobThreads(void);
@@ -1702,7 +1702,10 @@ static boolean I_OPL_MusicIsPlaying(void)
         return false;
     }
 
-    return num_tracks > 0;
+    // A song that is not looping has finished once all of its
+    // tracks have ended.
+
+    return num_tracks > 0 && (song_looping || running_tracks > 0);
 }
 
 // Shutdown music
@@ -46,6 +46,18 @@
 // [JN] Extended from 16 to 64
 #define NUM_CHANNELS 64
 
+// Number of hash chains used to look up cached sounds.
+#define SOUND_HASH_SIZE 256
+
+// Pitch-shifted copies of sounds are kept after they have finished
+// playing, so that the same variant can be played again without being
+// recalculated.  Their total size is limited separately, on top of
+// the snd_cachesize limit that applies to all sounds.
+#define PITCH_CACHE_SIZE (16 * 1024 * 1024)
+
+// Maximum number of threads converting sounds in the background.
+#define MAX_PRECACHE_THREADS 4
+
 typedef struct allocated_sound_s allocated_sound_t;
 
 struct allocated_sound_s
@@ -55,9 +67,28 @@ struct allocated_sound_s
     int use_count;
     int pitch;
     allocated_sound_t *prev, *next;
+    allocated_sound_t *hash_next;
 };
 
+// A sound to be converted by a precache thread: either a sound lump to
+// be expanded to the mixer format, or a cached sound to be pitch-shifted.
+
+typedef struct
+{
+    sfxinfo_t *sfxinfo;
+    allocated_sound_t *base;    // Sound to pitch-shift, locked.
+    int pitch;
+    byte *data;                 // Copy of the samples to expand, if no base.
+    int samplerate;
+    int bits;
+    int length;
+    allocated_sound_t *result;
+    boolean collected;
+    SDL_atomic_t done;
+} precache_job_t;
+
 static boolean sound_initialized = false;
+static SDL_threadID sound_thread_id;
 
 static allocated_sound_t *channels_playing[NUM_CHANNELS];
 
@@ -65,11 +96,11 @@ static int mixer_freq;
 static Uint16 mixer_format;
 static int mixer_channels;
 static boolean use_sfx_prefix;
-static boolean (*ExpandSoundData)(sfxinfo_t *sfxinfo,
-                                  byte *data,
-                                  int samplerate,
-                                  int bits,
-                                  int length) = NULL;
+static allocated_sound_t *(*ExpandSoundData)(sfxinfo_t *sfxinfo,
+                                             byte *data,
+                                             int samplerate,
+                                             int bits,
+                                             int length) = NULL;
 
 // Doubly-linked list of allocated sounds.
 // When a sound is played, it is moved to the head, so that the oldest
@@ -78,6 +109,31 @@ static boolean (*ExpandSoundData)(sfxinfo_t *sfxinfo,
 static allocated_sound_t *allocated_sounds_head = NULL;
 static allocated_sound_t *allocated_sounds_tail = NULL;
 static int allocated_sounds_size = 0;
+static int pitch_sounds_size = 0;
+
+// Hash table of allocated sounds, by sfxinfo and pitch.
+
+static allocated_sound_t *sound_hashtable[SOUND_HASH_SIZE];
+
+// Sounds being converted in the background.  The worker threads only
+// claim jobs and fill in their results; the allocated sounds list is
+// only ever touched by the thread that plays sounds.
+
+static precache_job_t *precache_jobs = NULL;
+static int num_precache_jobs = 0;
+static int precache_jobs_alloced = 0;
+static int precache_jobs_collected = 0;
+static SDL_atomic_t precache_next_job;
+static SDL_atomic_t precache_cancel;
+static SDL_Thread *precache_threads[MAX_PRECACHE_THREADS];
+static int num_precache_threads = 0;
+
+// Statistics, shown at shutdown with -soundstats.
+
+static boolean show_sound_stats = false;
+static unsigned int sound_hits, sound_misses;
+static unsigned int pitch_hits, pitch_misses;
+static unsigned int sounds_precached;
 
 // [crispy] values 3 and higher might reproduce DOOM.EXE more accurately,
 // but 1 is closer to "use_libsamplerate = 0" which is the default in Choco
@@ -137,16 +193,42 @@ static void AllocatedSoundUnlink(allocated_sound_t *snd)
     }
 }
 
+static unsigned int SoundHash(sfxinfo_t *sfxinfo, int pitch)
+{
+    return ((unsigned int) ((size_t) sfxinfo / sizeof(sfxinfo_t)) * 31
+          + (unsigned int) pitch) % SOUND_HASH_SIZE;
+}
+
+static void AllocatedSoundHashRemove(allocated_sound_t *snd)
+{
+    allocated_sound_t **p;
+
+    p = &sound_hashtable[SoundHash(snd->sfxinfo, snd->pitch)];
+
+    while (*p != snd)
+    {
+        p = &(*p)->hash_next;
+    }
+
+    *p = snd->hash_next;
+}
+
 static void FreeAllocatedSound(allocated_sound_t *snd)
 {
-    // Unlink from linked list.
+    // Unlink from linked list and hash table.
 
     AllocatedSoundUnlink(snd);
+    AllocatedSoundHashRemove(snd);
 
     // Keep track of the amount of allocated sound data:
 
     allocated_sounds_size -= snd->chunk.alen;
 
+    if (snd->pitch != NORM_PITCH)
+    {
+        pitch_sounds_size -= snd->chunk.alen;
+    }
+
     free(snd);
 }
 
@@ -201,15 +283,35 @@ static void ReserveCacheSpace(size_t len)
     }
 }
 
-// Allocate a block for a new sound effect.
+// Enforce the limit on pitch-shifted sounds in the same way, freeing
+// the least recently used variants that are not playing.
 
-static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
+static void ReservePitchCacheSpace(size_t len)
 {
-    allocated_sound_t *snd;
+    allocated_sound_t *snd, *prev;
 
-    // Keep allocated sounds within the cache size.
+    snd = allocated_sounds_tail;
 
-    ReserveCacheSpace(len);
+    while (snd != NULL && pitch_sounds_size + len > PITCH_CACHE_SIZE)
+    {
+        prev = snd->prev;
+
+        if (snd->pitch != NORM_PITCH && snd->use_count == 0)
+        {
+            FreeAllocatedSound(snd);
+        }
+
+        snd = prev;
+    }
+}
+
+// Allocate a block for a new sound effect.  The sound is not added to
+// the cache, so this may be called by the precache threads; it must be
+// added with LinkAllocatedSound before it can be played.
+
+static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
+{
+    allocated_sound_t *snd;
 
     // Allocate the sound structure and data.  The data will immediately
     // follow the structure, which acts as a header.
@@ -219,9 +321,10 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
         snd = malloc(sizeof(allocated_sound_t) + len);
 
         // Out of memory?  Try to free an old sound, then loop round
-        // and try again.
+        // and try again.  Only the sound thread may free sounds.
 
-        if (snd == NULL && !FindAndFreeSound())
+        if (snd == NULL
+         && (SDL_ThreadID() != sound_thread_id || !FindAndFreeSound()))
         {
             return NULL;
         }
@@ -239,13 +342,34 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
     snd->sfxinfo = sfxinfo;
     snd->use_count = 0;
 
+    return snd;
+}
+
+// Add a newly allocated sound to the cache.
+
+static void LinkAllocatedSound(allocated_sound_t *snd)
+{
+    unsigned int hash;
+
+    // Keep allocated sounds within the cache size.
+
+    if (snd->pitch != NORM_PITCH)
+    {
+        ReservePitchCacheSpace(snd->chunk.alen);
+        pitch_sounds_size += snd->chunk.alen;
+    }
+
+    ReserveCacheSpace(snd->chunk.alen);
+
     // Keep track of how much memory all these cached sounds are using...
 
-    allocated_sounds_size += len;
+    allocated_sounds_size += snd->chunk.alen;
 
     AllocatedSoundLink(snd);
 
-    return snd;
+    hash = SoundHash(snd->sfxinfo, snd->pitch);
+    snd->hash_next = sound_hashtable[hash];
+    sound_hashtable[hash] = snd;
 }
 
 // Lock a sound, to indicate that it may not be freed.
@@ -281,12 +405,12 @@ static void UnlockAllocatedSound(allocated_sound_t *snd)
     //printf("-- %s: Use count=%i\n", snd->sfxinfo->name, snd->use_count);
 }
 
-// Search through the list of allocated sounds and return the one that matches
+// Search through the allocated sounds and return the one that matches
 // the supplied sfxinfo entry and pitch level.
 
 static allocated_sound_t * GetAllocatedSoundBySfxInfoAndPitch(sfxinfo_t *sfxinfo, int pitch)
 {
-    allocated_sound_t * p = allocated_sounds_head;
+    allocated_sound_t * p = sound_hashtable[SoundHash(sfxinfo, pitch)];
 
     while (p != NULL)
     {
@@ -294,24 +418,17 @@ static allocated_sound_t * GetAllocatedSoundBySfxInfoAndPitch(sfxinfo_t *sfxinfo
         {
             return p;
         }
-        p = p->next;
+        p = p->hash_next;
     }
 
     return NULL;
 }
 
-// Allocate a new sound chunk and pitch-shift an existing sound up-or-down
-// into it.
+// Length of a sound of srclen bytes once pitch-shifted.
 
-static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
+static Uint32 PitchShiftLength(Uint32 srclen, int pitch)
 {
-    allocated_sound_t * outsnd;
-    Sint16 *inp, *outp;
-    Sint16 *srcbuf, *dstbuf;
-    Uint32 srclen, dstlen;
-
-    srcbuf = (Sint16 *)insnd->chunk.abuf;
-    srclen = insnd->chunk.alen;
+    Uint32 dstlen;
 
     // determine ratio pitch:NORM_PITCH and apply to srclen, then invert.
     // This is an approximation of vanilla behaviour based on measurements
@@ -323,6 +440,23 @@ static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
         dstlen++;
     }
 
+    return dstlen;
+}
+
+// Allocate a new sound chunk and pitch-shift an existing sound up-or-down
+// into it.  The new sound is not added to the cache.
+
+static allocated_sound_t * PitchShift(allocated_sound_t *insnd, int pitch)
+{
+    allocated_sound_t * outsnd;
+    Sint16 *inp, *outp;
+    Sint16 *srcbuf, *dstbuf;
+    Uint32 srclen, dstlen;
+
+    srcbuf = (Sint16 *)insnd->chunk.abuf;
+    srclen = insnd->chunk.alen;
+    dstlen = PitchShiftLength(srclen, pitch);
+
     outsnd = AllocateSound(insnd->sfxinfo, dstlen);
 
     if (!outsnd)
@@ -360,14 +494,10 @@ static void ReleaseSoundOnChannel(int channel)
 
     channels_playing[channel] = NULL;
 
-    UnlockAllocatedSound(snd);
+    // Pitch-shifted sounds stay in the cache too, until they are pushed
+    // out by newer variants (see ReservePitchCacheSpace).
 
-    // if the sound is a pitch-shift and it's not in use, immediately
-    // free it
-    if (snd->pitch != NORM_PITCH && snd->use_count <= 0)
-    {
-        FreeAllocatedSound(snd);
-    }
+    UnlockAllocatedSound(snd);
 }
 
 #ifdef HAVE_LIBSAMPLERATE
@@ -403,17 +533,17 @@ static int SRC_ConversionMode(void)
 //   unsigned 8 bits --> signed 16 bits
 //   mono --> stereo
 //   samplerate --> mixer_freq
-// Returns number of clipped samples.
+// Returns the new sound, which is not yet added to the cache.
 // DWF 2008-02-10 with cleanups by Simon Howard.
-static int retn;
 
-static boolean ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
-                                   byte *data,
-                                   int samplerate,
-                                   int bits,
-                                   int length)
+static allocated_sound_t *ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
+                                              byte *data,
+                                              int samplerate,
+                                              int bits,
+                                              int length)
 {
     SRC_DATA src_data;
+    int retn;
     float *data_in;
     uint32_t i, abuf_index=0, clipped=0;
 //    uint32_t alen;
@@ -467,7 +597,9 @@ static boolean ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
 
     if (snd == NULL)
     {
-        return false;
+        free(data_in);
+        free(src_data.data_out);
+        return NULL;
     }
 
     chunk = &snd->chunk;
@@ -532,7 +664,7 @@ static boolean ExpandSoundData_SRC(sfxinfo_t *sfxinfo,
                         400.0 * clipped / chunk->alen);
     }
 
-    return true;
+    return snd;
 }
 
 #endif
@@ -617,13 +749,13 @@ static void WriteWAV(char *filename, byte *data,
 #endif
 
 // Generic sound expansion function for any sample rate.
-// Returns number of clipped samples (always 0).
+// Returns the new sound, which is not yet added to the cache.
 
-static boolean ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
-                                   byte *data,
-                                   int samplerate,
-                                   int bits,
-                                   int length)
+static allocated_sound_t *ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
+                                              byte *data,
+                                              int samplerate,
+                                              int bits,
+                                              int length)
 {
     SDL_AudioCVT convertor;
     allocated_sound_t *snd;
@@ -645,7 +777,7 @@ static boolean ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
 
     if (snd == NULL)
     {
-        return false;
+        return NULL;
     }
 
     chunk = &snd->chunk;
@@ -740,13 +872,16 @@ static boolean ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
 #endif /* #ifdef LOW_PASS_FILTER */
     }
 
-    return true;
+    return snd;
 }
 
-// Load and convert a sound effect
-// Returns true if successful
+// Load the lump of a sound effect and find its sample data and format.
+// Returns true if successful, with the lump locked in memory until
+// released with W_ReleaseLumpNum.
 
-static boolean CacheSFX(sfxinfo_t *sfxinfo)
+static boolean LoadSoundLump(sfxinfo_t *sfxinfo, byte **sample_data,
+                             int *sample_rate, int *sample_bits,
+                             int *sample_length)
 {
     int lumpnum;
     unsigned int lumplen;
@@ -771,18 +906,27 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
         // "fmt " chunk size must == 16
         check = data[16] | (data[17] << 8) | (data[18] << 16) | (data[19] << 24);
         if (check != 16)
+        {
+            W_ReleaseLumpNum(lumpnum);
             return false;
+        }
 
         // Format must == 1 (PCM)
         check = data[20] | (data[21] << 8);
         if (check != 1)
+        {
+            W_ReleaseLumpNum(lumpnum);
             return false;
+        }
 
         // FIXME: can't handle stereo wavs
         // Number of channels must == 1
         check = data[22] | (data[23] << 8);
         if (check != 1)
+        {
+            W_ReleaseLumpNum(lumpnum);
             return false;
+        }
 
         samplerate = data[24] | (data[25] << 8) | (data[26] << 16) | (data[27] << 24);
         length = data[40] | (data[41] << 8) | (data[42] << 16) | (data[43] << 24);
@@ -794,7 +938,10 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
 
         // Reject non 8 or 16 bit
         if (bits != 16 && bits != 8)
+        {
+            W_ReleaseLumpNum(lumpnum);
             return false;
+        }
 
         data += 44 - 8;
     }
@@ -818,6 +965,7 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
 
         if (length > lumplen - 8 || length <= 48)
         {
+            W_ReleaseLumpNum(lumpnum);
             return false;
         }
 
@@ -833,32 +981,59 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
     else
     {
         // Invalid sound
+        W_ReleaseLumpNum(lumpnum);
+        return false;
+    }
+
+    *sample_data = data + 8;
+    *sample_rate = samplerate;
+    *sample_bits = bits;
+    *sample_length = length;
+
+    return true;
+}
+
+// Load and convert a sound effect
+// Returns true if successful
+
+static boolean CacheSFX(sfxinfo_t *sfxinfo)
+{
+    allocated_sound_t *snd;
+    byte *data;
+    int samplerate;
+    int bits;
+    int length;
+
+    if (!LoadSoundLump(sfxinfo, &data, &samplerate, &bits, &length))
+    {
         return false;
     }
 
     // Sample rate conversion
 
-    if (!ExpandSoundData(sfxinfo, data + 8, samplerate, bits, length))
+    snd = ExpandSoundData(sfxinfo, data, samplerate, bits, length);
+
+    // don't need the original lump any more
+
+    W_ReleaseLumpNum(sfxinfo->lumpnum);
+
+    if (snd == NULL)
     {
         return false;
     }
 
+    LinkAllocatedSound(snd);
+
 #ifdef DEBUG_DUMP_WAVS
     {
         char filename[16];
-        allocated_sound_t * snd;
 
         M_snprintf(filename, sizeof(filename), "%s.wav",
                    DEH_String(sfxinfo->name));
-        snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH);
         WriteWAV(filename, snd->chunk.abuf, snd->chunk.alen,mixer_freq);
     }
 #endif
 
-    // don't need the original lump any more
-  
-    W_ReleaseLumpNum(lumpnum);
-
     return true;
 }
 
@@ -884,12 +1059,264 @@ static void GetSfxLumpName(sfxinfo_t *sfx, char *buf, size_t buf_len)
     }
 }
 
+// Precache thread: convert sounds until there are no jobs left.
+
+static int PrecacheThread(void *unused)
+{
+    precache_job_t *job;
+    int i;
+
+    while (!SDL_AtomicGet(&precache_cancel))
+    {
+        i = SDL_AtomicAdd(&precache_next_job, 1);
+
+        if (i >= num_precache_jobs)
+        {
+            break;
+        }
+
+        job = &precache_jobs[i];
+
+        if (job->base != NULL)
+        {
+            job->result = PitchShift(job->base, job->pitch);
+        }
+        else
+        {
+            job->result = ExpandSoundData(job->sfxinfo, job->data,
+                                          job->samplerate, job->bits,
+                                          job->length);
+        }
+
+        SDL_AtomicSet(&job->done, 1);
+    }
+
+    return 0;
+}
+
+static precache_job_t *NewPrecacheJob(sfxinfo_t *sfxinfo)
+{
+    precache_job_t *job;
+
+    if (num_precache_jobs >= precache_jobs_alloced)
+    {
+        precache_jobs_alloced = precache_jobs_alloced > 0 ?
+                                precache_jobs_alloced * 2 : 128;
+        precache_jobs = I_Realloc(precache_jobs,
+                                  precache_jobs_alloced * sizeof(precache_job_t));
+    }
+
+    job = &precache_jobs[num_precache_jobs++];
+    memset(job, 0, sizeof(precache_job_t));
+    job->sfxinfo = sfxinfo;
+    job->pitch = NORM_PITCH;
+
+    return job;
+}
+
+// Queue a sound lump to be expanded to the mixer format.  The job gets
+// its own copy of the samples: the lump can be purged while the job is
+// running, as soon as the sound is played and its lump released.
+
+static boolean AddExpandJob(sfxinfo_t *sfxinfo)
+{
+    precache_job_t *job;
+    byte *data;
+    byte *copy;
+    int samplerate;
+    int bits;
+    int length;
+
+    if (!LoadSoundLump(sfxinfo, &data, &samplerate, &bits, &length))
+    {
+        return false;
+    }
+
+    copy = malloc(length);
+
+    if (copy != NULL)
+    {
+        memcpy(copy, data, length);
+    }
+
+    W_ReleaseLumpNum(sfxinfo->lumpnum);
+
+    if (copy == NULL)
+    {
+        return false;
+    }
+
+    job = NewPrecacheJob(sfxinfo);
+    job->data = copy;
+    job->samplerate = samplerate;
+    job->bits = bits;
+    job->length = length;
+
+    return true;
+}
+
+// Queue a cached sound to be pitch-shifted.  It is locked until the
+// job is collected.
+
+static void AddPitchJob(allocated_sound_t *base, int pitch)
+{
+    precache_job_t *job;
+
+    job = NewPrecacheJob(base->sfxinfo);
+    job->base = base;
+    job->pitch = pitch;
+
+    LockAllocatedSound(base);
+}
+
+static void CollectPrecacheJob(precache_job_t *job)
+{
+    allocated_sound_t *snd = job->result;
+
+    if (snd != NULL)
+    {
+        // The sound may have been needed before it was ready, in which
+        // case it was already made when it was first played.
+
+        if (GetAllocatedSoundBySfxInfoAndPitch(job->sfxinfo, snd->pitch) == NULL)
+        {
+            LinkAllocatedSound(snd);
+            ++sounds_precached;
+        }
+        else
+        {
+            free(snd);
+        }
+    }
+
+    if (job->base != NULL)
+    {
+        UnlockAllocatedSound(job->base);
+    }
+    else
+    {
+        free(job->data);
+        job->data = NULL;
+    }
+
+    job->collected = true;
+    ++precache_jobs_collected;
+}
+
+// Wait for the precache threads to exit, after telling them to stop
+// if cancel is true, and release every job.
+
+static void FinishPrecache(boolean cancel)
+{
+    int i;
+
+    if (cancel)
+    {
+        SDL_AtomicSet(&precache_cancel, 1);
+    }
+
+    for (i = 0; i < num_precache_threads; ++i)
+    {
+        SDL_WaitThread(precache_threads[i], NULL);
+    }
+
+    num_precache_threads = 0;
+
+    // Jobs that were never run have no result and are just released.
+
+    for (i = 0; i < num_precache_jobs; ++i)
+    {
+        if (!precache_jobs[i].collected)
+        {
+            CollectPrecacheJob(&precache_jobs[i]);
+        }
+    }
+
+    num_precache_jobs = 0;
+    precache_jobs_collected = 0;
+    SDL_AtomicSet(&precache_cancel, 0);
+}
+
+// Add the sounds converted so far to the cache.  Once every job is
+// done, the threads are finished with.
+
+static void UpdatePrecache(void)
+{
+    int i;
+
+    if (num_precache_jobs == 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < num_precache_jobs; ++i)
+    {
+        if (!precache_jobs[i].collected && SDL_AtomicGet(&precache_jobs[i].done))
+        {
+            CollectPrecacheJob(&precache_jobs[i]);
+        }
+    }
+
+    if (precache_jobs_collected == num_precache_jobs)
+    {
+        FinishPrecache(false);
+    }
+}
+
+// Start converting the queued sounds in the background.
+
+static void StartPrecache(void)
+{
+    int count;
+
+    if (num_precache_jobs == 0)
+    {
+        return;
+    }
+
+    SDL_AtomicSet(&precache_next_job, 0);
+
+    // Leave one processor for the game itself.
+
+    count = SDL_GetCPUCount() - 1;
+
+    if (count < 1)
+    {
+        count = 1;
+    }
+    else if (count > MAX_PRECACHE_THREADS)
+    {
+        count = MAX_PRECACHE_THREADS;
+    }
+
+    while (num_precache_threads < count)
+    {
+        precache_threads[num_precache_threads] =
+            SDL_CreateThread(PrecacheThread, "Sound precache", NULL);
+
+        if (precache_threads[num_precache_threads] == NULL)
+        {
+            break;
+        }
+
+        ++num_precache_threads;
+    }
+
+    // No threads?  Convert everything now instead.
+
+    if (num_precache_threads == 0)
+    {
+        PrecacheThread(NULL);
+    }
+}
+
 // Preload all the sound effects - stops nasty ingame freezes
 
 static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
 {
     char namebuf[9];
     int i;
+    int total, collected, dots;
     static boolean sounds_pracached = false;  // [JN] Precache sounds only once.
 
     if (sounds_pracached)
@@ -902,24 +1329,51 @@ static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
            "I_SDL_PrecacheSounds: Кэширование звуковых эффектов - ");
 
     printf("[");
+
+    FinishPrecache(true);
+
     for (i=0; i<num_sounds; ++i)
     {
-        
-        if ((i % 6) == 0)
-        {
-            printf(".");
-            fflush(stdout);
-        }
-
         GetSfxLumpName(&sounds[i], namebuf, sizeof(namebuf));
 
         sounds[i].lumpnum = W_CheckNumForName(namebuf);
 
         if (sounds[i].lumpnum != -1)
         {
-            CacheSFX(&sounds[i]);
+            AddExpandJob(&sounds[i]);
         }
     }
+
+    // The sounds are converted by the precache threads; show progress
+    // while waiting for them.
+
+    total = num_precache_jobs;
+    dots = 0;
+
+    StartPrecache();
+
+    for (;;)
+    {
+        UpdatePrecache();
+
+        collected = num_precache_jobs > 0 ? precache_jobs_collected : total;
+
+        while (dots * 6 < collected)
+        {
+            printf(".");
+            ++dots;
+        }
+
+        fflush(stdout);
+
+        if (num_precache_jobs == 0)
+        {
+            break;
+        }
+
+        SDL_Delay(1);
+    }
+
     printf("]");
 
     printf("\n");
@@ -927,6 +1381,72 @@ static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
     sounds_pracached = true;
 }
 
+// Prepare the sounds used in a level in the background: sounds that
+// have dropped out of the cache, and the pitch-shifted variants within
+// pitch_range of normal pitch.
+
+static void I_SDL_PrecacheLevelSounds(sfxinfo_t **sounds, int num_sounds,
+                                      int pitch_range)
+{
+    allocated_sound_t *base;
+    size_t pitch_bytes;
+    boolean full;
+    int i, d, pitch;
+
+    // Forget about anything still left over from the last level.
+
+    FinishPrecache(true);
+
+    for (i = 0; i < num_sounds; ++i)
+    {
+        if (sounds[i]->lumpnum >= 0
+         && GetAllocatedSoundBySfxInfoAndPitch(sounds[i], NORM_PITCH) == NULL)
+        {
+            AddExpandJob(sounds[i]);
+        }
+    }
+
+    // The games pick pitches close to normal most often, so do those
+    // first, until the pitch cache would be full.  Variants of sounds
+    // that are being expanded are left to be made when first played.
+
+    pitch_bytes = 0;
+    full = !snd_pitchshift;
+
+    for (d = 1; d <= pitch_range && !full; ++d)
+    {
+        for (i = 0; i < num_sounds && !full; ++i)
+        {
+            base = GetAllocatedSoundBySfxInfoAndPitch(sounds[i], NORM_PITCH);
+
+            if (base == NULL)
+            {
+                continue;
+            }
+
+            for (pitch = NORM_PITCH - d; pitch <= NORM_PITCH + d; pitch += 2 * d)
+            {
+                if (GetAllocatedSoundBySfxInfoAndPitch(sounds[i], pitch) != NULL)
+                {
+                    continue;
+                }
+
+                pitch_bytes += PitchShiftLength(base->chunk.alen, pitch);
+
+                if (pitch_bytes > PITCH_CACHE_SIZE)
+                {
+                    full = true;
+                    break;
+                }
+
+                AddPitchJob(base, pitch);
+            }
+        }
+    }
+
+    StartPrecache();
+}
+
 // Load a SFX chunk into memory and ensure that it is locked.
 
 static boolean LockSound(sfxinfo_t *sfxinfo)
@@ -934,11 +1454,17 @@ static boolean LockSound(sfxinfo_t *sfxinfo)
     // If the sound isn't loaded, load it now
     if (GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH) == NULL)
     {
+        ++sound_misses;
+
         if (!CacheSFX(sfxinfo))
         {
             return false;
         }
     }
+    else
+    {
+        ++sound_hits;
+    }
 
     LockAllocatedSound(GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH));
 
@@ -1029,19 +1555,28 @@ static int I_SDL_StartSound(sfxinfo_t *sfxinfo, int channel, int vol, int sep, i
 
         if (snd_pitchshift)
         {
+            ++pitch_misses;
+
             newsnd = PitchShift(snd, pitch);
 
             if (newsnd)
             {
+                LinkAllocatedSound(newsnd);
                 LockAllocatedSound(newsnd);
                 UnlockAllocatedSound(snd);
                 snd = newsnd;
             }
         }
     }
-    else
+    else if (pitch != NORM_PITCH)
     {
+        // Use the cached pitch-shifted variant in place of the base
+        // sound locked above.
+
+        ++pitch_hits;
+
         LockAllocatedSound(snd);
+        UnlockAllocatedSound(GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH));
     }
 
     // play sound
@@ -1089,6 +1624,10 @@ static void I_SDL_UpdateSound(void)
 {
     int i;
 
+    // Pick up any sounds converted in the background
+
+    UpdatePrecache();
+
     // Check all channels to see if a sound has finished
 
     for (i=0; i<NUM_CHANNELS; ++i)
@@ -1110,6 +1649,17 @@ static void I_SDL_ShutdownSound(void)
         return;
     }
 
+    FinishPrecache(true);
+
+    if (show_sound_stats)
+    {
+        printf(english_language ?
+               "I_SDL_ShutdownSound: cache %u hits, %u misses; pitch-shifted %u hits, %u misses; %u sounds precached.\n" :
+               "I_SDL_ShutdownSound: кэш %u попаданий, %u промахов; с высотой тона %u попаданий, %u промахов; %u звуков подготовлено заранее.\n",
+               sound_hits, sound_misses, pitch_hits, pitch_misses,
+               sounds_precached);
+    }
+
     Mix_CloseAudio();
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
 
@@ -1148,6 +1698,15 @@ static boolean I_SDL_InitSound(boolean _use_sfx_prefix)
     int i;
 
     use_sfx_prefix = _use_sfx_prefix;
+    sound_thread_id = SDL_ThreadID();
+
+    //!
+    // @category sound
+    //
+    // Show sound effect cache statistics when quitting.
+    //
+
+    show_sound_stats = M_ParmExists("-soundstats");
 
     // No sounds yet
 
@@ -1232,5 +1791,6 @@ sound_module_t sound_sdl_module =
     I_SDL_StopSound,
     I_SDL_SoundIsPlaying,
     I_SDL_PrecacheSounds,
+    I_SDL_PrecacheLevelSounds,
 };
 
@@ -0,0 +1,229 @@
+//
+// Copyright(C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Offline rendering of sound effect and music lumps through the
+//	normal sound and music modules, without an audio device.
+//
+
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "SDL.h"
+#include "SDL_mixer.h"
+
+#include "doomtype.h"
+
+#include "i_sound.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "jn.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "opl.h"
+#include "w_wad.h"
+#include "z_zone.h"
+
+#define NORM_SEP 128
+
+// File the mixed output is written to, or NULL if not rendering.
+
+static char *render_file = NULL;
+
+// Number of sample frames mixed so far.  Updated by the audio thread.
+
+static SDL_atomic_t render_frames;
+static int render_frame_size;
+
+static void CountFrames(int chan, void *stream, int len, void *udata)
+{
+    SDL_AtomicAdd(&render_frames, len / render_frame_size);
+}
+
+//
+// Called by I_InitSound before any sound module opens the mixer.
+//
+
+void I_InitAudioRender(void)
+{
+    int i;
+
+    //!
+    // @arg <file>
+    // @category sound
+    //
+    // Render the lumps given with -renderlumps to <file> as raw PCM
+    // (signed 16-bit stereo at snd_samplerate) as fast as possible,
+    // without using an audio device, then quit.
+    //
+
+    i = M_CheckParmWithArgs("-renderaudio", 1);
+
+    if (i == 0)
+    {
+        return;
+    }
+
+    render_file = myargv[i + 1];
+
+    // SDL's disk audio driver writes the mixed output to a file.  With
+    // no delay between buffers it runs as fast as the mixer allows.
+
+    SDL_setenv("SDL_AUDIODRIVER", "disk", 1);
+    SDL_setenv("SDL_DISKAUDIOFILE", render_file, 1);
+    SDL_setenv("SDL_DISKAUDIODELAY", "0", 1);
+
+    OPL_SetOfflineRender(1);
+}
+
+// Wait until the mixer has played everything that was started.
+
+static void WaitForAudio(boolean music)
+{
+    while (music ? I_MusicIsPlaying() : I_SoundIsPlaying(0))
+    {
+        I_UpdateSound();
+        I_Sleep(1);
+    }
+}
+
+static void RenderMusic(lumpindex_t lumpnum)
+{
+    void *handle;
+
+    handle = I_RegisterSong(W_CacheLumpNum(lumpnum, PU_STATIC),
+                            W_LumpLength(lumpnum));
+
+    if (handle != NULL)
+    {
+        I_PlaySong(handle, false);
+        WaitForAudio(true);
+        I_StopSong();
+        I_UnRegisterSong(handle);
+    }
+
+    W_ReleaseLumpNum(lumpnum);
+}
+
+static void RenderSound(lumpindex_t lumpnum, char *name)
+{
+    sfxinfo_t *sfx;
+
+    // The sound module keeps a pointer to the sfxinfo in its cache,
+    // so it must outlive this function.
+
+    sfx = Z_Malloc(sizeof(sfxinfo_t), PU_STATIC, NULL);
+    memset(sfx, 0, sizeof(sfxinfo_t));
+    M_StringCopy(sfx->name, name, sizeof(sfx->name));
+    sfx->lumpnum = lumpnum;
+    sfx->pitch = -1;
+    sfx->volume = -1;
+
+    if (I_StartSound(sfx, 0, 127, NORM_SEP, NORM_PITCH) >= 0)
+    {
+        WaitForAudio(false);
+    }
+}
+
+//
+// Play the lumps given with -renderlumps one after another and report
+// how fast the output was rendered.  Does nothing unless -renderaudio
+// was given.  Called once the sound system is up; does not return.
+//
+
+void I_RenderAudio(void)
+{
+    int freq, channels;
+    Uint16 format;
+    int p, i;
+    int lumps;
+    int start, elapsed;
+    byte *data;
+    lumpindex_t lumpnum;
+    double seconds;
+
+    if (render_file == NULL)
+    {
+        return;
+    }
+
+    //!
+    // @arg <lump> <lump> ...
+    // @category sound
+    //
+    // Lumps to play when rendering with -renderaudio.  DMX sound
+    // lumps are played as sound effects; anything else (MUS, MIDI
+    // and other music formats) is played once as music.
+    //
+
+    p = M_CheckParm("-renderlumps");
+
+    if (p == 0 || !Mix_QuerySpec(&freq, &format, &channels))
+    {
+        I_QuitWithError(english_language ?
+                        "I_RenderAudio: -renderaudio needs -renderlumps and the SDL sound or music device" :
+                        "I_RenderAudio: для -renderaudio необходимы -renderlumps и звуковое устройство SDL");
+    }
+
+    render_frame_size = (SDL_AUDIO_BITSIZE(format) / 8) * channels;
+    SDL_AtomicSet(&render_frames, 0);
+    Mix_RegisterEffect(MIX_CHANNEL_POST, CountFrames, NULL, NULL);
+
+    lumps = 0;
+    start = I_GetTimeMS();
+
+    for (i = p + 1; i < myargc && myargv[i][0] != '-'; ++i)
+    {
+        lumpnum = W_CheckNumForName(myargv[i]);
+
+        if (lumpnum < 0)
+        {
+            printf(english_language ?
+                   "I_RenderAudio: lump '%s' not found.\n" :
+                   "I_RenderAudio: блок '%s' не найден.\n", myargv[i]);
+            continue;
+        }
+
+        // DMX sound effects start with format number 3.
+
+        data = W_CacheLumpNum(lumpnum, PU_STATIC);
+
+        if (W_LumpLength(lumpnum) > 8 && data[0] == 0x03 && data[1] == 0x00)
+        {
+            W_ReleaseLumpNum(lumpnum);
+            RenderSound(lumpnum, myargv[i]);
+        }
+        else
+        {
+            W_ReleaseLumpNum(lumpnum);
+            RenderMusic(lumpnum);
+        }
+
+        ++lumps;
+    }
+
+    elapsed = I_GetTimeMS() - start;
+    Mix_UnregisterEffect(MIX_CHANNEL_POST, CountFrames);
+
+    seconds = (double) SDL_AtomicGet(&render_frames) / freq;
+
+    printf(english_language ?
+           "I_RenderAudio: %i lumps, %.2f s of audio at %i Hz rendered to '%s' in %.2f s (%.1fx realtime).\n" :
+           "I_RenderAudio: %i блоков, %.2f с звука при %i Гц записано в '%s' за %.2f с (%.1fx от реального времени).\n",
+           lumps, seconds, freq, render_file, elapsed / 1000.0,
+           elapsed > 0 ? seconds * 1000.0 / elapsed : 0.0);
+
+    I_Quit();
+}
@@ -69,6 +69,12 @@ int mute_inactive_window = 0;
 static sound_module_t *sound_module;
 static music_module_t *music_module;
 
+// Sounds collected by I_AddLevelSound for I_PrecacheLevelSounds.
+
+static sfxinfo_t **level_sounds = NULL;
+static int num_level_sounds;
+static int level_sounds_alloced;
+
 int snd_musicdevice = SNDDEVICE_SB;
 int snd_sfxdevice = SNDDEVICE_SB;
 
@@ -225,6 +231,8 @@ void I_InitSound(boolean use_sfx_prefix)
 
     if (!nosound && !screensaver_mode)
     {
+        I_InitAudioRender();
+
 #ifdef _WIN32
         // [Dasperal] Set the recommended SDL audio driver to "directsound" (skip "wasapi")
         // on Windows Vista to avoid sound stutters.
@@ -370,6 +378,57 @@ void I_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
     }
 }
 
+// Adds a sound to the ones I_PrecacheLevelSounds prepares, if it is not
+// there yet.  An alias plays the data of the sound it links to, so its
+// lump is looked up through the link, and the linked sound is added too.
+
+void I_AddLevelSound(sfxinfo_t *sfxinfo)
+{
+    int i;
+
+    for (i = 0; i < num_level_sounds; ++i)
+    {
+        if (level_sounds[i] == sfxinfo)
+        {
+            return;
+        }
+    }
+
+    if (sfxinfo->lumpnum < 0)
+    {
+        sfxinfo->lumpnum = I_GetSfxLumpNum(sfxinfo);
+    }
+
+    if (num_level_sounds == level_sounds_alloced)
+    {
+        level_sounds_alloced = level_sounds_alloced ? level_sounds_alloced * 2 : 64;
+        level_sounds = I_Realloc(level_sounds,
+                                 level_sounds_alloced * sizeof(*level_sounds));
+    }
+
+    level_sounds[num_level_sounds++] = sfxinfo;
+
+    if (sfxinfo->link != NULL)
+    {
+        I_AddLevelSound(sfxinfo->link);
+    }
+}
+
+// Lets the sound module prepare the sounds added with I_AddLevelSound
+// and their pitch-shifted variants within pitch_range of normal pitch,
+// so they are ready when first heard.  The list is emptied for the
+// next level.
+
+void I_PrecacheLevelSounds(int pitch_range)
+{
+    if (sound_module != NULL && sound_module->CacheLevelSounds != NULL)
+    {
+        sound_module->CacheLevelSounds(level_sounds, num_level_sounds, pitch_range);
+    }
+
+    num_level_sounds = 0;
+}
+
 void I_SetMusicVolume(int volume)
 {
     if (music_module != NULL)
@@ -150,6 +150,11 @@ typedef struct
 
     void (*CacheSounds)(sfxinfo_t *sounds, int num_sounds);
 
+    // Called after a level is loaded to prepare the sounds it uses
+    // and their pitch-shifted variants (if necessary)
+
+    void (*CacheLevelSounds)(sfxinfo_t **sounds, int num_sounds, int pitch_range);
+
 } sound_module_t;
 
 void I_InitSound(boolean use_sfx_prefix);
@@ -161,6 +166,8 @@ int I_StartSound(sfxinfo_t *sfxinfo, int channel, int vol, int sep, int pitch);
 void I_StopSound(int channel);
 boolean I_SoundIsPlaying(int channel);
 void I_PrecacheSounds(sfxinfo_t *sounds, int num_sounds);
+void I_AddLevelSound(sfxinfo_t *sfxinfo);
+void I_PrecacheLevelSounds(int pitch_range);
 
 // Interface for music modules
 
@@ -238,6 +245,11 @@ extern int snd_pitchshift;
 
 void I_BindSoundVariables(void);
 
+// Offline rendering of sound and music lumps (-renderaudio).
+
+void I_InitAudioRender(void);
+void I_RenderAudio(void);
+
 // DMX version to emulate for OPL emulation:
 typedef enum {
     opl_doom1_1_666,    // Doom 1 v1.666
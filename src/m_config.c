@@ -536,6 +536,8 @@ static default_t defaults_list[] =
     CONFIG_VARIABLE_INT(vsync),
     CONFIG_VARIABLE_INT(preserve_window_aspect_ratio),
     CONFIG_VARIABLE_INT(uncapped_fps),
+    CONFIG_VARIABLE_INT(render_scale),
+    CONFIG_VARIABLE_INT(dynamic_resolution),
     CONFIG_VARIABLE_INT(show_fps),
     CONFIG_VARIABLE_INT(smoothing),
     CONFIG_VARIABLE_INT(max_fps),
@@ -1356,3 +1358,27 @@ char* M_GetAutoloadDir(void)
     free(prefix);
     return autoload_path;
 }
+
+//
+// Calculate the path to the directory for data that is kept between runs
+// only to speed up startup, such as generated tables.  Creates the directory
+// as necessary.  Returns NULL if there is no writable configuration path.
+//
+
+char* M_GetCacheDir(void)
+{
+    char* prefix;
+    char* cache_path;
+
+    if(!configPath.savePath)
+    {
+        return NULL;
+    }
+
+    prefix = M_DirName(configPath.savePath);
+    M_MakeDirectory(prefix);
+    cache_path = M_StringJoin(prefix, DIR_SEPARATOR_S, "cache", NULL);
+    free(prefix);
+    M_MakeDirectory(cache_path);
+    return cache_path;
+}
@@ -64,3 +64,4 @@ void M_BindFloatVariable(char *name, float *variable);
 void M_BindStringVariable(char *name, char **variable);
 char* M_GetSaveGameDir(void);
 char* M_GetAutoloadDir(void);
+char* M_GetCacheDir(void);
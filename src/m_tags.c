@@ -0,0 +1,157 @@
+//
+// Copyright(C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Index of tagged sectors and lines, by tag.
+//      Replaces scanning every sector or line for a tag each time a
+//      special is activated.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "m_tags.h"
+#include "i_system.h"
+
+
+// Find the group of a tag, or -1.
+
+static int FindGroup(const tagindex_t *index, int tag)
+{
+    int g;
+
+    for (g = index->buckets[tag & index->mask]; g >= 0; g = index->next[g])
+    {
+        if (index->tags[g] == tag)
+        {
+            break;
+        }
+    }
+
+    return g;
+}
+
+void M_BuildTagIndex(tagindex_t *index, int count, tagindex_func_t gettag)
+{
+    int numbuckets;
+    int *groupof, *fill;
+    int i, g, tag;
+
+    free(index->items);
+    memset(index, 0, sizeof(*index));
+
+    // Tags are mostly small numbers given out in order, so the low bits
+    // spread them well enough.
+
+    for (numbuckets = 1; numbuckets < count; numbuckets <<= 1);
+
+    index->mask = numbuckets - 1;
+
+    // All arrays live in one block.  There are at most as many groups
+    // as items.
+
+    index->items = I_Realloc(NULL, (4 * count + 1 + numbuckets) * sizeof(int));
+    index->firsts = index->items + count;
+    index->tags = index->firsts + count + 1;
+    index->next = index->tags + count;
+    index->buckets = index->next + count;
+    memset(index->buckets, -1, numbuckets * sizeof(int));
+
+    groupof = I_Realloc(NULL, (2 * count + 1) * sizeof(int));
+    fill = groupof + count;
+
+    // Count the items of each tag, using firsts for the counts.
+
+    for (i = 0; i < count; i++)
+    {
+        tag = gettag(i);
+
+        if (tag == NOTAG)
+        {
+            groupof[i] = -1;
+            continue;
+        }
+
+        g = FindGroup(index, tag);
+
+        if (g < 0)
+        {
+            g = index->numgroups++;
+            index->tags[g] = tag;
+            index->firsts[g] = 0;
+            index->next[g] = index->buckets[tag & index->mask];
+            index->buckets[tag & index->mask] = g;
+        }
+
+        groupof[i] = g;
+        index->firsts[g]++;
+    }
+
+    // Turn the counts into the start of each group.
+
+    for (g = 0, i = 0; g < index->numgroups; g++)
+    {
+        int n = index->firsts[g];
+
+        index->firsts[g] = i;
+        i += n;
+    }
+
+    index->firsts[g] = i;
+
+    // Fill in the items in ascending order.
+
+    memcpy(fill, index->firsts, index->numgroups * sizeof(int));
+
+    for (i = 0; i < count; i++)
+    {
+        if (groupof[i] >= 0)
+        {
+            index->items[fill[groupof[i]]++] = i;
+        }
+    }
+
+    free(groupof);
+}
+
+int M_NextTagged(const tagindex_t *index, int tag, int start)
+{
+    int g, lo, hi, mid;
+
+    if (index->items == NULL || (g = FindGroup(index, tag)) < 0)
+    {
+        return -1;
+    }
+
+    // Binary search for the first item after start.
+
+    lo = index->firsts[g];
+    hi = index->firsts[g + 1];
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+
+        if (index->items[mid] <= start)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo < index->firsts[g + 1] ? index->items[lo] : -1;
+}
@@ -0,0 +1,50 @@
+//
+// Copyright(C) 2026 agent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Index of tagged sectors and lines, by tag.
+//
+
+
+#pragma once
+
+#include <limits.h>
+
+// Returned by a tagindex_func_t for items that are not indexed.
+#define NOTAG INT_MIN
+
+// Returns the tag of item number i, or NOTAG.
+typedef int (*tagindex_func_t)(int i);
+
+// Item numbers grouped by tag.  Within a group the item numbers are in
+// ascending order, the order a linear search over the items finds them.
+
+typedef struct
+{
+    int *items;         // item numbers of all groups, one group after another
+    int *firsts;        // start of each group in items, plus the end
+    int *tags;          // tag of each group
+    int *next;          // next group in the same hash bucket, or -1
+    int *buckets;       // first group in each hash bucket, or -1
+    int  numgroups;
+    int  mask;          // number of hash buckets minus one
+} tagindex_t;
+
+// Index the tags of items 0 to count-1.  Rebuild the index whenever
+// the tags may have changed, e.g. when a level or a saved game is loaded.
+void M_BuildTagIndex(tagindex_t *index, int count, tagindex_func_t gettag);
+
+// Return the smallest item number greater than start with the given tag,
+// or -1 if there is none.  Iterate with a start of -1, then the last
+// item number returned.
+int M_NextTagged(const tagindex_t *index, int tag, int start);
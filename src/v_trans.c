@@ -16,9 +16,19 @@
 //
 
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "d_name.h"
+#include "i_system.h"
+#include "jn.h"
+#include "m_config.h"
+#include "m_misc.h"
+#include "sha1.h"
 #include "v_trans.h"
+#include "v_video.h"
+#include "z_zone.h"
 
 
 // -----------------------------------------------------------------------------
@@ -730,16 +740,40 @@ static void rgb_to_hsv(vect *rgb, vect *hsv)
 }
 
  
+// -----------------------------------------------------------------------------
+// Nearest palette color lookup.
+//
+// The RGB cube is split into 32x32x32 cells. The first time a cell is
+// looked up, the palette colors that may be nearest to any point in it
+// are found: a color may only win if its distance to the nearest corner
+// of the cell is not larger than the smallest distance any color has to
+// its farthest corner. Lookups then compare only those few colors and
+// give exactly the same result as comparing all 256.
+// -----------------------------------------------------------------------------
+
+#define MIXCELLBITS 3
+#define MIXCELLS    (256 >> MIXCELLBITS)
+
+static byte  mixpalette[256 * 3];
+static const byte *mixpalette_ptr;
+static int   *mixcells;      // offset of cell in mixpool plus one, 0 if not built
+static short *mixpool;       // number of candidates, then their indexes
+static int    mixpool_size;
+static int    mixpool_alloced;
+
 // [crispy] copied over from i_video.c
-int V_GetPaletteIndex(byte *palette, int r, int g, int b)
+static int V_FindPaletteIndex (const byte *palette, const int r, const int g, const int b,
+                               const short *candidates, const int count)
 {
     int best, best_diff, diff;
-    int i;
+    int i, n;
 
     best = 0; best_diff = INT_MAX;
 
-    for (i = 0; i < 256; ++i)
+    for (n = 0; n < count; ++n)
     {
+        i = candidates ? candidates[n] : n;
+
         diff = (r - palette[3 * i + 0]) * (r - palette[3 * i + 0])
              + (g - palette[3 * i + 1]) * (g - palette[3 * i + 1])
              + (b - palette[3 * i + 2]) * (b - palette[3 * i + 2]);
@@ -759,6 +793,182 @@ int V_GetPaletteIndex(byte *palette, int r, int g, int b)
     return best;
 }
 
+static int V_BuildMixCell (const byte *palette, const int cell)
+{
+    int lo[3], hi[3];
+    int mindist[256];
+    int bound = INT_MAX;
+    int i, c, start;
+
+    lo[0] = (cell / (MIXCELLS * MIXCELLS)) << MIXCELLBITS;
+    lo[1] = (cell / MIXCELLS % MIXCELLS) << MIXCELLBITS;
+    lo[2] = (cell % MIXCELLS) << MIXCELLBITS;
+
+    for (c = 0; c < 3; c++)
+    {
+        hi[c] = lo[c] + (1 << MIXCELLBITS) - 1;
+    }
+
+    for (i = 0; i < 256; i++)
+    {
+        int near = 0, far = 0;
+
+        for (c = 0; c < 3; c++)
+        {
+            const int v = palette[3 * i + c];
+            const int dlo = v - lo[c];
+            const int dhi = hi[c] - v;
+            const int d = v < lo[c] ? -dlo : v > hi[c] ? -dhi : 0;
+
+            near += d * d;
+            far += MAX(dlo * dlo, dhi * dhi);
+        }
+
+        mindist[i] = near;
+        bound = MIN(bound, far);
+    }
+
+    if (mixpool_size + 257 > mixpool_alloced)
+    {
+        mixpool_alloced = MAX(mixpool_alloced * 2, 16384);
+        mixpool = I_Realloc(mixpool, mixpool_alloced * sizeof(*mixpool));
+    }
+
+    start = mixpool_size++;
+    mixpool[start] = 0;
+
+    for (i = 0; i < 256; i++)
+    {
+        if (mindist[i] <= bound)
+        {
+            mixpool[mixpool_size++] = i;
+            mixpool[start]++;
+        }
+    }
+
+    mixcells[cell] = start + 1;
+    return start;
+}
+
+int V_GetPaletteIndex(byte *palette, int r, int g, int b)
+{
+    int cell, start;
+
+    if (r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255)
+    {
+        return V_FindPaletteIndex(palette, r, g, b, NULL, 256);
+    }
+
+    // Forget the cells if they were built for another palette.
+    if (palette != mixpalette_ptr || memcmp(palette, mixpalette, sizeof(mixpalette)) != 0)
+    {
+        if (mixcells == NULL)
+        {
+            mixcells = I_Realloc(NULL, MIXCELLS * MIXCELLS * MIXCELLS * sizeof(*mixcells));
+        }
+
+        memcpy(mixpalette, palette, sizeof(mixpalette));
+        memset(mixcells, 0, MIXCELLS * MIXCELLS * MIXCELLS * sizeof(*mixcells));
+        mixpalette_ptr = palette;
+        mixpool_size = 0;
+    }
+
+    cell = ((r >> MIXCELLBITS) * MIXCELLS + (g >> MIXCELLBITS)) * MIXCELLS + (b >> MIXCELLBITS);
+    start = mixcells[cell] ? mixcells[cell] - 1 : V_BuildMixCell(palette, cell);
+
+    return V_FindPaletteIndex(palette, r, g, b, &mixpool[start + 1], mixpool[start]);
+}
+
+// -----------------------------------------------------------------------------
+// V_InitTransTables
+// Generates translucency tables for a modified PLAYPAL palette.
+// transtable90 ... transtable10 mix 90% ... 10% of the foreground color
+// into the background. Generated tables are kept in the cache directory
+// under a name made from the palette's SHA1 hash, so next time the same
+// palette is used they are just read back.
+// -----------------------------------------------------------------------------
+
+#define NUMTRANSTABLES 9
+
+void V_InitTransTables (const byte *playpal)
+{
+    byte **const tables[NUMTRANSTABLES] = {
+        &transtable90, &transtable80, &transtable70, &transtable60, &transtable50,
+        &transtable40, &transtable30, &transtable20, &transtable10
+    };
+    const size_t size = NUMTRANSTABLES * 256 * 256;
+    byte *data = Z_Malloc(size, PU_STATIC, 0);
+    char *cachedir = M_GetCacheDir();
+    char *filename = NULL;
+    boolean cached = false;
+    int i, j, k;
+
+    for (k = 0; k < NUMTRANSTABLES; k++)
+    {
+        *tables[k] = data + k * 256 * 256;
+    }
+
+    if (cachedir != NULL)
+    {
+        sha1_context_t context;
+        sha1_digest_t digest;
+        char name[64];
+        FILE *f;
+
+        SHA1_Init(&context);
+        SHA1_Update(&context, (byte *) playpal, 256 * 3);
+        SHA1_Final(digest, &context);
+
+        M_snprintf(name, sizeof(name), "transtab-%02x%02x%02x%02x%02x%02x%02x%02x.lmp",
+                   digest[0], digest[1], digest[2], digest[3],
+                   digest[4], digest[5], digest[6], digest[7]);
+        filename = M_StringJoin(cachedir, DIR_SEPARATOR_S, name, NULL);
+        free(cachedir);
+
+        f = M_fopen(filename, "rb");
+
+        if (f != NULL)
+        {
+            cached = M_FileLength(f) == size && fread(data, 1, size, f) == size;
+            fclose(f);
+        }
+    }
+
+    if (!cached)
+    {
+        // [crispy] background color
+        for (i = 0; i < 256; i++)
+        {
+            const byte *bg = playpal + 3 * i;
+
+            // [crispy] foreground color
+            for (j = 0; j < 256; j++)
+            {
+                const byte *fg = playpal + 3 * j;
+
+                for (k = 0; k < NUMTRANSTABLES; k++)
+                {
+                    const int alpha = 90 - 10 * k;
+
+                    // [crispy] shortcut: identical foreground and background
+                    (*tables[k])[i * 256 + j] = i == j ? i :
+                        V_GetPaletteIndex((byte *) playpal,
+                                          (alpha * fg[0] + (100 - alpha) * bg[0]) / 100,
+                                          (alpha * fg[1] + (100 - alpha) * bg[1]) / 100,
+                                          (alpha * fg[2] + (100 - alpha) * bg[2]) / 100);
+                }
+            }
+        }
+
+        if (filename != NULL)
+        {
+            M_WriteFile(filename, data, size);
+        }
+    }
+
+    free(filename);
+}
+
 byte V_Colorize (byte *playpal, Translation_CR_t cr, byte source, boolean keepgray109)
 {
     vect rgb, hsv;
@@ -114,4 +114,5 @@ extern char **crstr;
 #define cr_esc '~'
 
 int V_GetPaletteIndex(byte *palette, int r, int g, int b);
+void V_InitTransTables (const byte *playpal);
 byte V_Colorize (byte *playpal, Translation_CR_t cr, byte source, boolean keepgray109);
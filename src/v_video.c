@@ -187,6 +187,341 @@ void V_SetPatchClipCallback(vpatchclipfunc_t func)
     patchclip_callback = func;
 }
 
+// -----------------------------------------------------------------------------
+// Pre-scaled patch cache.
+//
+// V_DrawPatch draws the same status bar, menu and intermission graphics
+// every frame. Instead of walking column posts and repeating every pixel
+// (1 << hires) times on each draw, patches are converted once into rows
+// of opaque spans, already widened to the current resolution. Drawing
+// then copies whole spans and duplicates finished screen lines.
+//
+// Entries are found by patch address and remember the lump the patch
+// was loaded from. An entry is only used while that lump's data is
+// still at the same address, so a purged lump reloaded elsewhere, or
+// another lump loaded in its place, gets a new entry. Entries live
+// outside the zone: building one never purges the patch being drawn.
+// When the cache is full, the least recently drawn entries are freed.
+// -----------------------------------------------------------------------------
+
+#define PATCHCACHE_BUCKETS 256
+#define PATCHCACHE_MAXENTRIES 1024
+#define PATCHCACHE_MAXSIZE (16 * 1024 * 1024)
+
+typedef struct
+{
+    short x;        // first column of span, in patch pixels
+    short width;    // span width, in patch pixels
+    int   ofs;      // offset of widened pixels in span data
+} patchspan_t;
+
+typedef struct patchcache_s
+{
+    const patch_t *patch;
+    lumpindex_t lump;   // lump the patch was loaded from, or -1
+    byte *data;         // row table, spans and pixels
+    int size;           // size of data
+    int height;         // rows, including posts reaching below patch height
+    int *rows;          // span index for each row, and one past the last
+    patchspan_t *spans;
+    byte *pixels;
+    struct patchcache_s *next;      // next in bucket
+    struct patchcache_s *newer;     // drawn more recently
+    struct patchcache_s *older;     // drawn less recently
+} patchcache_t;
+
+static patchcache_t *patchcache[PATCHCACHE_BUCKETS];
+static patchcache_t *patchcache_newest;
+static patchcache_t *patchcache_oldest;
+static int patchcache_entries;
+static int patchcache_size;
+
+// Patch pixels and opacity at patch resolution, used while building.
+static byte *patchcache_pixels;
+static byte *patchcache_opaque;
+static int patchcache_buffersize;
+
+static int V_PatchCacheBucket (const patch_t *patch)
+{
+    return ((uintptr_t) patch >> 4) % PATCHCACHE_BUCKETS;
+}
+
+// Where the data of a lump currently is, or NULL if not loaded.
+static const void *V_LumpData (const lumpindex_t lump)
+{
+    const lumpinfo_t *info = lumpinfo[lump];
+
+    if (info->wad_file->mapped != NULL)
+    {
+        return info->wad_file->mapped + info->position;
+    }
+
+    return info->cache;
+}
+
+static lumpindex_t V_PatchLump (const patch_t *patch)
+{
+    lumpindex_t i;
+
+    for (i = 0 ; i < (lumpindex_t) numlumps ; i++)
+    {
+        if (V_LumpData(i) == patch)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void V_UnlinkPatchCache (patchcache_t *entry)
+{
+    if (entry->newer != NULL)
+    {
+        entry->newer->older = entry->older;
+    }
+    else
+    {
+        patchcache_newest = entry->older;
+    }
+
+    if (entry->older != NULL)
+    {
+        entry->older->newer = entry->newer;
+    }
+    else
+    {
+        patchcache_oldest = entry->newer;
+    }
+}
+
+static void V_LinkPatchCache (patchcache_t *entry)
+{
+    entry->newer = NULL;
+    entry->older = patchcache_newest;
+
+    if (patchcache_newest != NULL)
+    {
+        patchcache_newest->newer = entry;
+    }
+    else
+    {
+        patchcache_oldest = entry;
+    }
+
+    patchcache_newest = entry;
+}
+
+static void V_FreePatchCache (patchcache_t *entry)
+{
+    patchcache_t **link = &patchcache[V_PatchCacheBucket(entry->patch)];
+
+    while (*link != entry)
+    {
+        link = &(*link)->next;
+    }
+
+    *link = entry->next;
+    V_UnlinkPatchCache(entry);
+
+    patchcache_entries--;
+    patchcache_size -= entry->size;
+
+    free(entry->data);
+    free(entry);
+}
+
+static void V_FlushPatchCache (void)
+{
+    while (patchcache_oldest != NULL)
+    {
+        V_FreePatchCache(patchcache_oldest);
+    }
+}
+
+static int V_PatchHeight (const patch_t *patch)
+{
+    int col;
+    int height = SHORT(patch->height);
+    const column_t *column;
+
+    for (col = 0 ; col < SHORT(patch->width) ; col++)
+    {
+        column = (const column_t *)((const byte *)patch + LONG(patch->columnofs[col]));
+
+        while (column->topdelta != 0xff)
+        {
+            if (column->topdelta + column->length > height)
+            {
+                height = column->topdelta + column->length;
+            }
+
+            column = (const column_t *)((const byte *)column + column->length + 4);
+        }
+    }
+
+    return height;
+}
+
+static void V_BuildPatchCache (patchcache_t *entry)
+{
+    const patch_t *patch = entry->patch;
+    const int width = SHORT(patch->width);
+    const int scale = 1 << hires;
+    int col, x, y, i;
+    int height, numspans, numpixels;
+    int spansofs, pixelsofs;
+    const column_t *column;
+    const byte *pix, *opaque;
+    patchspan_t *span;
+    byte *dest;
+
+    height = V_PatchHeight(patch);
+    entry->height = height;
+
+    // Draw posts at patch resolution. Later posts cover earlier
+    // ones, just as when drawing them straight to the screen.
+    if (width * height > patchcache_buffersize)
+    {
+        patchcache_buffersize = width * height;
+        patchcache_pixels = I_Realloc(patchcache_pixels, patchcache_buffersize);
+        patchcache_opaque = I_Realloc(patchcache_opaque, patchcache_buffersize);
+    }
+
+    memset(patchcache_opaque, 0, width * height);
+
+    for (col = 0 ; col < width ; col++)
+    {
+        column = (const column_t *)((const byte *)patch + LONG(patch->columnofs[col]));
+
+        while (column->topdelta != 0xff)
+        {
+            const byte *source = (const byte *)column + 3;
+
+            for (i = 0 ; i < column->length ; i++)
+            {
+                patchcache_pixels[(column->topdelta + i) * width + col] = source[i];
+                patchcache_opaque[(column->topdelta + i) * width + col] = 1;
+            }
+
+            column = (const column_t *)((const byte *)column + column->length + 4);
+        }
+    }
+
+    numspans = 0;
+    numpixels = 0;
+
+    for (i = 0 ; i < width * height ; i++)
+    {
+        if (patchcache_opaque[i])
+        {
+            numpixels++;
+
+            if (i % width == 0 || !patchcache_opaque[i - 1])
+            {
+                numspans++;
+            }
+        }
+    }
+
+    spansofs = ((height + 1) * sizeof(int) + 7) & ~7;
+    pixelsofs = spansofs + numspans * sizeof(patchspan_t);
+
+    patchcache_size -= entry->size;
+    entry->size = pixelsofs + numpixels * scale;
+    entry->data = I_Realloc(entry->data, entry->size);
+    patchcache_size += entry->size;
+
+    entry->rows = (int *)entry->data;
+    entry->spans = (patchspan_t *)(entry->data + spansofs);
+    entry->pixels = entry->data + pixelsofs;
+
+    span = entry->spans;
+    dest = entry->pixels;
+
+    for (y = 0 ; y < height ; y++)
+    {
+        pix = patchcache_pixels + y * width;
+        opaque = patchcache_opaque + y * width;
+
+        entry->rows[y] = span - entry->spans;
+
+        for (x = 0 ; x < width ; )
+        {
+            if (!opaque[x])
+            {
+                x++;
+                continue;
+            }
+
+            span->x = x;
+            span->ofs = dest - entry->pixels;
+
+            for ( ; x < width && opaque[x] ; x++)
+            {
+                memset(dest, pix[x], scale);
+                dest += scale;
+            }
+
+            span->width = x - span->x;
+            span++;
+        }
+    }
+
+    entry->rows[height] = span - entry->spans;
+}
+
+static const patchcache_t *V_GetPatchCache (const patch_t *patch)
+{
+    const int bucket = V_PatchCacheBucket(patch);
+    patchcache_t *entry;
+
+    for (entry = patchcache[bucket] ; entry != NULL ; entry = entry->next)
+    {
+        if (entry->patch == patch)
+        {
+            break;
+        }
+    }
+
+    if (entry == NULL)
+    {
+        entry = I_Realloc(NULL, sizeof(*entry));
+        entry->patch = patch;
+        entry->lump = V_PatchLump(patch);
+        entry->data = NULL;
+        entry->size = 0;
+        entry->next = patchcache[bucket];
+        patchcache[bucket] = entry;
+        V_LinkPatchCache(entry);
+        patchcache_entries++;
+        V_BuildPatchCache(entry);
+    }
+    else if (entry->lump < 0 || entry->lump >= (lumpindex_t) numlumps
+         ||  V_LumpData(entry->lump) != patch)
+    {
+        // Lump was purged and something else loaded here, or the
+        // patch does not come from a lump and may have changed.
+        entry->lump = V_PatchLump(patch);
+        V_BuildPatchCache(entry);
+    }
+
+    if (entry != patchcache_newest)
+    {
+        V_UnlinkPatchCache(entry);
+        V_LinkPatchCache(entry);
+    }
+
+    while (patchcache_oldest != entry
+       && (patchcache_entries > PATCHCACHE_MAXENTRIES
+       ||  patchcache_size > PATCHCACHE_MAXSIZE))
+    {
+        V_FreePatchCache(patchcache_oldest);
+    }
+
+    return entry;
+}
+
 // -----------------------------------------------------------------------------
 // V_DrawPatch
 // Masks a column based masked pic to the screen. 
@@ -194,12 +529,12 @@ void V_SetPatchClipCallback(vpatchclipfunc_t func)
 
 void V_DrawPatch (int x, int y, const patch_t *patch, const byte *table)
 { 
-    int col, count;
-    column_t *column;
-    byte *dest1, *desttop1; // Middle resolution
-    byte *dest2, *desttop2; // High resolution
-    byte *source, *sourcetrans;
-    int w, f;
+    const patchcache_t *entry;
+    const patchspan_t *span, *spanend;
+    const int scale = 1 << hires;
+    int row, rowend, left, right, count, line;
+    byte *dest;
+    const byte *source;
 
     y -= SHORT(patch->topoffset);
     x -= SHORT(patch->leftoffset);
@@ -215,119 +550,72 @@ void V_DrawPatch (int x, int y, const patch_t *patch, const byte *table)
 
     V_MarkRect(x, y, SHORT(patch->width), SHORT(patch->height));
 
-    col = 0;
-    desttop1 = dest_screen + (y << hires) * screenwidth + x;
-    desttop2 = dest_screen + ((y << hires) + quadres) * screenwidth + x;
+    entry = V_GetPatchCache(patch);
 
-    w = SHORT(patch->width);
+    // [crispy] prevent framebuffer overflows
+    row = y < 0 ? -y : 0;
+    rowend = ORIGHEIGHT - y < entry->height ? ORIGHEIGHT - y : entry->height;
 
-    for ( ; col<w ; x++, col++, desttop1++, desttop2++)
+    for ( ; row < rowend ; row++)
     {
-        column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
+        span = entry->spans + entry->rows[row];
+        spanend = entry->spans + entry->rows[row + 1];
 
-        // step through the posts in a column
-        while (column->topdelta != 0xff)
+        for ( ; span < spanend ; span++)
         {
-            for (f = 0; f <= (hires + quadres); f++)
-            {
-            const int column_post = column->topdelta * (screenwidth << hires) + (x * (hires + quadres)) + f;
+            left = x + span->x;
+            right = left + span->width;
 
-            source = sourcetrans = (byte *)column + 3;
-            dest1 = desttop1 + column_post;
-            dest2 = desttop2 + column_post;
-            count = column->length;
-
-            // [crispy] prevent framebuffer overflows
+            if (left < 0)
             {
-                int tmpy = y + column->topdelta;
-
-                // [crispy] too far left
-                if (x < 0)
-                {
-                    continue;
-                }
+                left = 0;
+            }
+            if (right > origwidth)
+            {
+                right = origwidth;
+            }
+            if (left >= right)
+            {
+                continue;
+            }
 
-                // [crispy] too far right / width
-                if (x >= origwidth)
-                {
-                    break;
-                }
+            source = entry->pixels + span->ofs + (left - x - span->x) * scale;
+            dest = dest_screen + (y + row) * scale * screenwidth + left * scale;
+            count = (right - left) * scale;
 
-                // [crispy] too high
-                while (tmpy < 0)
+            // [JN] If given table is a NULL, draw opaque patch:
+            // fill first line, then copy it to the rest.
+            if (table == NULL)
+            {
+                if (dp_translation)
                 {
-                    count--;
-                    source++;
-                    sourcetrans++; // [Dasperal] Increment sourcetrans as well in case dp_translation is NULL
-                    dest1 += (screenwidth << hires);
-                    if (quadres)
-                    dest2 += (screenwidth << hires);
-                    tmpy++;
+                    for (int i = 0 ; i < count ; i++)
+                    {
+                        dest[i] = dp_translation[source[i]];
+                    }
                 }
-
-                // [crispy] too low / height
-                while (tmpy + count > ORIGHEIGHT)
+                else
                 {
-                    count--;
+                    memcpy(dest, source, count);
                 }
 
-                // [crispy] nothing left to draw?
-                if (count < 1)
+                for (line = 1 ; line < scale ; line++)
                 {
-                    continue;
+                    memcpy(dest + line * screenwidth, dest, count);
                 }
             }
-
-            while (count--)
+            else
             {
-                if (dp_translation)
-                sourcetrans = &dp_translation[*source++];
-
-                // [JN] If given table is a NULL, draw opaque patch.
-                if (table != NULL)
-                {
-                    if (quadres)
-                    {
-                        *dest2 = *dest1 = table[((*dest1) << 8) + *sourcetrans];
-                        dest1 += fullscreenwidth;
-                        dest2 += fullscreenwidth;
-
-                        *dest2 = *dest1 = table[((*dest1) << 8) + *sourcetrans++];
-                        dest1 += fullscreenwidth;
-                        dest2 += fullscreenwidth;
-                    }
-                    else
-                    {
-                        *dest1 = table[((*dest1) << 8) + *sourcetrans];
-                        dest1 += fullscreenwidth;
-                        *dest1 = table[((*dest1) << 8) + *sourcetrans++];
-                        dest1 += fullscreenwidth;
-                    }
-                }
-                else
+                for (line = 0 ; line < scale ; line++, dest += screenwidth)
                 {
-                    if (quadres)
+                    for (int i = 0 ; i < count ; i++)
                     {
-                        *dest2 = *dest1 = *sourcetrans;
-                        dest1 += fullscreenwidth;
-                        dest2 += fullscreenwidth;
+                        const byte c = dp_translation ? dp_translation[source[i]] : source[i];
 
-                        *dest2 = *dest1 = *sourcetrans++;
-                        dest1 += fullscreenwidth;
-                        dest2 += fullscreenwidth;
-                    }
-                    else
-                    {
-                        *dest1 = *sourcetrans;
-                        dest1 += fullscreenwidth;
-                        
-                        *dest1 = *sourcetrans++;
-                        dest1 += fullscreenwidth;
+                        dest[i] = table[(dest[i] << 8) + c];
                     }
                 }
             }
-            }
-            column = (column_t *)((byte *)column + column->length + 4);
         }
     }
 }
@@ -1585,6 +1873,45 @@ void V_DrawPatchFinale (int x, int y, const patch_t *patch)
     }
 }
 
+// -----------------------------------------------------------------------------
+// V_ScaleLine
+// Widens a line of pixels by repeating each one scale times. The 2x and 4x
+// cases store each widened pixel at once, which compilers turn into wide
+// vector stores.
+// -----------------------------------------------------------------------------
+
+static void V_ScaleLine (byte *__restrict dest, const byte *__restrict src,
+                         const int width, const int scale)
+{
+    int i;
+
+    if (scale == 2)
+    {
+        for (i = 0; i < width; i++)
+        {
+            const uint16_t pixels = src[i] * 0x0101u;
+
+            memcpy(dest + i * 2, &pixels, 2);
+        }
+    }
+    else if (scale == 4)
+    {
+        for (i = 0; i < width; i++)
+        {
+            const uint32_t pixels = src[i] * 0x01010101u;
+
+            memcpy(dest + i * 4, &pixels, 4);
+        }
+    }
+    else
+    {
+        for (i = 0; i < width; i++)
+        {
+            memset(dest + i * scale, src[i], scale);
+        }
+    }
+}
+
 // -----------------------------------------------------------------------------
 // [JN] V_FillFlat
 // Fills background with given flat, with support for high/low detail mode.
@@ -1592,18 +1919,36 @@ void V_DrawPatchFinale (int x, int y, const patch_t *patch)
 
 void V_FillFlat (char *lump)
 {
-    int x, y;
+    int x, y, line;
     const int shift_allowed = vanillaparm ? 1 : hud_detaillevel;
-    byte *src = W_CacheLumpName (DEH_String(lump), PU_CACHE);
+    const int tile = MIN(64 << shift_allowed, screenwidth);
+    const byte *src = W_CacheLumpName (DEH_String(lump), PU_CACHE);
     byte *dest = I_VideoBuffer;
 
-    for (y = 0; y < SCREENHEIGHT; y++)
+    for (y = 0; y < SCREENHEIGHT; y = line)
     {
-        for (x = 0; x < screenwidth; x++)
+        const byte *row = src + (((y >> shift_allowed) & 63) << 6);
+
+        // Draw one flat width, then repeat it across the line
+        // with copies of what is already drawn.
+        for (x = 0; x < tile; x++)
+        {
+            dest[x] = row[(x >> shift_allowed) & 63];
+        }
+        for ( ; x < screenwidth; x += x)
         {
-            *dest++ = src[(((y >> shift_allowed) & 63) << 6) 
-                         + ((x >> shift_allowed) & 63)];
+            memcpy(dest + x, dest, MIN(x, screenwidth - x));
         }
+
+        // Lines of the same flat row are identical.
+        for (line = y + 1; line < SCREENHEIGHT
+                        && (line >> shift_allowed) == (y >> shift_allowed); line++)
+        {
+            memcpy(dest + screenwidth, dest, screenwidth);
+            dest += screenwidth;
+        }
+
+        dest += screenwidth;
     }
 }
 
@@ -1677,12 +2022,16 @@ void V_DrawScaledBlock (const int x, const int y, int width, int height, const b
 
     dest = dest_screen + (y << hires) * screenwidth + (x << hires);
 
-    for (i = 0; i < (height << hires); i++)
+    for (i = 0; i < height; i++, src += width)
     {
-        for (j = 0; j < (width << hires); j++)
+        V_ScaleLine(dest, src, width, 1 << hires);
+
+        for (j = 1; j < (1 << hires); j++)
         {
-            *(dest + i * screenwidth + j) = *(src + (i >> hires) * width + (j >> hires));
+            memcpy(dest + j * screenwidth, dest, width << hires);
         }
+
+        dest += screenwidth << hires;
     }
 }
 
@@ -1752,31 +2101,23 @@ void V_CopyScaledBuffer(byte* __restrict dest, const byte* __restrict src, const
     const int16_t rect_width = src_width > origwidth ? origwidth : src_width;
     const int16_t src_x_offset = (src_width - rect_width) / 2;
     const int16_t dest_x_offset = (screenwidth - (rect_width << hires)) / 2;
-    const int8_t dup_boundary = hires | 1;
+    const int8_t scale = 1 << hires;
+
+    dest += dest_x_offset;
+    src += src_x_offset;
 
-    int dest_line = 0;
     for(int16_t src_line = 0; src_line < ORIGHEIGHT; src_line++)
     {
-        const int32_t src_line_offset = src_line * src_width;
+        // Widen the source line once, then copy it to the duplicate lines.
+        V_ScaleLine(dest, src, rect_width, scale);
 
-        for(int8_t line_dup = 0; line_dup <= dup_boundary; line_dup++)
+        for(int8_t line_dup = 1; line_dup < scale; line_dup++)
         {
-            const int32_t dest_line_offset = dest_line * screenwidth;
-
-            int dest_col = 0;
-            for(int16_t src_col = 0; src_col < rect_width; src_col++)
-            {
-                const int16_t src_coll_offset = src_x_offset + src_col;
-
-                for(int8_t col_dup = 0; col_dup <= dup_boundary; col_dup++)
-                {
-                    *(dest + dest_line_offset + dest_x_offset + dest_col) =
-                        *(src + src_line_offset + src_coll_offset);
-                    dest_col++;
-                }
-            }
-            dest_line++;
+            memcpy(dest + line_dup * screenwidth, dest, rect_width * scale);
         }
+
+        dest += scale * screenwidth;
+        src += src_width;
     }
 }
 
@@ -1868,6 +2209,9 @@ void V_Init (void)
     }
 
     fullscreenwidth = screenwidth * hires;
+
+    // Cached patches are widened for the old resolution.
+    V_FlushPatchCache();
 }
 
 // Set the buffer that the code draws to.